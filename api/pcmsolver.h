@@ -187,6 +187,37 @@ PCMSOLVER_API void pcmsolver_compute_response_asc(pcmsolver_context_t * context,
                                                  const char * asc_name,
                                                  int irrep);
 
+/*! \brief Computes ASCs given a batch of MEPs and the desired irreducible representation
+ *  \param[in, out] context the PCM context object
+ *  \param[in] nr_meps number of MEPs in the batch
+ *  \param[in] meps the MEPs, stored column-major as a cavity size x nr_meps matrix
+ *  \param[out] ascs the ASCs, stored column-major as a cavity size x nr_meps matrix
+ *  \param[in] irrep index of the desired irreducible representation
+ *  All the ASCs are obtained by a single matrix-matrix product.
+ *  The MEPs and ASCs are not stored as surface functions.
+ */
+PCMSOLVER_API void pcmsolver_compute_ascs(pcmsolver_context_t * context,
+                                         size_t nr_meps,
+                                         const double meps[],
+                                         double ascs[],
+                                         int irrep);
+
+/*! \brief Computes response ASCs given a batch of MEPs and the desired irreducible representation
+ *  \param[in, out] context the PCM context object
+ *  \param[in] nr_meps number of MEPs in the batch
+ *  \param[in] meps the MEPs, stored column-major as a cavity size x nr_meps matrix
+ *  \param[out] ascs the ASCs, stored column-major as a cavity size x nr_meps matrix
+ *  \param[in] irrep index of the desired irreducible representation
+ *  If `Nonequilibrium = True` in the input, calculates response
+ *  ASCs using the dynamic permittivity. Falls back to the solver with static permittivity
+ *  otherwise.
+ */
+PCMSOLVER_API void pcmsolver_compute_response_ascs(pcmsolver_context_t * context,
+                                                  size_t nr_meps,
+                                                  const double meps[],
+                                                  double ascs[],
+                                                  int irrep);
+
 /*! \brief Computes the polarization energy
  *  \param[in, out] context the PCM context object
  *  \param[in] mep_name label of the MEP surface function
@@ -198,6 +229,85 @@ PCMSOLVER_API double pcmsolver_compute_polarization_energy(pcmsolver_context_t *
                                              const char * mep_name,
                                              const char * asc_name);
 
+/*! \brief Registers a buffer owned by the host program
+ *  \param[in, out] context the PCM context object
+ *  \param[in] size the size of the buffer, has to be equal to the size of the cavity
+ *  \param[in] values the buffer
+ *  \return the handle to the buffer
+ *  The buffer is neither copied nor released by the module and has to outlive
+ *  the PCM context object. MEPs and ASCs in registered buffers are accessed by
+ *  handle, without copies and without lookups by label.
+ */
+PCMSOLVER_API int pcmsolver_register_buffer(pcmsolver_context_t * context,
+                                            size_t size,
+                                            double values[]);
+
+/*! \brief Computes ASC given a MEP and the desired irreducible representation, using registered buffers
+ *  \param[in, out] context the PCM context object
+ *  \param[in] mep_handle handle to the buffer holding the MEP
+ *  \param[in] asc_handle handle to the buffer where the ASC is written
+ *  \param[in] irrep index of the desired irreducible representation
+ */
+PCMSOLVER_API void pcmsolver_compute_asc_buffers(pcmsolver_context_t * context,
+                                                int mep_handle,
+                                                int asc_handle,
+                                                int irrep);
+
+/*! \brief Computes response ASC given a MEP and the desired irreducible representation, using registered buffers
+ *  \param[in, out] context the PCM context object
+ *  \param[in] mep_handle handle to the buffer holding the MEP
+ *  \param[in] asc_handle handle to the buffer where the ASC is written
+ *  \param[in] irrep index of the desired irreducible representation
+ *  If `Nonequilibrium = True` in the input, calculates a response
+ *  ASC using the dynamic permittivity. Falls back to the solver with static permittivity
+ *  otherwise.
+ */
+PCMSOLVER_API void pcmsolver_compute_response_asc_buffers(pcmsolver_context_t * context,
+                                                         int mep_handle,
+                                                         int asc_handle,
+                                                         int irrep);
+
+/*! \brief Computes the polarization energy, using registered buffers
+ *  \param[in, out] context the PCM context object
+ *  \param[in] mep_handle handle to the buffer holding the MEP
+ *  \param[in] asc_handle handle to the buffer holding the ASC
+ *  \return the polarization energy
+ */
+PCMSOLVER_API double pcmsolver_compute_polarization_energy_buffers(pcmsolver_context_t * context,
+                                                                   int mep_handle,
+                                                                   int asc_handle);
+
+/*! \brief Updates the molecular geometry
+ *  \param[in, out] context the PCM context object
+ *  \param[in] nr_nuclei     number of atoms in the molecule
+ *  \param[in] charges       atomic charges
+ *  \param[in] coordinates   atomic coordinates
+ *
+ *  The cavity and the solvers are built anew for the new geometry, keeping
+ *  the input and the molecular point group of the context.
+ *  With `IncrementalUpdate = True`, the operators inside the cavity are
+ *  updated from those of the previous geometry.
+ *  The surface functions and the registered buffers refer to the previous
+ *  cavity and are discarded.
+ *  The geometry cannot be updated when the spheres are given explicitly.
+ */
+PCMSOLVER_API void pcmsolver_update_geometry(pcmsolver_context_t * context,
+                                             int nr_nuclei,
+                                             double charges[],
+                                             double coordinates[]);
+
+/*! \brief Updates the static permittivity outside the cavity
+ *  \param[in, out] context the PCM context object
+ *  \param[in] epsilon the new static permittivity
+ *  The boundary integral operators are not recomputed.
+ *  Only the static solver is updated, the response ASC is still computed with
+ *  the dynamic permittivity, when available.
+ *  Only isotropic environments can be updated. The IEFPCM solver
+ *  needs `PermittivityUpdate = True` in the input.
+ */
+PCMSOLVER_API void pcmsolver_update_permittivity(pcmsolver_context_t * context,
+                                                 double epsilon);
+
 /*! \brief Retrieves data wrapped in a given surface function
  *  \param[in, out] context the PCM context object
  *  \param[in] size the size of the surface function
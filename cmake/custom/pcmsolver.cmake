@@ -2,6 +2,7 @@ option(ENABLE_LOGGER "Enable logger" OFF)
 option(ENABLE_TIMER "Enable timer" ON)
 option(BUILD_STANDALONE "Enable build of standalone executables" ON)
 option(ENABLE_FORTRAN_API "Builds optional Fortran90 API" OFF)
+option(ENABLE_VECTORIZATION "Enable the SIMD instruction set of the host architecture" OFF)
 
 # Add definitions
 if(ENABLE_TIMER)
@@ -10,6 +11,24 @@ endif()
 if(ENABLE_LOGGER)
   add_definitions(-DENABLE_LOGGER)
 endif()
+# autocmake_omp only sets the Fortran flags when a Fortran compiler is enabled,
+# the C++ assembly of the boundary integral operators needs the C/C++ flags too
+if(ENABLE_OPENMP AND NOT OpenMP_CXX_FLAGS)
+  find_package(OpenMP)
+  if(OPENMP_FOUND)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${OpenMP_C_FLAGS}")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
+  endif()
+endif()
+
+# Eigen picks the widest SIMD packets (SSE, AVX, AVX-512) the compiler targets
+if(ENABLE_VECTORIZATION)
+  include(CheckCXXCompilerFlag)
+  check_cxx_compiler_flag("-march=native" HAS_MARCH_NATIVE)
+  if(HAS_MARCH_NATIVE)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -march=native")
+  endif()
+endif()
 
 # This can be set by the host project
 # and tweaks the location of the submodules install location
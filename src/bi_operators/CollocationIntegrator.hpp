@@ -62,71 +62,77 @@ struct CollocationIntegrator
 {
     CollocationIntegrator() : factor_(1.07) {}
     ~CollocationIntegrator() {}
+    /*! The diagonal elements of D depend on their finite element only */
+    static const bool sumRuleDiagonal = false;
+    /*! Returns the parameter of the integration of the diagonal elements, the scaling factor */
+    double parameter() const { return factor_; }
 
-    /**@{ Single and double layer potentials for a Vacuum Green's function by collocation */
+    /**@{ Single and double layer potentials for a Vacuum Green's function by collocation
+     *  The off-diagonal elements are the analytic Coulomb kernels, evaluated in batches
+     */
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, CollocationIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::singleLayer(e,
-                pcm::bind(integrator::SI, this->factor_, 1.0, pcm::_1),
-                pcm::bind(&Vacuum<DerivativeTraits, CollocationIntegrator>::kernelS, gf, pcm::_1, pcm::_2));
+    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::singleLayerCoulomb(e,
+                pcm::bind(integrator::SI, this->factor_, 1.0, pcm::_1), 1.0, nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, CollocationIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::doubleLayer(e,
-                                       pcm::bind(integrator::DI, this->factor_, pcm::_1),
-                                       pcm::bind(&Vacuum<DerivativeTraits, CollocationIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3));
+    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::doubleLayerCoulomb(e, pcm::bind(integrator::DI, this->factor_, pcm::_1), nRows);
     }
     /**@}*/
 
-    /**@{ Single and double layer potentials for a UniformDielectric Green's function by collocation */
+    /**@{ Single and double layer potentials for a UniformDielectric Green's function by collocation
+     *  The off-diagonal elements are the analytic Coulomb kernels, evaluated in batches
+     */
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, CollocationIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::singleLayer(e,
-                pcm::bind(integrator::SI, this->factor_, gf.epsilon(), pcm::_1),
-                pcm::bind(&UniformDielectric<DerivativeTraits, CollocationIntegrator>::kernelS, gf, pcm::_1, pcm::_2));
+    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, CollocationIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::singleLayerCoulomb(e,
+                pcm::bind(integrator::SI, this->factor_, gf.epsilon(), pcm::_1), gf.epsilon(), nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, CollocationIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::doubleLayer(e,
-                                       pcm::bind(integrator::DI, this->factor_, pcm::_1),
-                                       pcm::bind(&UniformDielectric<DerivativeTraits, CollocationIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3));
+    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::doubleLayerCoulomb(e, pcm::bind(integrator::DI, this->factor_, pcm::_1), nRows);
     }
     /**@}*/
 
     /**@{ Single and double layer potentials for a IonicLiquid Green's function by collocation */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("CollocationIntegrator::singleLayer not implemented yet for IonicLiquid");
     }
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("CollocationIntegrator::doubleLayer not implemented yet for IonicLiquid");
     }
     /**@}*/
 
     /**@{ Single and double layer potentials for an AnisotropicLiquid Green's function by collocation */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("CollocationIntegrator::singleLayer not implemented yet for AnisotropicLiquid");
     }
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, CollocationIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("CollocationIntegrator::doubleLayer not implemented yet for AnisotropicLiquid");
     }
     /**@}*/
@@ -135,67 +141,87 @@ struct CollocationIntegrator
     /*! \tparam ProfilePolicy the permittivity profile for the diffuse interface
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename ProfilePolicy>
-    Eigen::MatrixXd singleLayer(const SphericalDiffuse<CollocationIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const SphericalDiffuse<CollocationIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e, size_t nRows) const {
         // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
         size_t mat_size = e.size();
-        Eigen::MatrixXd S = Eigen::MatrixXd::Zero(mat_size, mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
-            // Fill diagonal
-            // Diagonal of S inside the cavity
-            double Sii_I = factor_ * std::sqrt(4 * M_PI / e[i].area());
-            // "Diagonal" of Coulomb singularity separation coefficient
-            double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
-            // "Diagonal" of the image Green's function
-            double image = gf.imagePotential(e[i].center(), e[i].center());
-            S(i, i) = Sii_I / coulomb_coeff + image;
-            Eigen::Vector3d source = e[i].center();
-            for (size_t j = 0; j < mat_size; ++j) {
-                // Fill off-diagonal
-                Eigen::Vector3d probe = e[j].center();
-                if (i != j) S(i, j) = gf.kernelS(source, probe);
+        Eigen::MatrixXd S = Eigen::MatrixXd::Zero(nRows, mat_size);
+        ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < nRows; ++i) {
+            try {
+                // Fill diagonal
+                // Diagonal of S inside the cavity
+                double Sii_I = factor_ * std::sqrt(4 * M_PI / e[i].area());
+                // "Diagonal" of Coulomb singularity separation coefficient
+                double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
+                // "Diagonal" of the image Green's function
+                double image = gf.imagePotential(e[i].center(), e[i].center());
+                S(i, i) = Sii_I / coulomb_coeff + image;
+                Eigen::Vector3d source = e[i].center();
+                for (size_t j = 0; j < mat_size; ++j) {
+                    // Fill off-diagonal
+                    Eigen::Vector3d probe = e[j].center();
+                    if (i != j) S(i, j) = gf.kernelS(source, probe);
+                }
+            } catch (const std::exception & e) {
+                error.record(e);
             }
         }
+        error.raise();
         return S;
     }
     /*! \tparam ProfilePolicy the permittivity profile for the diffuse interface
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename ProfilePolicy>
-    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<CollocationIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<CollocationIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e, size_t nRows) const {
         // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
         size_t mat_size = e.size();
-        Eigen::MatrixXd D = Eigen::MatrixXd::Zero(mat_size, mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
-            // Fill diagonal
-            double area = e[i].area();
-            double radius = e[i].sphere().radius();
-            // Diagonal of S inside the cavity
-            double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
-            // Diagonal of D inside the cavity
-            double Dii_I = -factor_ * std::sqrt(M_PI/ area) * (1.0 / radius);
-            // "Diagonal" of Coulomb singularity separation coefficient
-            double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
-            // "Diagonal" of the directional derivative of the Coulomb singularity separation coefficient
-            double coeff_grad = gf.coefficientCoulombDerivative(e[i].normal(), e[i].center(), e[i].center()) / std::pow(coulomb_coeff, 2);
-            // "Diagonal" of the directional derivative of the image Green's function
-            double image_grad = gf.imagePotentialDerivative(e[i].normal(), e[i].center(), e[i].center());
-
-            double eps_r2 = 0.0;
-            pcm::tie(eps_r2, pcm::ignore) = gf.epsilon(e[i].center());
-
-            D(i, i) = eps_r2 * (Dii_I / coulomb_coeff - Sii_I * coeff_grad + image_grad);
-            Eigen::Vector3d source = e[i].center();
-            for (size_t j = 0; j < mat_size; ++j) {
-                // Fill off-diagonal
-                Eigen::Vector3d probe = e[j].center();
-                Eigen::Vector3d probeNormal = e[j].normal();
-                probeNormal.normalize();
-                if (i != j) D(i, j) = gf.kernelD(probeNormal, source, probe);
+        Eigen::MatrixXd D = Eigen::MatrixXd::Zero(nRows, mat_size);
+        ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < nRows; ++i) {
+            try {
+                // Fill diagonal
+                double area = e[i].area();
+                double radius = e[i].sphere().radius();
+                // Diagonal of S inside the cavity
+                double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
+                // Diagonal of D inside the cavity
+                double Dii_I = -factor_ * std::sqrt(M_PI/ area) * (1.0 / radius);
+                // "Diagonal" of Coulomb singularity separation coefficient
+                double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
+                // "Diagonal" of the directional derivative of the Coulomb singularity separation coefficient
+                double coeff_grad = gf.coefficientCoulombDerivative(e[i].normal(), e[i].center(), e[i].center()) / std::pow(coulomb_coeff, 2);
+                // "Diagonal" of the directional derivative of the image Green's function
+                double image_grad = gf.imagePotentialDerivative(e[i].normal(), e[i].center(), e[i].center());
+
+                double eps_r2 = 0.0;
+                pcm::tie(eps_r2, pcm::ignore) = gf.epsilon(e[i].center());
+
+                D(i, i) = eps_r2 * (Dii_I / coulomb_coeff - Sii_I * coeff_grad + image_grad);
+                Eigen::Vector3d source = e[i].center();
+                for (size_t j = 0; j < mat_size; ++j) {
+                    // Fill off-diagonal
+                    Eigen::Vector3d probe = e[j].center();
+                    Eigen::Vector3d probeNormal = e[j].normal();
+                    probeNormal.normalize();
+                    if (i != j) D(i, j) = gf.kernelD(probeNormal, source, probe);
+                }
+            } catch (const std::exception & e) {
+                error.record(e);
             }
         }
+        error.raise();
         return D;
     }
     /**@}*/
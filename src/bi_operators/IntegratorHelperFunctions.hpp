@@ -26,7 +26,10 @@
 #ifndef INTEGRATORHELPERFUNCTIONS_HPP
 #define INTEGRATORHELPERFUNCTIONS_HPP
 
+#include <algorithm>
 #include <cmath>
+#include <map>
+#include <utility>
 #include <vector>
 
 #include "Config.hpp"
@@ -34,10 +37,12 @@
 #include <Eigen/Core>
 
 #include <boost/mpl/at.hpp>
+#include <boost/mpl/bool.hpp>
 #include <boost/mpl/int.hpp>
 #include <boost/mpl/map.hpp>
 
 #include "Element.hpp"
+#include "GreensFunctionTraits.hpp"
 #include "QuadratureRules.hpp"
 
 namespace integrator {
@@ -75,67 +80,399 @@ inline double DI(double factor, const Element & el)
     return (-factor * std::sqrt(M_PI / el.area()) * 1.0 / el.sphere().radius());
 }
 
+/*! Number of finite elements in a tile of the cache-blocked assembly of the operators */
+const size_t tileSize = 64;
+
+/*! Returns the centers of the finite elements, 3 x N */
+inline Eigen::Matrix3Xd centers(const std::vector<Element> & elements)
+{
+    Eigen::Matrix3Xd c(3, elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) c.col(i) = elements[i].center();
+    return c;
+}
+
 /*! Returns matrix representation of the single layer operator by collocation
  *  \param[in] elements list of finite elements
  *  \param[in] diagS    functor for the evaluation of the diagonal of S
  *  \param[in] kernS    function for the evaluation of the off-diagonal of S
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  The matrix is filled by column in tiles of tileSize x tileSize, with the
+ *  centers of the finite elements gathered beforehand.
  */
 inline Eigen::MatrixXd singleLayer(const std::vector<Element> & elements,
-                                   const Diagonal & diagS, const KernelS & kernS)
+                                   const Diagonal & diagS, const KernelS & kernS, size_t nRows)
+{
+    size_t mat_size = elements.size();
+    Eigen::Matrix3Xd c = centers(elements);
+    Eigen::MatrixXd S(nRows, mat_size);
+    int nTiles = (mat_size + tileSize - 1) / tileSize;
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int tj = 0; tj < nTiles; ++tj) {
+        try {
+            size_t jEnd = std::min(mat_size, (tj + 1) * tileSize);
+            for (size_t iBegin = 0; iBegin < nRows; iBegin += tileSize) {
+                size_t iEnd = std::min(nRows, iBegin + tileSize);
+                for (size_t j = tj * tileSize; j < jEnd; ++j) {
+                    Eigen::Vector3d probe = c.col(j);
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        S(i, j) = (i == j) ? diagS(elements[i]) : kernS(c.col(i), probe);
+                    }
+                }
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    return S;
+}
+
+/*! Copies the strictly upper triangle of the leading n x n block of a matrix to the strictly lower one
+ *  \param[in,out] M the matrix
+ *  \param[in] n dimension of the block
+ *
+ *  The copy is done by tiles of tileSize x tileSize.
+ */
+inline void mirrorUpperTriangle(Eigen::MatrixXd & M, size_t n)
+{
+    int nTiles = (n + tileSize - 1) / tileSize;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int tj = 0; tj < nTiles; ++tj) {
+        size_t jBegin = tj * tileSize, jEnd = std::min(n, jBegin + tileSize);
+        for (size_t iBegin = 0; iBegin < jBegin; iBegin += tileSize) {
+            M.block(jBegin, iBegin, jEnd - jBegin, tileSize) = M.block(iBegin, jBegin, tileSize, jEnd - jBegin).transpose();
+        }
+        for (size_t j = jBegin; j < jEnd; ++j) {
+            for (size_t i = jBegin; i < j; ++i) M(j, i) = M(i, j);
+        }
+    }
+}
+
+/*! Returns matrix representation of the single layer operator by collocation for a symmetric kernel
+ *  \param[in] elements list of finite elements
+ *  \param[in] diagS    functor for the evaluation of the diagonal of S
+ *  \param[in] kernS    function for the evaluation of the off-diagonal of S, symmetric in its arguments
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  Only the tiles on and above the diagonal are computed, the ones below are obtained
+ *  by symmetry: the kernel is evaluated once for each pair of finite elements.
+ */
+inline Eigen::MatrixXd singleLayerSymmetric(const std::vector<Element> & elements,
+                                            const Diagonal & diagS, const KernelS & kernS, size_t nRows)
 {
     size_t mat_size = elements.size();
-    Eigen::MatrixXd S = Eigen::MatrixXd::Zero(mat_size, mat_size);
-    for (size_t i = 0; i < mat_size; ++i) {
-        // Fill diagonal
-        S(i, i) = diagS(elements[i]);
-        Eigen::Vector3d source = elements[i].center();
-        for (size_t j = 0; j < mat_size; ++j) {
-            // Fill off-diagonal
-            Eigen::Vector3d probe = elements[j].center();
-            if (i != j) S(i, j) = kernS(source, probe);
+    Eigen::Matrix3Xd c = centers(elements);
+    Eigen::MatrixXd S(nRows, mat_size);
+    // Tiles on and above the diagonal, as pairs of row and column tile indices
+    std::vector<std::pair<size_t, size_t> > tiles;
+    for (size_t tj = 0; tj * tileSize < mat_size; ++tj) {
+        for (size_t ti = 0; ti <= tj && ti * tileSize < nRows; ++ti) tiles.push_back(std::make_pair(ti, tj));
+    }
+    int nTiles = tiles.size();
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int t = 0; t < nTiles; ++t) {
+        try {
+            size_t iBegin = tiles[t].first * tileSize, iEnd = std::min(nRows, iBegin + tileSize);
+            size_t jBegin = tiles[t].second * tileSize, jEnd = std::min(mat_size, jBegin + tileSize);
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                Eigen::Vector3d probe = c.col(j);
+                for (size_t i = iBegin; i < iEnd && i < j; ++i) S(i, j) = kernS(c.col(i), probe);
+                if (j < nRows) S(j, j) = diagS(elements[j]);
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
         }
     }
+    error.raise();
+    mirrorUpperTriangle(S, nRows);
     return S;
 }
 
+/**@{ Tag dispatch of the single layer assembly on the symmetry of the kernel */
+inline Eigen::MatrixXd singleLayer(const std::vector<Element> & elements,
+                                   const Diagonal & diagS, const KernelS & kernS, size_t nRows, boost::mpl::false_)
+{
+    return singleLayer(elements, diagS, kernS, nRows);
+}
+
+inline Eigen::MatrixXd singleLayer(const std::vector<Element> & elements,
+                                   const Diagonal & diagS, const KernelS & kernS, size_t nRows, boost::mpl::true_)
+{
+    return singleLayerSymmetric(elements, diagS, kernS, nRows);
+}
+/**@}*/
+
+/*! Returns matrix representation of the single layer operator by collocation for the kernel of a Green's function
+ *  \tparam GreensFunction type of the Green's function
+ *  \param[in] elements list of finite elements
+ *  \param[in] diagS    functor for the evaluation of the diagonal of S
+ *  \param[in] kernS    function for the evaluation of the off-diagonal of S
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  The assembly is selected at compile time by SymmetricKernel: only one triangle
+ *  is evaluated for the Green's functions with a symmetric kernel.
+ */
+template <typename GreensFunction>
+inline Eigen::MatrixXd singleLayer(const GreensFunction & /* gf */, const std::vector<Element> & elements,
+                                   const Diagonal & diagS, const KernelS & kernS, size_t nRows)
+{
+    return singleLayer(elements, diagS, kernS, nRows, boost::mpl::bool_<SymmetricKernel<GreensFunction>::value>());
+}
+
 /*! Returns matrix representation of the double layer operator by collocation
  *  \param[in] elements list of finite elements
  *  \param[in] diagD    functor for the evaluation of the diagonal of D
  *  \param[in] kernD    function for the evaluation of the off-diagonal of D
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  The matrix is filled by column in tiles of tileSize x tileSize, with the
+ *  centers and the normalized normals of the finite elements gathered beforehand.
  */
 inline Eigen::MatrixXd doubleLayer(const std::vector<Element> & elements,
-                                   const Diagonal & diagD, const KernelD & kernD)
+                                   const Diagonal & diagD, const KernelD & kernD, size_t nRows)
 {
     size_t mat_size = elements.size();
-    Eigen::MatrixXd D = Eigen::MatrixXd::Zero(mat_size, mat_size);
-    for (size_t i = 0; i < mat_size; ++i) {
-        // Fill diagonal
-        D(i, i) = diagD(elements[i]);
-        Eigen::Vector3d source = elements[i].center();
-        for (size_t j = 0; j < mat_size; ++j) {
-            // Fill off-diagonal
-            Eigen::Vector3d probe = elements[j].center();
-            Eigen::Vector3d probeNormal = elements[j].normal();
-            probeNormal.normalize();
-            if (i != j) D(i, j) = kernD(probeNormal, source, probe);
+    Eigen::Matrix3Xd c = centers(elements);
+    Eigen::Matrix3Xd n(3, mat_size);
+    for (size_t j = 0; j < mat_size; ++j) n.col(j) = elements[j].normal().normalized();
+    Eigen::MatrixXd D(nRows, mat_size);
+    int nTiles = (mat_size + tileSize - 1) / tileSize;
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int tj = 0; tj < nTiles; ++tj) {
+        try {
+            size_t jEnd = std::min(mat_size, (tj + 1) * tileSize);
+            for (size_t iBegin = 0; iBegin < nRows; iBegin += tileSize) {
+                size_t iEnd = std::min(nRows, iBegin + tileSize);
+                for (size_t j = tj * tileSize; j < jEnd; ++j) {
+                    Eigen::Vector3d probe = c.col(j);
+                    Eigen::Vector3d probeNormal = n.col(j);
+                    for (size_t i = iBegin; i < iEnd; ++i) {
+                        D(i, j) = (i == j) ? diagD(elements[i]) : kernD(probeNormal, c.col(i), probe);
+                    }
+                }
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
         }
     }
+    error.raise();
     return D;
 }
 
-/*! \brief Integrates a single layer type operator on a single spherical polygon
+/*! \struct Coordinates
+ *  \brief Coordinates of the finite elements centers and normals as separate arrays
+ *
+ *  The structure-of-arrays layout lets the kernels of the Coulomb operators be
+ *  evaluated for one point against all the others as vectorized Eigen array expressions.
+ */
+struct Coordinates
+{
+    Coordinates(const std::vector<Element> & elements)
+        : x(elements.size()), y(elements.size()), z(elements.size()),
+          nx(elements.size()), ny(elements.size()), nz(elements.size())
+    {
+        for (size_t i = 0; i < elements.size(); ++i) {
+            Eigen::Vector3d center = elements[i].center();
+            Eigen::Vector3d normal = elements[i].normal().normalized();
+            x(i) = center(0); y(i) = center(1); z(i) = center(2);
+            nx(i) = normal(0); ny(i) = normal(1); nz(i) = normal(2);
+        }
+    }
+    /*! Finite elements centers */
+    Eigen::ArrayXd x, y, z;
+    /*! Finite elements normals, normalized */
+    Eigen::ArrayXd nx, ny, nz;
+};
+
+/*! Returns matrix representation of the single layer operator by collocation
+ *  for the Coulomb kernel \f$ G(\mathbf{s}, \mathbf{p}) = \frac{1}{\varepsilon|\mathbf{s} - \mathbf{p}|}\f$
+ *  \param[in] elements list of finite elements
+ *  \param[in] diagS    functor for the evaluation of the diagonal of S
+ *  \param[in] epsilon  permittivity
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  The kernel is evaluated column by column, i.e. for one probe point against
+ *  all the source points at once, without going through the Green's function.
+ *  Only the upper triangle is evaluated, the lower one is obtained by symmetry.
+ */
+inline Eigen::MatrixXd singleLayerCoulomb(const std::vector<Element> & elements,
+                                          const Diagonal & diagS, double epsilon, size_t nRows)
+{
+    size_t mat_size = elements.size();
+    Coordinates c(elements);
+    Eigen::MatrixXd S(nRows, mat_size);
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (size_t j = 0; j < mat_size; ++j) {
+        try {
+            // Fill off-diagonal above the diagonal, the kernel is symmetric
+            size_t rows = std::min(j, nRows);
+            S.col(j).head(rows) = ((c.x.head(rows) - c.x(j)).square() + (c.y.head(rows) - c.y(j)).square()
+                    + (c.z.head(rows) - c.z(j)).square()).sqrt().inverse() / epsilon;
+            // Fill diagonal
+            if (j < nRows) S(j, j) = diagS(elements[j]);
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    mirrorUpperTriangle(S, nRows);
+    return S;
+}
+
+/*! Returns matrix representation of the double layer operator by collocation
+ *  for the Coulomb kernel \f$ \varepsilon\nabla_{\mathbf{p}}G(\mathbf{s}, \mathbf{p})\cdot\mathbf{n}_{\mathbf{p}}
+ *  = \frac{(\mathbf{s} - \mathbf{p})\cdot\mathbf{n}_{\mathbf{p}}}{|\mathbf{s} - \mathbf{p}|^3}\f$
+ *  \param[in] elements list of finite elements
+ *  \param[in] diagD    functor for the evaluation of the diagonal of D
+ *  \param[in] nRows    number of rows, i.e. the first nRows elements are the source points
+ *
+ *  The kernel is evaluated column by column, i.e. for one probe point against
+ *  all the source points at once, without going through the Green's function.
+ */
+inline Eigen::MatrixXd doubleLayerCoulomb(const std::vector<Element> & elements,
+                                          const Diagonal & diagD, size_t nRows)
+{
+    size_t mat_size = elements.size();
+    Coordinates c(elements);
+    Eigen::MatrixXd D(nRows, mat_size);
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t j = 0; j < mat_size; ++j) {
+        try {
+            // Fill off-diagonal, the diagonal is overwritten
+            Eigen::ArrayXd dx = c.x.head(nRows) - c.x(j);
+            Eigen::ArrayXd dy = c.y.head(nRows) - c.y(j);
+            Eigen::ArrayXd dz = c.z.head(nRows) - c.z(j);
+            D.col(j) = (c.nx(j) * dx + c.ny(j) * dy + c.nz(j) * dz)
+                * (dx.square() + dy.square() + dz.square()).sqrt().inverse().cube();
+            // Fill diagonal
+            if (j < nRows) D(j, j) = diagD(elements[j]);
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    return D;
+}
+
+/*! \struct QuadratureTable
+ *  \brief Quadrature points and weights on a finite element
+ *
+ *  The integral of a function over the finite element is the dot product
+ *  of the weights with the values of the function at the points.
+ */
+struct QuadratureTable
+{
+    /*! Quadrature points, relative to the center of the finite element, 3 x N */
+    Eigen::Matrix3Xd points;
+    /*! Normals to the surface at the quadrature points, 3 x N */
+    Eigen::Matrix3Xd normals;
+    /*! Quadrature weights */
+    Eigen::VectorXd weights;
+};
+
+/*! \class QuadratureCache
+ *  \brief Quadrature tables of the finite elements, built on first use
+ *
+ *  A table stores 7 doubles for each of the nVertices x PhiPoints x ThetaPoints
+ *  points: about 140 KB for a pentagonal finite element and the (32, 16) rule.
+ *  The cache holds at most capacity points, the tables that do not fit are
+ *  built on each use and released right away. clear releases all the tables.
+ */
+class QuadratureCache
+{
+public:
+    /*! \param[in] capacity maximum number of quadrature points held */
+    explicit QuadratureCache(size_t capacity = defaultCapacity) : capacity_(capacity), size_(0) {}
+    /*! Default capacity, 2^20 points or about 56 MB */
+    static const size_t defaultCapacity = 1 << 20;
+    /*! \brief Returns the table of a product Gauss rule on a finite element
+     *  \param[in] phiPoints number of points of the rule for the azimuthal integration
+     *  \param[in] thetaPoints number of points of the rule for the polar integration
+     *  \param[in] e finite element
+     *  \param[in] build builds the table, called when the cache does not hold it
+     */
+    pcm::shared_ptr<const QuadratureTable> table(int phiPoints, int thetaPoints, const Element & e,
+            const pcm::function<QuadratureTable(const Element &)> & build)
+    {
+        Key key = makeKey(phiPoints, thetaPoints, e);
+        pcm::shared_ptr<const QuadratureTable> found;
+#ifdef HAVE_OPENMP
+#pragma omp critical (quadrature_cache)
+#endif
+        {
+            Tables::const_iterator it = tables_.find(key);
+            if (it != tables_.end()) found = it->second;
+        }
+        if (found) return found;
+        // The table is built outside the critical section: the diagonal elements
+        // are integrated in parallel and each thread builds the tables of its finite elements
+        pcm::shared_ptr<const QuadratureTable> built = pcm::make_shared<QuadratureTable>(build(e));
+        size_t points = built->weights.size();
+#ifdef HAVE_OPENMP
+#pragma omp critical (quadrature_cache)
+#endif
+        {
+            Tables::const_iterator it = tables_.find(key);
+            if (it != tables_.end()) {
+                found = it->second;
+            } else if (size_ + points <= capacity_) {
+                tables_.insert(std::make_pair(key, built));
+                size_ += points;
+            }
+        }
+        return found ? found : built;
+    }
+    /*! Number of quadrature points held */
+    size_t size() const { return size_; }
+    /*! Releases all the tables */
+    void clear() { tables_.clear(); size_ = 0; }
+private:
+    /*! The rule and the center, area and number of vertices of the finite element */
+    typedef std::vector<double> Key;
+    typedef std::map<Key, pcm::shared_ptr<const QuadratureTable> > Tables;
+    size_t capacity_;
+    size_t size_;
+    Tables tables_;
+    static Key makeKey(int phiPoints, int thetaPoints, const Element & e)
+    {
+        Eigen::Vector3d center = e.center();
+        double key[] = { double(phiPoints), double(thetaPoints), center(0), center(1), center(2), e.area(), double(e.nVertices()) };
+        return Key(key, key + sizeof(key) / sizeof(key[0]));
+    }
+};
+
+/*! \brief Builds the quadrature table of a product Gauss rule on a single spherical polygon
  *  \date 2014
  *  \tparam PhiPoints Gaussian rule to be used in the angular phi integration
  *  \tparam ThetaPoints Gaussian rule to be used in the angular theta integration
+ *  \param[in] e the finite element
  *
- *  This is needed for the numerical evaluation of the diagonal elements when using
- *  centroid collocation.
+ *  The spherical polygon is decomposed into triangles with a common vertex in the
+ *  representative point. The weights include the Jacobian of the spherical coordinates.
+ *  The points are relative to the representative point, on the sphere of the finite element,
+ *  and the normals to the sphere at the points are tabulated too.
  */
 template <int PhiPoints, int ThetaPoints>
-double integrateS(const KernelS & F, const Element & e)
+QuadratureTable quadratureTable(const Element & e)
 {
-    double result = 0.0;
-
     // Get the quadrature rules for azimuthal and polar integrations
     namespace mpl = boost::mpl;
     typedef typename mpl::at<rules_map, mpl::int_<PhiPoints> >::type PhiPolicy;
@@ -149,7 +486,6 @@ double integrateS(const KernelS & F, const Element & e)
     int nVertices = e.nVertices();
     Eigen::Vector3d normal = e.normal();
     Sphere sph = e.sphere();
-    Eigen::Matrix3Xd vertices = e.vertices();
     Eigen::Matrix3Xd arcs = e.arcs();
 
     // Calculation of the tangent and the bitangent (binormal) vectors
@@ -168,11 +504,15 @@ double integrateS(const KernelS & F, const Element & e)
     // Populate arrays and redefine tangent and bitangent
     e.spherical_polygon(tangent, bitangent, theta, phi, phinumb, numb);
 
-    // Actual integration occurs here
+    std::vector<Eigen::Vector3d> points, normals;
+    std::vector<double> weights;
+    points.reserve(nVertices * PhiPoints * ThetaPoints);
+    normals.reserve(nVertices * PhiPoints * ThetaPoints);
+    weights.reserve(nVertices * PhiPoints * ThetaPoints);
     for (int i = 0; i < nVertices; ++i) { // Loop on edges
-        double phiLower = phinumb[i];
-        double phiUpper = phinumb[i+1];
-        double phiA= (phiUpper - phiLower) / 2.0;
+        double phiLower = phinumb[i]; // Lower vertex of edge
+        double phiUpper = phinumb[i+1]; // Upper vertex of edge
+        double phiA = (phiUpper - phiLower) / 2.0;
         double phiB = (phiUpper + phiLower) / 2.0;
         double thetaLower = theta[numb[i]];
         double thetaUpper = theta[numb[i+1]];
@@ -191,8 +531,6 @@ double integrateS(const KernelS & F, const Element & e)
                                 thetaLower)) / std::sin(phiUpper - phiLower);
                     thetaMax = std::atan(1.0 / cotg_thmax);
                 } else {
-                    Eigen::Vector3d scratch;
-                    scratch << tangent.dot(oc), bitangent.dot(oc), normal.dot(oc);
                     double aa = std::pow(tangent.dot(oc)*cos_ph + bitangent.dot(oc)*sin_ph,
                             2) + std::pow(normal.dot(oc), 2);
                     double bb = -normal.dot(oc) * oc_norm2;
@@ -205,148 +543,156 @@ double integrateS(const KernelS & F, const Element & e)
                     if (cs < -1.0) cs = 1.0;
                     thetaMax = std::acos(cs);
                 }
-                double scratch = 0.0;
-                if (!(thetaMax < 1.0e-08)) {
-                    double thetaA = thetaMax / 2.0;
-                    for (int l = 0; l < upper_theta; ++l) { // Loop on Gaussian points: theta integration
-                        for (int m = 0; m <= 1; ++m) {
-                            double th = (2*m - 1) * thetaA * thetaRule.abscissa(l) + thetaA;
-                            double cos_th = std::cos(th);
-                            double sin_th = std::sin(th);
-                            Eigen::Vector3d point;
-                            point(0) = tangent(0) * sin_th * cos_ph
-                                + bitangent(0) * sin_th * sin_ph
-                                + normal(0) * (cos_th - 1.0);
-                            point(1) = tangent(1) * sin_th * cos_ph
-                                + bitangent(1) * sin_th * sin_ph
-                                + normal(1) * (cos_th - 1.0);
-                            point(2) = tangent(2) * sin_th * cos_ph
-                                + bitangent(2) * sin_th * sin_ph
-                                + normal(2) * (cos_th - 1.0);
-                            double value = F(point,
-                                    Eigen::Vector3d::Zero()); // Evaluate integrand at Gaussian point
-                            scratch += std::pow(sph.radius(), 2) * value * sin_th * thetaA * thetaRule.weight(l);
-                        }
+                if (thetaMax < 1.0e-08) continue;
+                double thetaA = thetaMax / 2.0;
+                for (int l = 0; l < upper_theta; ++l) { // Loop on Gaussian points: theta integration
+                    for (int m = 0; m <= 1; ++m) {
+                        double th = (2*m - 1) * thetaA * thetaRule.abscissa(l) + thetaA;
+                        double cos_th = std::cos(th);
+                        double sin_th = std::sin(th);
+                        Eigen::Vector3d pointNormal = tangent * sin_th * cos_ph + bitangent * sin_th * sin_ph + normal * cos_th;
+                        points.push_back(sph.radius() * (pointNormal - normal));
+                        normals.push_back(pointNormal);
+                        weights.push_back(std::pow(sph.radius(), 2) * sin_th * thetaA * thetaRule.weight(l) * phiA * phiRule.weight(j));
                     }
-                    result += scratch * phiA * phiRule.weight(j);
                 }
             }
         }
     }
-    return result;
+
+    QuadratureTable table;
+    table.points.resize(3, points.size());
+    table.normals.resize(3, normals.size());
+    table.weights = Eigen::Map<Eigen::VectorXd>(weights.data(), weights.size());
+    for (size_t p = 0; p < points.size(); ++p) {
+        table.points.col(p) = points[p];
+        table.normals.col(p) = normals[p];
+    }
+    return table;
 }
 
-/*! \brief Integrates a double layer type operator on a single spherical polygon
+/*! \brief Returns the quadrature table of a product Gauss rule on a single spherical polygon
+ *  \tparam PhiPoints Gaussian rule to be used in the angular phi integration
+ *  \tparam ThetaPoints Gaussian rule to be used in the angular theta integration
+ *  \param[in] e     finite element
+ *  \param[in] cache the cache of the tables, the table is built anew when null
+ */
+template <int PhiPoints, int ThetaPoints>
+pcm::shared_ptr<const QuadratureTable> quadrature(const Element & e, QuadratureCache * cache)
+{
+    if (cache) return cache->table(PhiPoints, ThetaPoints, e, &quadratureTable<PhiPoints, ThetaPoints>);
+    return pcm::make_shared<QuadratureTable>(quadratureTable<PhiPoints, ThetaPoints>(e));
+}
+
+/*! \brief Integrates a single layer type operator on a single spherical polygon
  *  \date 2014
  *  \tparam PhiPoints Gaussian rule to be used in the angular phi integration
  *  \tparam ThetaPoints Gaussian rule to be used in the angular theta integration
+ *  \param[in] F     the kernel
+ *  \param[in] e     finite element
+ *  \param[in] cache the cache of the quadrature tables, none when null
  *
  *  This is needed for the numerical evaluation of the diagonal elements when using
  *  centroid collocation.
  */
 template <int PhiPoints, int ThetaPoints>
-double integrateD(const KernelD & F, const Element & e)
+double integrateS(const KernelS & F, const Element & e, QuadratureCache * cache = NULL)
 {
-    double result = 0.0;
-
-    // Get the quadrature rules for azimuthal and polar integrations
-    namespace mpl = boost::mpl;
-    typedef typename mpl::at<rules_map, mpl::int_<PhiPoints> >::type PhiPolicy;
-    typedef typename mpl::at<rules_map, mpl::int_<ThetaPoints> >::type ThetaPolicy;
-    QuadratureRule<PhiPolicy> phiRule;
-    QuadratureRule<ThetaPolicy> thetaRule;
-    int upper_phi = PhiPoints / 2; // Upper limit for loop on phi points
-    int upper_theta = ThetaPoints / 2; // Upper limit for loop on theta points
+    pcm::shared_ptr<const QuadratureTable> tablePtr = quadrature<PhiPoints, ThetaPoints>(e, cache);
+    const QuadratureTable & table = *tablePtr;
+    Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+    Eigen::VectorXd values(table.weights.size());
+    for (int k = 0; k < values.size(); ++k) {
+        values(k) = F(table.points.col(k), origin); // Evaluate integrand at Gaussian point
+    }
+    return table.weights.dot(values);
+}
 
-    // Extract relevant data from Element
-    int nVertices = e.nVertices();
-    Eigen::Vector3d normal = e.normal();
-    Sphere sph = e.sphere();
-    Eigen::Matrix3Xd vertices = e.vertices();
-    Eigen::Matrix3Xd arcs = e.arcs();
+/*! \brief Integrates a double layer type operator on a single spherical polygon
+ *  \date 2014
+ *  \tparam PhiPoints Gaussian rule to be used in the angular phi integration
+ *  \tparam ThetaPoints Gaussian rule to be used in the angular theta integration
+ *  \param[in] F     the kernel
+ *  \param[in] e     finite element
+ *  \param[in] cache the cache of the quadrature tables, none when null
+ *
+ *  This is needed for the numerical evaluation of the diagonal elements when using
+ *  centroid collocation.
+ */
+template <int PhiPoints, int ThetaPoints>
+double integrateD(const KernelD & F, const Element & e, QuadratureCache * cache = NULL)
+{
+    pcm::shared_ptr<const QuadratureTable> tablePtr = quadrature<PhiPoints, ThetaPoints>(e, cache);
+    const QuadratureTable & table = *tablePtr;
+    Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+    Eigen::VectorXd values(table.weights.size());
+    for (int k = 0; k < values.size(); ++k) {
+        // Evaluate integrand at Gaussian point, along the normal at that point
+        values(k) = F(table.normals.col(k), origin, table.points.col(k));
+    }
+    return table.weights.dot(values);
+}
 
-    // Calculation of the tangent and the bitangent (binormal) vectors
-    // Tangent, Bitangent and Normal form a local reference frame:
-    // T <-> x; B <-> y; N <-> z
-    Eigen::Vector3d tangent, bitangent;
-    tangent_and_bitangent(normal, tangent, bitangent);
+/*! \brief Applies Gaussian rules of increasing order until two successive estimates agree
+ *  \tparam Kernel the kernel functor, KernelS or KernelD
+ *  \param[in] rules     the integration rules, from the lowest to the highest order
+ *  \param[in] nRules    number of integration rules
+ *  \param[in] F         the kernel
+ *  \param[in] e         finite element
+ *  \param[in] tolerance relative tolerance on the integral
+ *  \param[in] cache     the cache of the quadrature tables, none when null
+ *
+ *  The difference between two successive estimates is taken as the error of the
+ *  lower order one. The estimate of the highest order rule is returned when the
+ *  tolerance is not met.
+ */
+template <typename Kernel>
+double integrateAdaptive(double (* const rules[])(const Kernel &, const Element &, QuadratureCache *), int nRules,
+        const Kernel & F, const Element & e, double tolerance, QuadratureCache * cache)
+{
+    double previous = rules[0](F, e, cache);
+    double current = previous;
+    for (int i = 1; i < nRules; ++i) {
+        current = rules[i](F, e, cache);
+        if (std::abs(current - previous) <= tolerance * std::abs(current)) break;
+        previous = current;
+    }
+    return current;
+}
 
-    std::vector<double> theta(nVertices), phi(nVertices), phinumb(nVertices+1);
-    std::vector<int> numb(nVertices+1);
-    // Clean-up heap crap
-    std::fill_n(theta.begin(),   nVertices,   0.0);
-    std::fill_n(phi.begin(),     nVertices,   0.0);
-    std::fill_n(numb.begin(),    nVertices+1, 0);
-    std::fill_n(phinumb.begin(), nVertices+1, 0.0);
-    // Populate arrays and redefine tangent and bitangent
-    e.spherical_polygon(tangent, bitangent, theta, phi, phinumb, numb);
+/*! \brief Integrates a single layer type operator on a single spherical polygon, adaptively
+ *  \param[in] F         the kernel
+ *  \param[in] e         finite element
+ *  \param[in] tolerance relative tolerance on the integral
+ *  \param[in] cache     the cache of the quadrature tables, none when null
+ *
+ *  The (8, 8), (16, 8), (32, 16), (64, 16) and (64, 32) point rules in the phi and theta
+ *  integrations are applied in turn. The phi rule is refined first: the upper bound
+ *  of the theta integration is not smooth in phi on tesserae cut by neighbouring spheres.
+ *  Small and flat tesserae are converged by the lowest orders.
+ */
+inline double integrateSAdaptive(const KernelS & F, const Element & e, double tolerance, QuadratureCache * cache = NULL)
+{
+    static double (* const rules[])(const KernelS &, const Element &, QuadratureCache *) = {
+        &integrateS<8, 8>, &integrateS<16, 8>, &integrateS<32, 16>, &integrateS<64, 16>, &integrateS<64, 32>
+    };
+    return integrateAdaptive(rules, sizeof(rules) / sizeof(rules[0]), F, e, tolerance, cache);
+}
 
-    // Actual integration occurs here
-    for (int i = 0; i < nVertices; ++i) { // Loop on edges
-        double phiLower = phinumb[i]; // Lower vertex of edge
-        double phiUpper = phinumb[i+1]; // Upper vertex of edge
-        double phiA = (phiUpper - phiLower) / 2.0;
-        double phiB = (phiUpper + phiLower) / 2.0;
-        double thetaLower = theta[numb[i]];
-        double thetaUpper = theta[numb[i+1]];
-        double thetaMax = 0.0;
-        Eigen::Vector3d oc = (arcs.col(i) - sph.center()) / sph.radius();
-        double oc_norm = oc.norm();
-        double oc_norm2 = std::pow(oc_norm, 2);
-        for (int j = 0; j < upper_phi; ++j) { // Loop on Gaussian points: phi integration
-            for (int k = 0; k <= 1; ++k) {
-                double ph = (2*k - 1) * phiA * phiRule.abscissa(j) + phiB;
-                double cos_phi = std::cos(ph);
-                double sin_phi = std::sin(ph);
-                if (oc_norm2 < 1.0e-07) { // This should check if oc_norm2 is zero
-                    double cotg_thmax = (std::sin(ph-phiLower) / std::tan(thetaUpper) + std::sin(phiUpper-ph) / std::tan(
-                                thetaLower)) / std::sin(phiUpper - phiLower);
-                    thetaMax = std::atan(1.0 / cotg_thmax);
-                } else {
-                    Eigen::Vector3d scratch;
-                    scratch << tangent.dot(oc), bitangent.dot(oc), normal.dot(oc);
-                    double aa = std::pow(tangent.dot(oc)*cos_phi + bitangent.dot(oc)*sin_phi,
-                            2) + std::pow(normal.dot(oc), 2);
-                    double bb = -normal.dot(oc) * oc_norm2;
-                    double cc = std::pow(oc_norm2,
-                            2) - std::pow(tangent.dot(oc)*cos_phi + bitangent.dot(oc)*sin_phi, 2);
-                    double ds = std::pow(bb, 2) - aa*cc;
-                    if (ds < 0.0) ds = 0.0;
-                    double cs = (-bb + std::sqrt(ds)) / aa;
-                    if (cs > 1.0) cs = 1.0;
-                    if (cs < -1.0) cs = 1.0;
-                    thetaMax = std::acos(cs);
-                }
-                double thetaA = thetaMax / 2.0;
-                double scratch = 0.0;
-                if (!(thetaMax < 1.0e-08)) {
-                    for (int l = 0; l < upper_theta; ++l) { // Loop on Gaussian points: theta integration
-                        for (int m = 0; m <= 1; ++m) {
-                            double th = (2*m - 1) * thetaA  * thetaRule.abscissa(l) + thetaA;
-                            double cos_theta = std::cos(th);
-                            double sin_theta = std::sin(th);
-                            Eigen::Vector3d point;
-                            point(0) = tangent(0) * sin_theta * cos_phi
-                                + bitangent(0) * sin_theta * sin_phi
-                                + normal(0) * (cos_theta - 1.0);
-                            point(1) = tangent(1) * sin_theta * cos_phi
-                                + bitangent(1) * sin_theta * sin_phi
-                                + normal(1) * (cos_theta - 1.0);
-                            point(2) = tangent(2) * sin_theta * cos_phi
-                                + bitangent(2) * sin_theta * sin_phi
-                                + normal(2) * (cos_theta - 1.0);
-                            double value = F(e.normal(),
-                                    Eigen::Vector3d::Zero(),
-                                    point); // Evaluate integrand at Gaussian point
-                            scratch += std::pow(sph.radius(), 2) * value * sin_theta * thetaA * thetaRule.weight(l);
-                        }
-                    }
-                    result += scratch * phiA * phiRule.weight(j);
-                }
-            }
-        }
-    }
-    return result;
+/*! \brief Integrates a double layer type operator on a single spherical polygon, adaptively
+ *  \param[in] F         the kernel
+ *  \param[in] e         finite element
+ *  \param[in] tolerance relative tolerance on the integral
+ *  \param[in] cache     the cache of the quadrature tables, none when null
+ *
+ *  The sequence of rules is the same as in integrateSAdaptive.
+ */
+inline double integrateDAdaptive(const KernelD & F, const Element & e, double tolerance, QuadratureCache * cache = NULL)
+{
+    static double (* const rules[])(const KernelD &, const Element &, QuadratureCache *) = {
+        &integrateD<8, 8>, &integrateD<16, 8>, &integrateD<32, 16>, &integrateD<64, 16>, &integrateD<64, 32>
+    };
+    return integrateAdaptive(rules, sizeof(rules) / sizeof(rules[0]), F, e, tolerance, cache);
 }
 } // namespace integrator
 
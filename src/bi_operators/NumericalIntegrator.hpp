@@ -37,6 +37,7 @@
 #include "IntegratorHelperFunctions.hpp"
 #include "Element.hpp"
 #include "AnisotropicLiquid.hpp"
+#include "GreensFunctionTraits.hpp"
 #include "IonicLiquid.hpp"
 #include "SphericalDiffuse.hpp"
 #include "UniformDielectric.hpp"
@@ -49,30 +50,52 @@
  *  \date 2015
  *
  *  Calculates the diagonal elements of S and D by collocation, using numerical integration.
+ *  The diagonal elements are the integrals of the kernels over the finite element,
+ *  divided by its area, with the collocation point in its center.
+ *  The quadrature points and weights are tabulated on first use and kept by the integrator,
+ *  and its copies, up to the capacity of integrator::QuadratureCache, about 56 MB.
+ *  The S and D matrices thus share the tables, which are released with the Green's function.
+ *  When a tolerance is given, the order of the quadrature is chosen per finite element
+ *  by comparing successive Gaussian rules, see integrator::integrateSAdaptive.
+ *  For the Green's functions with a symmetric kernel, see SymmetricKernel, only one
+ *  triangle of the off-diagonal elements of S is evaluated.
  */
 
 struct NumericalIntegrator
 {
+    NumericalIntegrator() : tolerance_(0.0), quadrature_(pcm::make_shared<integrator::QuadratureCache>()) {}
+    /*! \param[in] tolerance relative tolerance of the adaptive integration of the diagonal elements,
+     *  the fixed (32, 16) point rule is used when zero
+     */
+    explicit NumericalIntegrator(double tolerance)
+        : tolerance_(tolerance), quadrature_(pcm::make_shared<integrator::QuadratureCache>()) {}
+    /*! The diagonal elements of D depend on their finite element only */
+    static const bool sumRuleDiagonal = false;
+    /*! Returns the parameter of the integration of the diagonal elements, the relative tolerance */
+    double parameter() const { return tolerance_; }
+
     /**@{ Single and double layer potentials for a Vacuum Green's function by collocation: numerical integration of diagonal */
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelS kernelS = pcm::bind(&Vacuum<DerivativeTraits, NumericalIntegrator>::kernelS, gf, pcm::_1, pcm::_2);
-        integrator::Diagonal diagS = pcm::bind(&integrator::integrateS<32, 16>, kernelS, pcm::_1);
-        return integrator::singleLayer(e, diagS, kernelS);
+        integrator::Diagonal diagS = diagonalS(kernelS);
+        return integrator::singleLayerCoulomb(e, diagS, 1.0, nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelD kernelD = pcm::bind(&Vacuum<DerivativeTraits, NumericalIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3);
-        integrator::Diagonal diagD = pcm::bind(&integrator::integrateD<32, 16>, kernelD, pcm::_1);
-        return integrator::doubleLayer(e, diagD, kernelD);
+        integrator::Diagonal diagD = diagonalD(kernelD);
+        return integrator::doubleLayerCoulomb(e, diagD, nRows);
     }
     /**@}*/
 
@@ -80,22 +103,24 @@ struct NumericalIntegrator
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelS kernelS = pcm::bind(&UniformDielectric<DerivativeTraits, NumericalIntegrator>::kernelS, gf, pcm::_1, pcm::_2);
-        integrator::Diagonal diagS = pcm::bind(&integrator::integrateS<32, 16>, kernelS, pcm::_1);
-        return integrator::singleLayer(e, diagS, kernelS);
+        integrator::Diagonal diagS = diagonalS(kernelS);
+        return integrator::singleLayerCoulomb(e, diagS, gf.epsilon(), nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelD kernelD = pcm::bind(&UniformDielectric<DerivativeTraits, NumericalIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3);
-        integrator::Diagonal diagD = pcm::bind(&integrator::integrateD<32, 16>, kernelD, pcm::_1);
-        return integrator::doubleLayer(e, diagD, kernelD);
+        integrator::Diagonal diagD = diagonalD(kernelD);
+        return integrator::doubleLayerCoulomb(e, diagD, nRows);
     }
     /**@}*/
 
@@ -103,22 +128,24 @@ struct NumericalIntegrator
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelS kernelS = pcm::bind(&IonicLiquid<DerivativeTraits, NumericalIntegrator>::kernelS, gf, pcm::_1, pcm::_2);
-        integrator::Diagonal diagS = pcm::bind(&integrator::integrateS<32, 16>, kernelS, pcm::_1);
-        return integrator::singleLayer(e, diagS, kernelS);
+        integrator::Diagonal diagS = diagonalS(kernelS);
+        return integrator::singleLayer(gf, e, diagS, kernelS, nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelD kernelD = pcm::bind(&IonicLiquid<DerivativeTraits, NumericalIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3);
-        integrator::Diagonal diagD = pcm::bind(&integrator::integrateD<32, 16>, kernelD, pcm::_1);
-        return integrator::doubleLayer(e, diagD, kernelD);
+        integrator::Diagonal diagD = diagonalD(kernelD);
+        return integrator::doubleLayer(e, diagD, kernelD, nRows);
     }
     /**@}*/
 
@@ -126,63 +153,65 @@ struct NumericalIntegrator
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelS kernelS = pcm::bind(&AnisotropicLiquid<DerivativeTraits, NumericalIntegrator>::kernelS, gf, pcm::_1, pcm::_2);
-        integrator::Diagonal diagS = pcm::bind(&integrator::integrateS<32, 16>, kernelS, pcm::_1);
-        return integrator::singleLayer(e, diagS, kernelS);
+        integrator::Diagonal diagS = diagonalS(kernelS);
+        return integrator::singleLayer(gf, e, diagS, kernelS, nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, NumericalIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
         integrator::KernelD kernelD = pcm::bind(&AnisotropicLiquid<DerivativeTraits, NumericalIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3);
-        integrator::Diagonal diagD = pcm::bind(&integrator::integrateD<32, 16>, kernelD, pcm::_1);
-        return integrator::doubleLayer(e, diagD, kernelD);
+        integrator::Diagonal diagD = diagonalD(kernelD);
+        return integrator::doubleLayer(e, diagD, kernelD, nRows);
     }
     /**@}*/
 
     /**@{ Single and double layer potentials for a SphericalDiffuse Green's function by collocation: numerical integration of diagonal */
     template <typename ProfilePolicy>
-    Eigen::MatrixXd singleLayer(const SphericalDiffuse<NumericalIntegrator, ProfilePolicy> & /* gf */, const std::vector<Element> & e) const {
-//      // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
-//      double area = e.area();
-//      // Diagonal of S inside the cavity
-//      double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
-//      // "Diagonal" of Coulomb singularity separation coefficient
-//      double coulomb_coeff = gf.coefficientCoulomb(e.center(), e.center());
-//      // "Diagonal" of the image Green's function
-//      double image = gf.imagePotential(e.center(), e.center());
-
-//      return (Sii_I / coulomb_coeff + image);
-        return Eigen::MatrixXd::Zero(e.size(), e.size());
+    Eigen::MatrixXd singleLayer(const SphericalDiffuse<NumericalIntegrator, ProfilePolicy> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
+        PCMSOLVER_ERROR("NumericalIntegrator::singleLayer not implemented yet for SphericalDiffuse");
     }
     template <typename ProfilePolicy>
-    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<NumericalIntegrator, ProfilePolicy> & /* gf */, const std::vector<Element> & e) const {
-//      // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
-//      double area = e.area();
-//      double radius = e.sphere().radius();
-//      // Diagonal of S inside the cavity
-//      double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
-//      // Diagonal of D inside the cavity
-//      double Dii_I = -factor_ * std::sqrt(M_PI/ area) * (1.0 / radius);
-//      // "Diagonal" of Coulomb singularity separation coefficient
-//      double coulomb_coeff = gf.coefficientCoulomb(e.center(), e.center());
-//      // "Diagonal" of the directional derivative of the Coulomb singularity separation coefficient
-//      double coeff_grad = gf.coefficientCoulombDerivative(e.normal(), e.center(), e.center()) / std::pow(coulomb_coeff, 2);
-//      // "Diagonal" of the directional derivative of the image Green's function
-//      double image_grad = gf.imagePotentialDerivative(e.normal(), e.center(), e.center());
-
-//      double eps_r2 = 0.0;
-//      pcm::tie(eps_r2, pcm::ignore) = gf.epsilon(e.center());
-
-//      return eps_r2 * (Dii_I / coulomb_coeff - Sii_I * coeff_grad + image_grad);
-        return Eigen::MatrixXd::Zero(e.size(), e.size());
+    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<NumericalIntegrator, ProfilePolicy> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
+        PCMSOLVER_ERROR("NumericalIntegrator::doubleLayer not implemented yet for SphericalDiffuse");
     }
     /**@}*/
+private:
+    /*! Relative tolerance of the adaptive integration of the diagonal elements, fixed rule when zero */
+    double tolerance_;
+    /*! Quadrature tables of the diagonal elements, shared by the copies of the integrator */
+    pcm::shared_ptr<integrator::QuadratureCache> quadrature_;
+
+    /*! Diagonal elements of S, by the fixed or the adaptive rule */
+    integrator::Diagonal diagonalS(const integrator::KernelS & kernelS) const {
+        return pcm::bind(&NumericalIntegrator::averageS, kernelS, pcm::_1, tolerance_, quadrature_.get());
+    }
+    /*! Diagonal elements of D, by the fixed or the adaptive rule */
+    integrator::Diagonal diagonalD(const integrator::KernelD & kernelD) const {
+        return pcm::bind(&NumericalIntegrator::averageD, kernelD, pcm::_1, tolerance_, quadrature_.get());
+    }
+    /*! The potential at the center of a finite element of a unit charge spread uniformly over it */
+    static double averageS(const integrator::KernelS & kernelS, const Element & e, double tolerance,
+                           integrator::QuadratureCache * cache) {
+        double integral = (tolerance > 0.0) ? integrator::integrateSAdaptive(kernelS, e, tolerance, cache)
+                          : integrator::integrateS<32, 16>(kernelS, e, cache);
+        return integral / e.area();
+    }
+    /*! The potential at the center of a finite element of a unit dipole layer spread uniformly over it */
+    static double averageD(const integrator::KernelD & kernelD, const Element & e, double tolerance,
+                           integrator::QuadratureCache * cache) {
+        double integral = (tolerance > 0.0) ? integrator::integrateDAdaptive(kernelD, e, tolerance, cache)
+                          : integrator::integrateD<32, 16>(kernelD, e, cache);
+        return integral / e.area();
+    }
 };
 
 #endif // NUMERICALINTEGRATOR_HPP
@@ -66,26 +66,33 @@ struct PurisimaIntegrator
 {
     PurisimaIntegrator() : factor_(1.07) {}
     ~PurisimaIntegrator() {}
+    /*! The diagonal elements of D are obtained from the sum rule over the other finite elements,
+     *  except for the SphericalDiffuse Green's function
+     */
+    static const bool sumRuleDiagonal = true;
+    /*! Returns the parameter of the integration of the diagonal elements, the scaling factor */
+    double parameter() const { return factor_; }
 
     /**@{ Single and double layer potentials for a Vacuum Green's function by collocation */
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, PurisimaIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::singleLayer(e,
-                pcm::bind(integrator::SI, this->factor_, 1.0, pcm::_1),
-                pcm::bind(&Vacuum<DerivativeTraits, PurisimaIntegrator>::kernelS, gf, pcm::_1, pcm::_2));
+    Eigen::MatrixXd singleLayer(const Vacuum<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::singleLayerCoulomb(e,
+                pcm::bind(integrator::SI, this->factor_, 1.0, pcm::_1), 1.0, nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, PurisimaIntegrator> & gf, const std::vector<Element> & e) const {
-        // Obtain off-diagonal first
-        Eigen::MatrixXd D = offDiagonalD(e, pcm::bind(&Vacuum<DerivativeTraits, PurisimaIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3));
+    Eigen::MatrixXd doubleLayer(const Vacuum<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        // Obtain off-diagonal first, the collocation diagonal is overwritten
+        Eigen::MatrixXd D = integrator::doubleLayerCoulomb(e, pcm::bind(integrator::DI, this->factor_, pcm::_1), nRows);
         // Fill diagonal based on Purisima's formula
         Eigen::VectorXd D_diag = diagonalD(e, D);
         D.diagonal() = D_diag;
@@ -97,21 +104,22 @@ struct PurisimaIntegrator
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, PurisimaIntegrator> & gf, const std::vector<Element> & e) const {
-        return integrator::singleLayer(e,
-                pcm::bind(integrator::SI, this->factor_, gf.epsilon(), pcm::_1),
-                pcm::bind(&UniformDielectric<DerivativeTraits, PurisimaIntegrator>::kernelS, gf, pcm::_1, pcm::_2));
+    Eigen::MatrixXd singleLayer(const UniformDielectric<DerivativeTraits, PurisimaIntegrator> & gf, const std::vector<Element> & e, size_t nRows) const {
+        return integrator::singleLayerCoulomb(e,
+                pcm::bind(integrator::SI, this->factor_, gf.epsilon(), pcm::_1), gf.epsilon(), nRows);
     }
     /*! \tparam DerivativeTraits how the derivatives of the Greens's function are calculated
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, PurisimaIntegrator> & gf, const std::vector<Element> & e) const {
-        // Obtain off-diagonal first
-        Eigen::MatrixXd D = offDiagonalD(e, pcm::bind(&UniformDielectric<DerivativeTraits, PurisimaIntegrator>::kernelD, gf, pcm::_1, pcm::_2, pcm::_3));
+    Eigen::MatrixXd doubleLayer(const UniformDielectric<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & e, size_t nRows) const {
+        // Obtain off-diagonal first, the collocation diagonal is overwritten
+        Eigen::MatrixXd D = integrator::doubleLayerCoulomb(e, pcm::bind(integrator::DI, this->factor_, pcm::_1), nRows);
         // Fill diagonal based on Purisima's formula
         Eigen::VectorXd D_diag = diagonalD(e, D);
         D.diagonal() = D_diag;
@@ -121,22 +129,22 @@ struct PurisimaIntegrator
 
     /**@{ Single and double layer potentials for a IonicLiquid Green's function by collocation */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd singleLayer(const IonicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("PurisimaIntegrator::singleLayer not implemented yet for IonicLiquid");
     }
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd doubleLayer(const IonicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("PurisimaIntegrator::doubleLayer not implemented yet for IonicLiquid");
     }
     /**@}*/
 
     /**@{ Single and double layer potentials for an AnisotropicLiquid Green's function by collocation */
     template <typename DerivativeTraits>
-    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd singleLayer(const AnisotropicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("PurisimaIntegrator::singleLayer not implemented yet for AnisotropicLiquid");
     }
     template <typename DerivativeTraits>
-    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */) const {
+    Eigen::MatrixXd doubleLayer(const AnisotropicLiquid<DerivativeTraits, PurisimaIntegrator> & /* gf */, const std::vector<Element> & /* e */, size_t /* nRows */) const {
         PCMSOLVER_ERROR("PurisimaIntegrator::doubleLayer not implemented yet for AnisotropicLiquid");
     }
     /**@}*/
@@ -145,97 +153,96 @@ struct PurisimaIntegrator
     /*! \tparam ProfilePolicy the permittivity profile for the diffuse interface
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename ProfilePolicy>
-    Eigen::MatrixXd singleLayer(const SphericalDiffuse<PurisimaIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd singleLayer(const SphericalDiffuse<PurisimaIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e, size_t nRows) const {
         // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
         size_t mat_size = e.size();
-        Eigen::MatrixXd S = Eigen::MatrixXd::Zero(mat_size, mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
-            // Fill diagonal
-            // Diagonal of S inside the cavity
-            double Sii_I = factor_ * std::sqrt(4 * M_PI / e[i].area());
-            // "Diagonal" of Coulomb singularity separation coefficient
-            double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
-            // "Diagonal" of the image Green's function
-            double image = gf.imagePotential(e[i].center(), e[i].center());
-            S(i, i) = Sii_I / coulomb_coeff + image;
-            Eigen::Vector3d source = e[i].center();
-            for (size_t j = 0; j < mat_size; ++j) {
-                // Fill off-diagonal
-                Eigen::Vector3d probe = e[j].center();
-                if (i != j) S(i, j) = gf.kernelS(source, probe);
+        Eigen::MatrixXd S = Eigen::MatrixXd::Zero(nRows, mat_size);
+        ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < nRows; ++i) {
+            try {
+                // Fill diagonal
+                // Diagonal of S inside the cavity
+                double Sii_I = factor_ * std::sqrt(4 * M_PI / e[i].area());
+                // "Diagonal" of Coulomb singularity separation coefficient
+                double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
+                // "Diagonal" of the image Green's function
+                double image = gf.imagePotential(e[i].center(), e[i].center());
+                S(i, i) = Sii_I / coulomb_coeff + image;
+                Eigen::Vector3d source = e[i].center();
+                for (size_t j = 0; j < mat_size; ++j) {
+                    // Fill off-diagonal
+                    Eigen::Vector3d probe = e[j].center();
+                    if (i != j) S(i, j) = gf.kernelS(source, probe);
+                }
+            } catch (const std::exception & e) {
+                error.record(e);
             }
         }
+        error.raise();
         return S;
     }
     /*! \tparam ProfilePolicy the permittivity profile for the diffuse interface
      *  \param[in] gf Green's function
      *  \param[in] e  list of finite elements
+     *  \param[in] nRows number of rows, the first nRows elements are the source points
      */
     template <typename ProfilePolicy>
-    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<PurisimaIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e) const {
+    Eigen::MatrixXd doubleLayer(const SphericalDiffuse<PurisimaIntegrator, ProfilePolicy> & gf, const std::vector<Element> & e, size_t nRows) const {
         // The singular part is "integrated" as usual, while the nonsingular part is evaluated in full
         size_t mat_size = e.size();
-        Eigen::MatrixXd D = Eigen::MatrixXd::Zero(mat_size, mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
-            // Fill diagonal
-            double area = e[i].area();
-            double radius = e[i].sphere().radius();
-            // Diagonal of S inside the cavity
-            double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
-            // Diagonal of D inside the cavity
-            double Dii_I = -factor_ * std::sqrt(M_PI/ area) * (1.0 / radius);
-            // "Diagonal" of Coulomb singularity separation coefficient
-            double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
-            // "Diagonal" of the directional derivative of the Coulomb singularity separation coefficient
-            double coeff_grad = gf.coefficientCoulombDerivative(e[i].normal(), e[i].center(), e[i].center()) / std::pow(coulomb_coeff, 2);
-            // "Diagonal" of the directional derivative of the image Green's function
-            double image_grad = gf.imagePotentialDerivative(e[i].normal(), e[i].center(), e[i].center());
+        Eigen::MatrixXd D = Eigen::MatrixXd::Zero(nRows, mat_size);
+        ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < nRows; ++i) {
+            try {
+                // Fill diagonal
+                double area = e[i].area();
+                double radius = e[i].sphere().radius();
+                // Diagonal of S inside the cavity
+                double Sii_I = factor_ * std::sqrt(4 * M_PI / area);
+                // Diagonal of D inside the cavity
+                double Dii_I = -factor_ * std::sqrt(M_PI/ area) * (1.0 / radius);
+                // "Diagonal" of Coulomb singularity separation coefficient
+                double coulomb_coeff = gf.coefficientCoulomb(e[i].center(), e[i].center());
+                // "Diagonal" of the directional derivative of the Coulomb singularity separation coefficient
+                double coeff_grad = gf.coefficientCoulombDerivative(e[i].normal(), e[i].center(), e[i].center()) / std::pow(coulomb_coeff, 2);
+                // "Diagonal" of the directional derivative of the image Green's function
+                double image_grad = gf.imagePotentialDerivative(e[i].normal(), e[i].center(), e[i].center());
 
-            double eps_r2 = 0.0;
-            pcm::tie(eps_r2, pcm::ignore) = gf.epsilon(e[i].center());
+                double eps_r2 = 0.0;
+                pcm::tie(eps_r2, pcm::ignore) = gf.epsilon(e[i].center());
 
-            D(i, i) = eps_r2 * (Dii_I / coulomb_coeff - Sii_I * coeff_grad + image_grad);
-            Eigen::Vector3d source = e[i].center();
-            for (size_t j = 0; j < mat_size; ++j) {
-                // Fill off-diagonal
-                Eigen::Vector3d probe = e[j].center();
-                Eigen::Vector3d probeNormal = e[j].normal();
-                probeNormal.normalize();
-                if (i != j) D(i, j) = gf.kernelD(probeNormal, source, probe);
+                D(i, i) = eps_r2 * (Dii_I / coulomb_coeff - Sii_I * coeff_grad + image_grad);
+                Eigen::Vector3d source = e[i].center();
+                for (size_t j = 0; j < mat_size; ++j) {
+                    // Fill off-diagonal
+                    Eigen::Vector3d probe = e[j].center();
+                    Eigen::Vector3d probeNormal = e[j].normal();
+                    probeNormal.normalize();
+                    if (i != j) D(i, j) = gf.kernelD(probeNormal, source, probe);
+                }
+            } catch (const std::exception & e) {
+                error.record(e);
             }
         }
+        error.raise();
         return D;
     }
     /**@}*/
 
     /// Scaling factor for the collocation formulas
     double factor_;
-    /*! Returns off-diagonal elements of the matrix representation of the double layer operator by collocation
-     *  \param[in] elements list of finite elements
-     *  \param[in] kernD    function for the evaluation of the off-diagonal of D
-     */
-    Eigen::MatrixXd offDiagonalD(const std::vector<Element> & elements,
-            const integrator::KernelD & kernD) const
-    {
-        size_t mat_size = elements.size();
-        Eigen::MatrixXd D = Eigen::MatrixXd::Zero(mat_size, mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
-            Eigen::Vector3d source = elements[i].center();
-            for (size_t j = 0; j < mat_size; ++j) {
-                // Fill off-diagonal
-                Eigen::Vector3d probe = elements[j].center();
-                Eigen::Vector3d probeNormal = elements[j].normal();
-                probeNormal.normalize();
-                if (i != j) D(i, j) = kernD(probeNormal, source, probe);
-            }
-        }
-        return D;
-    }
     /*! Returns diagonal elements of the matrix representation of the double layer operator by collocation
      *  \param[in] elements list of finite elements
-     *  \param[in] D         the matrix representation of the double layer operator
+     *  \param[in] D         the matrix representation of the double layer operator, possibly only its first rows
      *  \f[
      *  	D_{ii} = -\left(2\pi + \sum_{j\neq i}D_{ij}a_j \right)\frac{1}{a_i}
      *  \f]
@@ -243,8 +250,12 @@ struct PurisimaIntegrator
     Eigen::VectorXd diagonalD(const std::vector<Element> & elements, const Eigen::MatrixXd & D) const
     {
         size_t mat_size = elements.size();
-        Eigen::VectorXd D_diag = Eigen::VectorXd::Zero(mat_size);
-        for (size_t i = 0; i < mat_size; ++i) {
+        size_t nRows = D.rows();
+        Eigen::VectorXd D_diag = Eigen::VectorXd::Zero(nRows);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < nRows; ++i) {
             double D_ii = 0.0;
             for (size_t j = 0; j < mat_size; ++j) {
                 if (j != i) D_ii += D(i, j) * elements[j].area();
@@ -86,8 +86,9 @@ void Cavity::loadCavity(const std::string & fname)
 {
     // We initialize molecule_ to a dummy Molecule
     molecule_ = Molecule();
-    // Load the .npz binary file and then traverse it to get the data needed to rebuild the cavity.
-    cnpy::npz_t loaded_cavity = cnpy::npz_load(fname);
+    // Memory-map the .npz binary file and then traverse it to get the data needed to rebuild the cavity.
+    // The arrays are copied straight from the mapping, no intermediate buffer is allocated.
+    cnpy::npz_mmap_t loaded_cavity(fname);
     // 0. Get the number of elements
     cnpy::NpyArray raw_ele = loaded_cavity["elements"];
     int * ne = reinterpret_cast<int*>(raw_ele.data);
@@ -102,7 +103,7 @@ void Cavity::loadCavity(const std::string & fname)
     if (dim != nElements_) {
         PCMSOLVER_ERROR("A problem occurred while loading the cavity. Inconsistent dimension of weights vector!");
     } else {
-        elementArea_ = getFromRawBuffer<double>(dim, 1, raw_weights.data);
+        elementArea_ = Eigen::Map<Eigen::VectorXd>(reinterpret_cast<double *>(raw_weights.data), dim);
     }
 
     // 2. Get the element sphere center
@@ -111,7 +112,7 @@ void Cavity::loadCavity(const std::string & fname)
     if (dim != nElements_) {
         PCMSOLVER_ERROR("A problem occurred while loading the cavity. Inconsistent dimension of element sphere radius matrix!");
     } else {
-        elementSphereCenter_ = getFromRawBuffer<double>(3, dim, raw_elSphCenter.data);
+        elementSphereCenter_ = Eigen::Map<Eigen::Matrix3Xd>(reinterpret_cast<double *>(raw_elSphCenter.data), 3, dim);
     }
 
     // 3. Get the element radius
@@ -120,7 +121,7 @@ void Cavity::loadCavity(const std::string & fname)
     if (dim != nElements_) {
         PCMSOLVER_ERROR("A problem occurred while loading the cavity. Inconsistent dimension of element radius vector!");
     } else {
-        elementRadius_ = getFromRawBuffer<double>(dim, 1, raw_elRadius.data);
+        elementRadius_ = Eigen::Map<Eigen::VectorXd>(reinterpret_cast<double *>(raw_elRadius.data), dim);
     }
 
     // 4. Get the centers
@@ -129,7 +130,7 @@ void Cavity::loadCavity(const std::string & fname)
     if (dim != nElements_) {
         PCMSOLVER_ERROR("A problem occurred while loading the cavity. Inconsistent dimension of centers matrix!");
     } else {
-        elementCenter_ = getFromRawBuffer<double>(3, dim, raw_centers.data);
+        elementCenter_ = Eigen::Map<Eigen::Matrix3Xd>(reinterpret_cast<double *>(raw_centers.data), 3, dim);
     }
 
     // 5. Get the normal vectors
@@ -138,7 +139,7 @@ void Cavity::loadCavity(const std::string & fname)
     if (dim != nElements_) {
         PCMSOLVER_ERROR("A problem occurred while loading the cavity. Inconsistent dimension of normals matrix!");
     } else {
-        elementNormal_ = getFromRawBuffer<double>(3, dim, raw_normals.data);
+        elementNormal_ = Eigen::Map<Eigen::Matrix3Xd>(reinterpret_cast<double *>(raw_normals.data), 3, dim);
     }
 
     // Reconstruct the elements_ vector
@@ -38,6 +38,7 @@ class Element;
 
 #include "Anisotropic.hpp"
 #include "GreensFunction.hpp"
+#include "GreensFunctionTraits.hpp"
 
 /*! \file AnisotropicLiquid.hpp
  *  \class AnisotropicLiquid
@@ -56,10 +57,12 @@ class AnisotropicLiquid __final : public GreensFunction<DerivativeTraits, Integr
 public:
     /*! \param[in] eigen_eps eigenvalues of the permittivity tensors
      *  \param[in] euler_ang Euler angles in degrees
+     *  \param[in] integrator policy for the calculation of the matrix representation of S and D
      */
-    AnisotropicLiquid(const Eigen::Vector3d & eigen_eps, const Eigen::Vector3d & euler_ang) :
+    AnisotropicLiquid(const Eigen::Vector3d & eigen_eps, const Eigen::Vector3d & euler_ang,
+            const IntegratorPolicy & integrator = IntegratorPolicy()) :
         GreensFunction<DerivativeTraits, IntegratorPolicy, Anisotropic,
-                  AnisotropicLiquid<DerivativeTraits, IntegratorPolicy> >() { this->profile_ = Anisotropic(eigen_eps, euler_ang); }
+                  AnisotropicLiquid<DerivativeTraits, IntegratorPolicy> >(integrator) { this->profile_ = Anisotropic(eigen_eps, euler_ang); }
     virtual ~AnisotropicLiquid() {}
 
     /*! Calculates the matrix representation of the S operator
@@ -67,14 +70,46 @@ public:
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
+    }
+
+    /*! Returns the gradient of the Green's function with respect to the probe point,
+     *  in closed form: \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2) = \frac{\boldsymbol{\varepsilon}^{-1}\mathbf{d}}{\sqrt{\det\boldsymbol{\varepsilon}}(\mathbf{d}^t\boldsymbol{\varepsilon}^{-1}\mathbf{d})^{3/2}}\f$
+     *  where \f$ \mathbf{d} = \mathbf{p}_1 - \mathbf{p}_2 \f$
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradient(const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const
+    {
+        Eigen::Vector3d d = p1 - p2;
+        Eigen::Vector3d scratch = this->profile_.epsilonInv() * d;
+        double distance = std::sqrt(d.dot(scratch));
+        return (scratch / (std::sqrt(this->profile_.detEps()) * distance * distance * distance));
     }
 
     friend std::ostream & operator<<(std::ostream & os, AnisotropicLiquid & gf) {
@@ -127,4 +162,10 @@ private:
     }
 };
 
+template <typename DerivativeTraits, typename IntegratorPolicy>
+struct SymmetricKernel<AnisotropicLiquid<DerivativeTraits, IntegratorPolicy> >
+{
+    static const bool value = true;
+};
+
 #endif // ANISOTROPICLIQUID_HPP
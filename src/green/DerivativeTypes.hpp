@@ -36,8 +36,12 @@ typedef double               Numerical;
 typedef taylor<double, 1, 1> AD_directional;
 typedef taylor<double, 3, 1> AD_gradient;
 typedef taylor<double, 3, 2> AD_hessian;
+/*! Function values only, the derivatives are evaluated in closed form
+ *  by the Green's function. See the specialization of GreensFunction
+ */
+typedef taylor<double, 1, 0> Analytic;
 
-typedef boost::mpl::vector<Numerical, AD_directional, AD_gradient, AD_hessian>
+typedef boost::mpl::vector<Numerical, AD_directional, AD_gradient, AD_hessian, Analytic>
 derivative_types;
 
 #endif // DERIVATIVETYPES_HPP
@@ -53,7 +53,9 @@ template <typename DerivativeTraits,
 class GreensFunction: public IGreensFunction
 {
 public:
-    GreensFunction() : delta_(1.0e-04), integrator_(IntegratorPolicy()) {}
+    /*! \param[in] integrator policy for the calculation of the matrix representation of S and D */
+    explicit GreensFunction(const IntegratorPolicy & integrator = IntegratorPolicy())
+        : delta_(1.0e-04), integrator_(integrator) {}
     virtual ~GreensFunction() {}
     /*! Returns value of the directional derivative of the
      *  Greens's function for the pair of points p1, p2:
@@ -122,6 +124,10 @@ public:
     virtual bool uniform() const __final __override { return profiles::uniform(this->profile_); }
     /*! Returns a dielectric permittivity profile */
     virtual Permittivity permittivity() const __final __override { return this->profile_; }
+    /*! Whether the integrator obtains the diagonal of D from the sum rule over the other finite elements */
+    virtual bool sumRuleDiagonal() const __final __override { return IntegratorPolicy::sumRuleDiagonal; }
+    /*! Returns the parameter of the integrator of the diagonal elements */
+    virtual double integratorParameter() const __final __override { return this->integrator_.parameter(); }
 
     friend std::ostream & operator<<(std::ostream & os, GreensFunction & gf) {
         return gf.printObject(os);
@@ -162,7 +168,9 @@ template <typename IntegratorPolicy,
 class GreensFunction<Numerical, IntegratorPolicy, ProfilePolicy, Derived>: public IGreensFunction
 {
 public:
-    GreensFunction() : delta_(1.0e-04), integrator_(IntegratorPolicy()) {}
+    /*! \param[in] integrator policy for the calculation of the matrix representation of S and D */
+    explicit GreensFunction(const IntegratorPolicy & integrator = IntegratorPolicy())
+        : delta_(1.0e-04), integrator_(integrator) {}
     virtual ~GreensFunction() {}
     /*! Returns value of the directional derivative of the
      *  Greens's function for the pair of points p1, p2:
@@ -225,6 +233,10 @@ public:
     virtual bool uniform() const __final __override { return profiles::uniform(this->profile_); }
     /*! Returns a dielectric permittivity profile */
     virtual Permittivity permittivity() const __final __override { return this->profile_; }
+    /*! Whether the integrator obtains the diagonal of D from the sum rule over the other finite elements */
+    virtual bool sumRuleDiagonal() const __final __override { return IntegratorPolicy::sumRuleDiagonal; }
+    /*! Returns the parameter of the integrator of the diagonal elements */
+    virtual double integratorParameter() const __final __override { return this->integrator_.parameter(); }
 
     friend std::ostream & operator<<(std::ostream & os, GreensFunction & gf) {
         return gf.printObject(os);
@@ -256,4 +268,116 @@ protected:
     ProfilePolicy profile_;
 };
 
+/*! \brief Specialization for closed-form derivatives
+ *
+ *  The function is evaluated in double precision, with no derivative coefficients
+ *  carried along. The gradient with respect to the probe point is obtained from the
+ *  gradient method of the Derived class, which has to be implemented in closed form.
+ *  The Green's functions for which this specialization is available depend only on
+ *  the difference of source and probe points, thus
+ *  \f$ \nabla_{\mathbf{p_1}}G(\mathbf{p}_1, \mathbf{p}_2) = -\nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2)\f$
+ */
+template <typename IntegratorPolicy,
+          typename ProfilePolicy,
+          typename Derived>
+class GreensFunction<Analytic, IntegratorPolicy, ProfilePolicy, Derived>: public IGreensFunction
+{
+public:
+    /*! \param[in] integrator policy for the calculation of the matrix representation of S and D */
+    explicit GreensFunction(const IntegratorPolicy & integrator = IntegratorPolicy())
+        : delta_(1.0e-04), integrator_(integrator) {}
+    virtual ~GreensFunction() {}
+    /*! Returns value of the directional derivative of the
+     *  Greens's function for the pair of points p1, p2:
+     *  \f$ \nabla_{\mathbf{p_1}}G(\mathbf{p}_1, \mathbf{p}_2)\cdot \mathbf{n}_{\mathbf{p}_1}\f$
+     *  Notice that this method returns the directional derivative with respect
+     *  to the source point.
+     *  \param[in] normal_p1 the normal vector to p1
+     *  \param[in]        p1 first point
+     *  \param[in]        p2 second point
+     */
+    virtual double derivativeSource(const Eigen::Vector3d & normal_p1,
+                            const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const
+    {
+        return -gradientProbe(p1, p2).dot(normal_p1);
+    }
+    /*! Returns value of the directional derivative of the
+     *  Greens's function for the pair of points p1, p2:
+     *  \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2)\cdot \mathbf{n}_{\mathbf{p}_2}\f$
+     *  Notice that this method returns the directional derivative with respect
+     *  to the probe point.
+     *  \param[in] normal_p2 the normal vector to p2
+     *  \param[in]        p1 first point
+     *  \param[in]        p2 second point
+     */
+    virtual double derivativeProbe(const Eigen::Vector3d & normal_p2,
+                                   const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const __final
+    {
+        return gradientProbe(p1, p2).dot(normal_p2);
+    }
+    /*! Returns full gradient of Greens's function for the pair of points p1, p2:
+     *  \f$ \nabla_{\mathbf{p_1}}G(\mathbf{p}_1, \mathbf{p}_2)\f$
+     *  Notice that this method returns the gradient with respect to the source point.
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradientSource(const Eigen::Vector3d & p1,
+                                           const Eigen::Vector3d & p2) const
+    {
+        return -gradientProbe(p1, p2);
+    }
+    /*! Returns full gradient of Greens's function for the pair of points p1, p2:
+     *  \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2)\f$
+     *  Notice that this method returns the gradient with respect to the probe point.
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradientProbe(const Eigen::Vector3d & p1,
+                                          const Eigen::Vector3d & p2) const
+    {
+        return static_cast<const Derived *>(this)->gradient(p1, p2);
+    }
+
+    /*! Whether the Green's function describes a uniform environment */
+    virtual bool uniform() const __final __override { return profiles::uniform(this->profile_); }
+    /*! Returns a dielectric permittivity profile */
+    virtual Permittivity permittivity() const __final __override { return this->profile_; }
+    /*! Whether the integrator obtains the diagonal of D from the sum rule over the other finite elements */
+    virtual bool sumRuleDiagonal() const __final __override { return IntegratorPolicy::sumRuleDiagonal; }
+    /*! Returns the parameter of the integrator of the diagonal elements */
+    virtual double integratorParameter() const __final __override { return this->integrator_.parameter(); }
+
+    friend std::ostream & operator<<(std::ostream & os, GreensFunction & gf) {
+        return gf.printObject(os);
+    }
+protected:
+    /*! Evaluates the Green's function given a pair of points
+     *  \param[in] source the source point
+     *  \param[in]  probe the probe point
+     */
+    virtual Analytic operator()(Analytic * source, Analytic * probe) const = 0;
+    /*! Returns value of the kernel of the \f$\mathcal{S}\f$ integral operator, i.e. the value of the
+     *  Greens's function for the pair of points p1, p2: \f$ G(\mathbf{p}_1, \mathbf{p}_2)\f$
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     *  \note Relies on the implementation of operator() in the subclasses and that is all subclasses
+     *  need to implement. Thus this method is marked __final.
+     */
+    virtual double kernelS_impl(const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const __final __override
+    {
+        Analytic sp[3], pp[3];
+        sp[0] = p1(0); sp[1] = p1(1); sp[2] = p1(2);
+        pp[0] = p2(0); pp[1] = p2(1); pp[2] = p2(2);
+        return this->operator()(sp, pp)[0];
+    }
+    virtual std::ostream & printObject(std::ostream & os) __override
+    {
+        os << "Green's Function" << std::endl;
+        return os;
+    }
+    double delta_;
+    IntegratorPolicy integrator_;
+    ProfilePolicy profile_;
+};
+
 #endif // GREENSFUNCTION_HPP
@@ -0,0 +1,51 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *     
+ *     This file is part of PCMSolver.
+ *     
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *     
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *     
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *     
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef GREENSFUNCTIONTRAITS_HPP
+#define GREENSFUNCTIONTRAITS_HPP
+
+#include "Config.hpp"
+
+/*! \file GreensFunctionTraits.hpp
+ *  \struct SymmetricKernel
+ *  \brief Whether the kernel of the single layer operator is symmetric
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *  \tparam GreensFunction the type of the Green's function
+ *
+ *  The kernel is symmetric when \f$ G(\mathbf{p}_1, \mathbf{p}_2) = G(\mathbf{p}_2, \mathbf{p}_1) \f$
+ *  holds exactly, also in floating point arithmetic, e.g. when the Green's function
+ *  only depends on a quadratic form of \f$ \mathbf{p}_1 - \mathbf{p}_2 \f$.
+ *  The generic assembly of the S matrix, integrator::singleLayer for a Green's function,
+ *  then evaluates only one triangle. The choice is made at compile time.
+ *  The trait is false by default and specialized in the header of each Green's function.
+ */
+template <typename GreensFunction>
+struct SymmetricKernel
+{
+    static const bool value = false;
+};
+
+#endif // GREENSFUNCTIONTRAITS_HPP
@@ -76,6 +76,12 @@ public:
     virtual bool uniform() const = 0;
     /*! Returns a dielectric permittivity profile */
     virtual Permittivity permittivity() const = 0;
+    /*! Whether the integrator obtains the diagonal of D from the sum rule over the other finite elements */
+    virtual bool sumRuleDiagonal() const = 0;
+    /*! Returns the parameter of the integrator of the diagonal elements,
+     *  e.g. the tolerance of the adaptive numerical integration
+     */
+    virtual double integratorParameter() const = 0;
 
     /*! Calculates the matrix representation of the S operator
      *  \param[in] e list of finite elements
@@ -85,6 +91,24 @@ public:
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const = 0;
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     *
+     *  When the finite elements are ordered by irreducible representation,
+     *  these are the only rows needed to build the symmetry blocked operator.
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const = 0;
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     *
+     *  When the finite elements are ordered by irreducible representation,
+     *  these are the only rows needed to build the symmetry blocked operator.
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const = 0;
 
     friend std::ostream & operator<<(std::ostream & os, IGreensFunction & gf) {
         return gf.printObject(os);
@@ -38,6 +38,7 @@ class Element;
 
 #include "DerivativeUtils.hpp"
 #include "GreensFunction.hpp"
+#include "GreensFunctionTraits.hpp"
 #include "Yukawa.hpp"
 
 /*! \file IonicLiquid.hpp
@@ -55,8 +56,13 @@ class IonicLiquid __final : public GreensFunction<DerivativeTraits, IntegratorPo
                                      IonicLiquid<DerivativeTraits, IntegratorPolicy> >
 {
 public:
-    IonicLiquid(double eps, double k) : GreensFunction<DerivativeTraits, IntegratorPolicy, Yukawa,
-                                                  IonicLiquid<DerivativeTraits, IntegratorPolicy> >() { this->profile_ = Yukawa(eps, k); }
+    /*! \param[in] eps        permittivity
+     *  \param[in] k          inverse of the Debye length
+     *  \param[in] integrator policy for the calculation of the matrix representation of S and D
+     */
+    IonicLiquid(double eps, double k, const IntegratorPolicy & integrator = IntegratorPolicy())
+        : GreensFunction<DerivativeTraits, IntegratorPolicy, Yukawa,
+                                                  IonicLiquid<DerivativeTraits, IntegratorPolicy> >(integrator) { this->profile_ = Yukawa(eps, k); }
     virtual ~IonicLiquid() {}
 
     /*! Calculates the matrix representation of the S operator
@@ -64,14 +70,47 @@ public:
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
+    }
+
+    /*! Returns the gradient of the Green's function with respect to the probe point,
+     *  in closed form: \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2) = \frac{\mathrm{e}^{-\kappa r}(1 + \kappa r)}{\varepsilon r^3}(\mathbf{p}_1 - \mathbf{p}_2)\f$
+     *  where \f$ r = |\mathbf{p}_1 - \mathbf{p}_2| \f$
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradient(const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const
+    {
+        double eps = this->profile_.epsilon;
+        double k = this->profile_.kappa;
+        Eigen::Vector3d d = p1 - p2;
+        double r = d.norm();
+        return (std::exp(-k * r) * (1.0 + k * r) / (eps * r * r * r) * d);
     }
 
     friend std::ostream & operator<<(std::ostream & os, IonicLiquid & gf) {
@@ -112,4 +151,10 @@ private:
     }
 };
 
+template <typename DerivativeTraits, typename IntegratorPolicy>
+struct SymmetricKernel<IonicLiquid<DerivativeTraits, IntegratorPolicy> >
+{
+    static const bool value = true;
+};
+
 #endif // IONICLIQUID_HPP
@@ -48,13 +48,25 @@
  *  This, however, lead to intricate inclusion dependencies.
  */
 
+namespace
+{
+    /*! The integrator policy, only the numerical integrator takes parameters from the input */
+    template <typename U>
+    U buildIntegrator(const greenData & /* data */) { return U(); }
+
+    template <>
+    NumericalIntegrator buildIntegrator<NumericalIntegrator>(const greenData & data) {
+        return NumericalIntegrator(data.integratorTolerance);
+    }
+}
+
 namespace
 {
     struct buildVacuum
     {
         template <typename T, typename U>
-        IGreensFunction * operator()(const greenData & /* data */) {
-            return new Vacuum<T, U>();
+        IGreensFunction * operator()(const greenData & data) {
+            return new Vacuum<T, U>(buildIntegrator<U>(data));
         }
     };
 
@@ -74,7 +86,7 @@ namespace
     struct buildUniformDielectric {
         template <typename T, typename U>
         IGreensFunction * operator()(const greenData & data) {
-            return new UniformDielectric<T, U>(data.epsilon);
+            return new UniformDielectric<T, U>(data.epsilon, buildIntegrator<U>(data));
         }
     };
 
@@ -94,7 +106,7 @@ namespace
     struct buildIonicLiquid {
         template <typename T, typename U>
         IGreensFunction * operator()(const greenData & data) {
-            return new IonicLiquid<T, U>(data.epsilon, data.kappa);
+            return new IonicLiquid<T, U>(data.epsilon, data.kappa, buildIntegrator<U>(data));
         }
     };
 
@@ -114,7 +126,7 @@ namespace
     struct buildAnisotropicLiquid {
         template <typename T, typename U>
         IGreensFunction * operator()(const greenData & data) {
-            return new AnisotropicLiquid<T, U>(data.epsilonTensor, data.eulerAngles);
+            return new AnisotropicLiquid<T, U>(data.epsilonTensor, data.eulerAngles, buildIntegrator<U>(data));
         }
     };
 
@@ -27,7 +27,9 @@
 #define SPHERICALDIFFUSE_HPP
 
 #include <cmath>
+#include <deque>
 #include <iosfwd>
+#include <map>
 #include <vector>
 
 #include "Config.hpp"
@@ -37,12 +39,79 @@
 // Has to be included here
 #include "InterfacesImpl.hpp"
 #include "RadialFunction.hpp"
-// Boost.Math includes
-#include <boost/math/special_functions/legendre.hpp>
 
 #include "GreensFunction.hpp"
 #include "MathUtils.hpp"
 
+namespace interfaces {
+/*! \struct RadialSolutions
+ *  \brief Radial solutions for the Green's function and the coefficient
+ */
+struct RadialSolutions {
+    RadialFunction<StateType, LnTransformedRadial, Zeta> zetaC;
+    RadialFunction<StateType, LnTransformedRadial, Omega> omegaC;
+    std::vector<RadialFunction<StateType, LnTransformedRadial, Zeta> > zeta;
+    std::vector<RadialFunction<StateType, LnTransformedRadial, Omega> > omega;
+};
+
+/*! \class RadialCache
+ *  \brief In-process cache of the radial solutions of the spherical diffuse Green's functions
+ *  \tparam ProfilePolicy functional form of the diffuse layer
+ *
+ *  The integration of the radial equations is the most expensive step in the set up.
+ *  The solutions are keyed by the parameters of the profile and the maximum angular momenta:
+ *  Green's functions for the same medium, e.g. for subsequent contexts or geometries within
+ *  the same process, reuse them. The static and dynamic Green's functions differ
+ *  in the permittivities, hence do not share them.
+ *  At most capacity profiles are kept, the oldest one is released first.
+ *  \warning The cache is not thread-safe, Green's functions have to be constructed serially.
+ */
+template <typename ProfilePolicy>
+class RadialCache __final
+{
+public:
+    typedef std::vector<double> Key;
+    /*! Maximum number of profiles kept */
+    static const size_t capacity = 8;
+    static RadialCache & instance() {
+        static RadialCache cache;
+        return cache;
+    }
+    /*! Returns the radial solutions for the key, null when not in the cache */
+    const RadialSolutions * find(const Key & key) {
+        typename Solutions::const_iterator cached = solutions_.find(key);
+        if (cached == solutions_.end()) return NULL;
+        ++hits_;
+        return &(cached->second);
+    }
+    /*! Keeps the radial solutions for the key, releasing the oldest ones when full */
+    void insert(const Key & key, const RadialSolutions & solutions) {
+        if (!solutions_.insert(std::make_pair(key, solutions)).second) return;
+        order_.push_back(key);
+        if (order_.size() > capacity) {
+            solutions_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+    /*! Releases all the radial solutions */
+    void clear() {
+        solutions_.clear();
+        order_.clear();
+    }
+    /*! Number of profiles kept */
+    size_t size() const { return solutions_.size(); }
+    /*! Number of lookups that found the radial solutions */
+    int hits() const { return hits_; }
+private:
+    RadialCache() : hits_(0) {}
+    typedef std::map<Key, RadialSolutions> Solutions;
+    Solutions solutions_;
+    /*! Keys in order of insertion */
+    std::deque<Key> order_;
+    int hits_;
+};
+} // namespace interfaces
+
 /*! \file SphericalDiffuse.hpp
  *  \class SphericalDiffuse
  *  \brief Green's function for a diffuse interface with spherical symmetry
@@ -87,19 +156,40 @@ public:
     }
     virtual ~SphericalDiffuse() {}
 
+    /*! Releases the radial solutions kept for reuse, see interfaces::RadialCache */
+    static void clearRadialCache() { interfaces::RadialCache<ProfilePolicy>::instance().clear(); }
+
     /*! Calculates the matrix representation of the S operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
     }
 
     friend std::ostream & operator<<(std::ostream & os, SphericalDiffuse & gf) {
@@ -131,12 +221,7 @@ public:
         // Obtain coefficient for the separation of the Coulomb singularity
         double Cr12 = this->coefficient_impl(source, probe);
 
-        double gr12 = 0.0;
-        for (int L = 1; L <= maxLGreen_; ++L) {
-            gr12 += this->imagePotentialComponent_impl(L, source, probe, Cr12);
-        }
-
-        return gr12;
+        return this->imagePotential_impl(source, probe, Cr12);
     }
     /*! Returns value of the directional derivative of the
      *  Coulomb singularity separation coefficient for the pair of points p1, p2:
@@ -210,10 +295,7 @@ private:
         // Obtain coefficient for the separation of the Coulomb singularity
         double Cr12 = this->coefficient_impl(source, probe);
 
-        double gr12 = 0.0;
-        for (int L = 1; L <= maxLGreen_; ++L) {
-            gr12 += this->imagePotentialComponent_impl(L, source, probe, Cr12);
-        }
+        double gr12 = this->imagePotential_impl(source, probe, Cr12);
         double r12 = (source - probe).norm();
 
         return (1.0 / (Cr12 * r12) + gr12);
@@ -270,45 +352,67 @@ private:
         IntegratorParameters params_(eps_abs_, eps_rel_, factor_x_, factor_dxdt_, r_0_, r_infinity_, observer_step_);
         ProfileEvaluator eval_ = pcm::bind(&ProfilePolicy::operator(), this->profile_, pcm::_1);
 
-        LOG("Computing coefficient for the separation of the Coulomb singularity");
-        LOG("Computing first radial solution L = " + pcm::to_string(maxLC_));
-        TIMER_ON("computeZeta for coefficient");
-        zetaC_ = RadialFunction<StateType, LnTransformedRadial, Zeta>(maxLC_, r_0_, r_infinity_, eval_, params_);
-        TIMER_OFF("computeZeta for coefficient");
-        LOG("DONE: Computing first radial solution L = " + pcm::to_string(maxLC_));
-
-        LOG("Computing second radial solution L = " + pcm::to_string(maxLC_));
-        TIMER_ON("computeOmega for coefficient");
-        omegaC_ = RadialFunction<StateType, LnTransformedRadial, Omega>(maxLC_, r_0_, r_infinity_, eval_, params_);
-        TIMER_OFF("computeOmega for coefficient");
-        LOG("Computing second radial solution L = " + pcm::to_string(maxLC_));
-        LOG("DONE: Computing coefficient for the separation of the Coulomb singularity");
-
-        LOG("Computing radial solutions for Green's function");
-        TIMER_ON("SphericalDiffuse: Looping over angular momentum");
-        zeta_.reserve(maxLGreen_+1);
-        omega_.reserve(maxLGreen_+1);
-        for (int L = 0; L <= maxLGreen_; ++L) {
-            // First radial solution
-            LOG("Computing first radial solution L = " + pcm::to_string(L));
-            TIMER_ON("computeZeta L = " + pcm::to_string(L));
-            // Create an empty RadialSolution
-            RadialFunction<StateType, LnTransformedRadial, Zeta> tmp_zeta_(L, r_0_, r_infinity_, eval_, params_);
-            zeta_.push_back(tmp_zeta_);
-            TIMER_OFF("computeZeta L = " + pcm::to_string(L));
-            LOG("DONE: Computing first radial solution L = " + pcm::to_string(L));
-
-            // Second radial solution
-            LOG("Computing second radial solution L = " + pcm::to_string(L));
-            TIMER_ON("computeOmega L = " + pcm::to_string(L));
-            // Create an empty RadialSolution
-            RadialFunction<StateType, LnTransformedRadial, Omega> tmp_omega_(L, r_0_, r_infinity_, eval_, params_);
-            omega_.push_back(tmp_omega_);
-            TIMER_OFF("computeOmega L = " + pcm::to_string(L));
-            LOG("DONE: Computing second radial solution L = " + pcm::to_string(L));
+        // The radial solutions only depend on the profile and on the angular momentum
+        std::vector<double> key;
+        key.push_back(this->profile_.epsilon1());
+        key.push_back(this->profile_.epsilon2());
+        key.push_back(this->profile_.width());
+        key.push_back(this->profile_.center());
+        key.push_back(maxLGreen_);
+        key.push_back(maxLC_);
+        const RadialSolutions * cached = RadialCache<ProfilePolicy>::instance().find(key);
+        if (cached) {
+            LOG("Radial solutions for Green's function and coefficient found in cache");
+            zetaC_ = cached->zetaC;
+            omegaC_ = cached->omegaC;
+            zeta_ = cached->zeta;
+            omega_ = cached->omega;
+            return;
         }
-        TIMER_OFF("SphericalDiffuse: Looping over angular momentum");
-        LOG("DONE: Computing radial solutions for Green's function");
+
+        LOG("Computing radial solutions for Green's function and coefficient");
+        TIMER_ON("SphericalDiffuse: computing radial solutions");
+        // The first and second radial solutions for each angular momentum, and for
+        // the coefficient for the separation of the Coulomb singularity, are independent
+        // Tasks 0 and 1 are the coefficient (L = maxLC_), the slowest to integrate
+        int nChannels = maxLGreen_ + 1;
+        zeta_.resize(nChannels);
+        omega_.resize(nChannels);
+        ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int task = 0; task < 2 * (nChannels + 1); ++task) {
+            try {
+                int L = task / 2 - 1;
+                bool first = (task % 2 == 0);
+                if (L < 0) {
+                    if (first) {
+                        zetaC_ = RadialFunction<StateType, LnTransformedRadial, Zeta>(maxLC_, r_0_, r_infinity_, eval_, params_);
+                    } else {
+                        omegaC_ = RadialFunction<StateType, LnTransformedRadial, Omega>(maxLC_, r_0_, r_infinity_, eval_, params_);
+                    }
+                } else {
+                    if (first) {
+                        zeta_[L] = RadialFunction<StateType, LnTransformedRadial, Zeta>(L, r_0_, r_infinity_, eval_, params_);
+                    } else {
+                        omega_[L] = RadialFunction<StateType, LnTransformedRadial, Omega>(L, r_0_, r_infinity_, eval_, params_);
+                    }
+                }
+            } catch (const std::exception & e) {
+                error.record(e);
+            }
+        }
+        error.raise();
+        TIMER_OFF("SphericalDiffuse: computing radial solutions");
+        LOG("DONE: Computing radial solutions for Green's function and coefficient");
+
+        RadialSolutions solutions;
+        solutions.zetaC = zetaC_;
+        solutions.omegaC = omegaC_;
+        solutions.zeta = zeta_;
+        solutions.omega = omega_;
+        RadialCache<ProfilePolicy>::instance().insert(key, solutions);
     }
 
     /*! Center of the dielectric sphere */
@@ -325,58 +429,63 @@ private:
      *  \note The vector has dimension maxLGreen_  and has r^(-l-1) behavior
      */
     std::vector<RadialFunction<interfaces::StateType, interfaces::LnTransformedRadial, Omega> > omega_;
-    /*! \brief Returns L-th component of the radial part of the Green's function
-     *  \param[in] L  angular momentum
+    /*! \brief Returns the radial part of the Green's function, summed over the angular momentum
      *  \param[in] sp source point
      *  \param[in] pp probe point
      *  \param[in] Cr12 Coulomb singularity separation coefficient
      *  \note This function shifts the given source and probe points by the location of the
      *  dielectric sphere.
+     *
+     *  The geometric quantities and the permittivity are evaluated once for the pair of points.
+     *  The Legendre polynomials \f$ P_L(\cos\gamma) \f$ and the powers \f$ (r_</r_>)^L \f$
+     *  are obtained by upward recurrence while summing over \f$ L \f$
      */
-    double imagePotentialComponent_impl(int L, const Eigen::Vector3d & sp, const Eigen::Vector3d & pp, double Cr12) const {
+    double imagePotential_impl(const Eigen::Vector3d & sp, const Eigen::Vector3d & pp, double Cr12) const {
         Eigen::Vector3d sp_shift = sp + this->origin_;
         Eigen::Vector3d pp_shift = pp + this->origin_;
         double r1 = sp_shift.norm();
         double r2 = pp_shift.norm();
         double cos_gamma = sp_shift.dot(pp_shift) / (r1 * r2);
-        // Evaluate Legendre polynomial of order L
         // First of all clean-up cos_gamma, Legendre polynomials
         // are only defined for -1 <= x <= 1
         if (numericalZero(cos_gamma - 1)) cos_gamma = 1.0;
         if (numericalZero(cos_gamma + 1)) cos_gamma = -1.0;
-        double pl_x = boost::math::legendre_p(L, cos_gamma);
-
-        /* Sample zeta_[L] */
-        double zeta1 = 0.0, zeta2 = 0.0, d_zeta2 = 0.0;
-        /* Value of zeta_[L] at point with index 1 */
-        pcm::tie(zeta1, pcm::ignore) = zeta_[L](r1);
-        /* Value of zeta_[L] and its first derivative at point with index 2 */
-        pcm::tie(zeta2, d_zeta2) = zeta_[L](r2);
-
-        /* Sample omega_[L] */
-        double omega1 = 0.0, omega2 = 0.0, d_omega2 = 0.0;
-        /* Value of omega_[L] at point with index 1 */
-        pcm::tie(omega1, pcm::ignore) = omega_[L](r1);
-        /* Value of omega_[L] and its first derivative at point with index 2 */
-        pcm::tie(omega2, d_omega2) = omega_[L](r2);
 
         double eps_r2 = 0.0;
-        pcm::tie(eps_r2, pcm::ignore) = this->profile_(pp_shift.norm());
+        pcm::tie(eps_r2, pcm::ignore) = this->profile_(r2);
+        double r2_2_eps_r2 = r2 * r2 * eps_r2;
 
-        /* Evaluation of the Wronskian and the denominator */
-        double denominator = (d_zeta2 - d_omega2) * std::pow(r2, 2) * eps_r2;
+        // The radial solutions are sampled in the point closest to the origin
+        // for the zeta_ (r1 < r2) or the omega_ (r1 >= r2) radial solution only
+        bool inner = (r1 < r2);
+        double ratio = inner ? r1 / r2 : r2 / r1;
+        double rMax = inner ? r2 : r1;
 
+        // P_{L-1}, P_L and (r_< / r_>)^L, starting from L = 1
+        double pl_prev = 1.0, pl_x = cos_gamma, f_L = ratio;
         double gr12 = 0.0;
-        if (r1 < r2) {
-            gr12 = std::exp(zeta1 - zeta2) * (2*L +1) / denominator;
-	    double f_L = r1 / r2;
-	    for (int i = 1; i < L; ++i) { f_L *= r1 / r2; }
-            gr12 = (gr12 - f_L / (r2 * Cr12) ) * pl_x ;
-        } else {
-            gr12 = std::exp(omega1 - omega2) * (2*L +1) / denominator;
-	    double f_L = r2 / r1;
-	    for (int i = 1; i < L; ++i) { f_L *= r2 / r1; }
-            gr12 = (gr12 - f_L / (r1 * Cr12) ) * pl_x ;
+        for (int L = 1; L <= maxLGreen_; ++L) {
+            /* Sample zeta_[L] and omega_[L] and their first derivatives at point with index 2 */
+            double zeta2 = 0.0, d_zeta2 = 0.0, omega2 = 0.0, d_omega2 = 0.0;
+            pcm::tie(zeta2, d_zeta2) = zeta_[L](r2);
+            pcm::tie(omega2, d_omega2) = omega_[L](r2);
+            /* Evaluation of the Wronskian and the denominator */
+            double denominator = (d_zeta2 - d_omega2) * r2_2_eps_r2;
+            /* Value of zeta_[L] or omega_[L] at point with index 1 */
+            double radial1 = 0.0;
+            if (inner) {
+                pcm::tie(radial1, pcm::ignore) = zeta_[L](r1);
+                radial1 -= zeta2;
+            } else {
+                pcm::tie(radial1, pcm::ignore) = omega_[L](r1);
+                radial1 -= omega2;
+            }
+            gr12 += (std::exp(radial1) * (2*L + 1) / denominator - f_L / (rMax * Cr12)) * pl_x;
+            // Upward recurrence: (L + 1) P_{L+1}(x) = (2L + 1) x P_L(x) - L P_{L-1}(x)
+            double pl_next = ((2*L + 1) * cos_gamma * pl_x - L * pl_prev) / (L + 1);
+            pl_prev = pl_x;
+            pl_x = pl_next;
+            f_L *= ratio;
         }
 
         return gr12;
@@ -73,14 +73,32 @@ public:
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
     }
 
     /*! \brief Returns non-singular part of the Green's function (image potential)
@@ -38,6 +38,7 @@ class Element;
 
 #include "DerivativeUtils.hpp"
 #include "GreensFunction.hpp"
+#include "GreensFunctionTraits.hpp"
 #include "Uniform.hpp"
 
 /*! \file UniformDielectric.hpp
@@ -55,8 +56,12 @@ class UniformDielectric __final : public GreensFunction<DerivativeTraits, Integr
                                      UniformDielectric<DerivativeTraits, IntegratorPolicy> >
 {
 public:
-    UniformDielectric(double eps) : GreensFunction<DerivativeTraits, IntegratorPolicy, Uniform,
-                              UniformDielectric<DerivativeTraits, IntegratorPolicy> >() { this->profile_ = Uniform(eps); }
+    /*! \param[in] eps        permittivity
+     *  \param[in] integrator policy for the calculation of the matrix representation of S and D
+     */
+    UniformDielectric(double eps, const IntegratorPolicy & integrator = IntegratorPolicy())
+        : GreensFunction<DerivativeTraits, IntegratorPolicy, Uniform,
+                              UniformDielectric<DerivativeTraits, IntegratorPolicy> >(integrator) { this->profile_ = Uniform(eps); }
     virtual ~UniformDielectric() {}
 
     /*! Calculates the matrix representation of the S operator
@@ -64,18 +69,48 @@ public:
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
     }
 
     double epsilon() const { return this->profile_.epsilon; }
 
+    /*! Returns the gradient of the Green's function with respect to the probe point,
+     *  in closed form: \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2) = \frac{\mathbf{p}_1 - \mathbf{p}_2}{\varepsilon|\mathbf{p}_1 - \mathbf{p}_2|^3}\f$
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradient(const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const
+    {
+        Eigen::Vector3d d = p1 - p2;
+        double r = d.norm();
+        return (d / (this->profile_.epsilon * r * r * r));
+    }
+
     friend std::ostream & operator<<(std::ostream & os, UniformDielectric & gf) {
         return gf.printObject(os);
     }
@@ -111,4 +146,10 @@ private:
     }
 };
 
+template <typename DerivativeTraits, typename IntegratorPolicy>
+struct SymmetricKernel<UniformDielectric<DerivativeTraits, IntegratorPolicy> >
+{
+    static const bool value = true;
+};
+
 #endif // UNIFORMDIELECTRIC_HPP
@@ -38,6 +38,7 @@ class Element;
 
 #include "DerivativeUtils.hpp"
 #include "GreensFunction.hpp"
+#include "GreensFunctionTraits.hpp"
 
 /*! \file Vacuum.hpp
  *  \class Vacuum
@@ -54,8 +55,10 @@ class Vacuum __final : public GreensFunction<DerivativeTraits, IntegratorPolicy,
                                      Vacuum<DerivativeTraits, IntegratorPolicy> >
 {
 public:
-    Vacuum() : GreensFunction<DerivativeTraits, IntegratorPolicy, Uniform,
-                              Vacuum<DerivativeTraits, IntegratorPolicy> >()
+    /*! \param[in] integrator policy for the calculation of the matrix representation of S and D */
+    explicit Vacuum(const IntegratorPolicy & integrator = IntegratorPolicy())
+        : GreensFunction<DerivativeTraits, IntegratorPolicy, Uniform,
+                              Vacuum<DerivativeTraits, IntegratorPolicy> >(integrator)
     {
         this->profile_ = Uniform(1.0);
     }
@@ -66,14 +69,44 @@ public:
      */
     virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.singleLayer(*this, e);
+        return this->integrator_.singleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the S operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd singleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.singleLayer(*this, e, nRows);
     }
     /*! Calculates the matrix representation of the D operator
      *  \param[in] e list of finite elements
      */
     virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e) const __override
     {
-        return this->integrator_.doubleLayer(*this, e);
+        return this->integrator_.doubleLayer(*this, e, e.size());
+    }
+    /*! Calculates the rows of the matrix representation of the D operator
+     *  relative to the first nRows finite elements
+     *  \param[in] e list of finite elements
+     *  \param[in] nRows number of rows
+     */
+    virtual Eigen::MatrixXd doubleLayer(const std::vector<Element> & e, size_t nRows) const __override
+    {
+        return this->integrator_.doubleLayer(*this, e, nRows);
+    }
+
+    /*! Returns the gradient of the Green's function with respect to the probe point,
+     *  in closed form: \f$ \nabla_{\mathbf{p_2}}G(\mathbf{p}_1, \mathbf{p}_2) = \frac{\mathbf{p}_1 - \mathbf{p}_2}{|\mathbf{p}_1 - \mathbf{p}_2|^3}\f$
+     *  \param[in] p1 first point
+     *  \param[in] p2 second point
+     */
+    Eigen::Vector3d gradient(const Eigen::Vector3d & p1, const Eigen::Vector3d & p2) const
+    {
+        Eigen::Vector3d d = p1 - p2;
+        double r = d.norm();
+        return (d / (r * r * r));
     }
 
     friend std::ostream & operator<<(std::ostream & os, Vacuum & gf) {
@@ -109,4 +142,10 @@ private:
     }
 };
 
+template <typename DerivativeTraits, typename IntegratorPolicy>
+struct SymmetricKernel<Vacuum<DerivativeTraits, IntegratorPolicy> >
+{
+    static const bool value = true;
+};
+
 #endif // VACUUM_HPP
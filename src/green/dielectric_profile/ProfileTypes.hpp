@@ -90,6 +90,49 @@ namespace profiles {
     inline double epsilon(const Permittivity & arg) {
         return boost::any_cast<double>(boost::apply_visitor(epsilonValue(), arg));
     }
+
+    /*! Ratio of the kernels of the S operator for two profiles, zero when these are not proportional.
+     *  Proportional S kernels come with identical D kernels, since these include the permittivity.
+     *  A uniform profile is equivalent to a Yukawa profile with vanishing inverse Debye length
+     *  and to an anisotropic profile with an isotropic permittivity tensor.
+     */
+    class kernelRatioValue : public boost::static_visitor<double>
+    {
+    public:
+        template <typename T, typename U>
+        double operator()(const T & /* in */, const U & /* out */) const { return 0.0; }
+        double operator()(const Uniform & in, const Uniform & out) const { return in.epsilon / out.epsilon; }
+        double operator()(const Uniform & in, const Yukawa & out) const {
+            return (out.kappa == 0.0) ? in.epsilon / out.epsilon : 0.0;
+        }
+        double operator()(const Yukawa & in, const Uniform & out) const {
+            return (in.kappa == 0.0) ? in.epsilon / out.epsilon : 0.0;
+        }
+        double operator()(const Yukawa & in, const Yukawa & out) const {
+            return (in.kappa == out.kappa) ? in.epsilon / out.epsilon : 0.0;
+        }
+        double operator()(const Uniform & in, const Anisotropic & out) const {
+            return tensorRatio(in.epsilon * Eigen::Matrix3d::Identity(), out.epsilon());
+        }
+        double operator()(const Anisotropic & in, const Uniform & out) const {
+            return tensorRatio(in.epsilon(), out.epsilon * Eigen::Matrix3d::Identity());
+        }
+        double operator()(const Anisotropic & in, const Anisotropic & out) const {
+            return tensorRatio(in.epsilon(), out.epsilon());
+        }
+    private:
+        /*! For \f$ \boldsymbol{\varepsilon}_\mathrm{out} = c\boldsymbol{\varepsilon}_\mathrm{in} \f$
+         *  the Green's function is scaled by \f$ 1/c \f$
+         */
+        static double tensorRatio(const Eigen::Matrix3d & in, const Eigen::Matrix3d & out) {
+            double c = out.trace() / in.trace();
+            return ((out - c * in).norm() <= 1.0e-12 * out.norm()) ? 1.0 / c : 0.0;
+        }
+    };
+
+    inline double kernelRatio(const Permittivity & in, const Permittivity & out) {
+        return boost::apply_visitor(kernelRatioValue(), in, out);
+    }
 } // namespace profiles
 
 #endif // PROFILETYPES_HPP
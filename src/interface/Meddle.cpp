@@ -39,6 +39,7 @@
 #include "RegisterCavityToFactory.hpp"
 #include "IGreensFunction.hpp"
 #include "RegisterGreensFunctionToFactory.hpp"
+#include "OperatorCache.hpp"
 #include "PCMSolver.hpp"
 #include "RegisterSolverToFactory.hpp"
 #include "Atom.hpp"
@@ -118,6 +119,24 @@ void pcmsolver_compute_response_asc(pcmsolver_context_t * context,
     AS_TYPE(pcm::Meddle, context)->computeResponseASC(mep_name, asc_name, irrep);
 }
 
+void pcmsolver_compute_ascs(pcmsolver_context_t * context,
+                            size_t nr_meps,
+                            const double meps[],
+                            double ascs[],
+                            int irrep)
+{
+    AS_TYPE(pcm::Meddle, context)->computeASCs(nr_meps, meps, ascs, irrep);
+}
+
+void pcmsolver_compute_response_ascs(pcmsolver_context_t * context,
+                            size_t nr_meps,
+                            const double meps[],
+                            double ascs[],
+                            int irrep)
+{
+    AS_TYPE(pcm::Meddle, context)->computeResponseASCs(nr_meps, meps, ascs, irrep);
+}
+
 double pcmsolver_compute_polarization_energy(pcmsolver_context_t * context,
                                              const char * mep_name,
                                              const char * asc_name)
@@ -125,6 +144,44 @@ double pcmsolver_compute_polarization_energy(pcmsolver_context_t * context,
     return (AS_TYPE(pcm::Meddle, context)->computePolarizationEnergy(mep_name, asc_name));
 }
 
+int pcmsolver_register_buffer(pcmsolver_context_t * context, size_t size, double values[])
+{
+    return (AS_TYPE(pcm::Meddle, context)->registerBuffer(size, values));
+}
+
+void pcmsolver_compute_asc_buffers(pcmsolver_context_t * context,
+                                   int mep_handle,
+                                   int asc_handle,
+                                   int irrep)
+{
+    AS_TYPE(pcm::Meddle, context)->computeASC(mep_handle, asc_handle, irrep);
+}
+
+void pcmsolver_compute_response_asc_buffers(pcmsolver_context_t * context,
+                                   int mep_handle,
+                                   int asc_handle,
+                                   int irrep)
+{
+    AS_TYPE(pcm::Meddle, context)->computeResponseASC(mep_handle, asc_handle, irrep);
+}
+
+double pcmsolver_compute_polarization_energy_buffers(pcmsolver_context_t * context,
+                                                     int mep_handle,
+                                                     int asc_handle)
+{
+    return (AS_TYPE(pcm::Meddle, context)->computePolarizationEnergy(mep_handle, asc_handle));
+}
+
+void pcmsolver_update_geometry(pcmsolver_context_t * context, int nr_nuclei, double charges[], double coordinates[])
+{
+    AS_TYPE(pcm::Meddle, context)->updateGeometry(nr_nuclei, charges, coordinates);
+}
+
+void pcmsolver_update_permittivity(pcmsolver_context_t * context, double epsilon)
+{
+    AS_TYPE(pcm::Meddle, context)->updatePermittivity(epsilon);
+}
+
 void pcmsolver_get_surface_function(pcmsolver_context_t * context,
                                     size_t size, double values[], const char * name)
 {
@@ -160,21 +217,21 @@ void pcmsolver_write_timings(pcmsolver_context_t * context)
 namespace pcm {
     Meddle::Meddle(pcmsolver_reader_t input_reading, int nr_nuclei, double
         charges[], double coordinates[], int symmetry_info[], const PCMInput & host_input)
-        : hasDynamic_(false)
+        : cavity_(NULL), K_0_(NULL), K_d_(NULL), gf_i_(NULL), gf_o_static_(NULL), gf_o_dynamic_(NULL),
+          operators_(NULL), hasDynamic_(false)
     {
         initInput(input_reading, nr_nuclei, charges, coordinates, symmetry_info, host_input);
-        initCavity();
-        initStaticSolver();
-        if (input_.isDynamic()) initDynamicSolver();
+        operators_ = new OperatorCache(input_.incrementalUpdate());
+        initSolvers();
+        initInfo();
         // Reserve space for Tot-MEP/ASC, Nuc-MEP/ASC and Ele-MEP/ASC
         functions_.reserve(12);
     }
 
     Meddle::~Meddle()
     {
-        delete cavity_;
-        delete K_0_;
-        if (hasDynamic_) delete K_d_;
+        releaseSolvers();
+        delete operators_;
     }
 
     size_t Meddle::getCavitySize() const
@@ -244,6 +301,104 @@ namespace pcm {
         }
     }
 
+    void Meddle::computeASCs(size_t nr_meps, const double meps[], double ascs[], int irrep) const
+    {
+        size_t size = cavity_->size();
+        Eigen::Map<Eigen::MatrixXd> asc(ascs, size, nr_meps);
+        asc = K_0_->computeCharges(Eigen::Map<const Eigen::MatrixXd>(meps, size, nr_meps), irrep);
+        // Renormalize
+        asc /= double(cavity_->pointGroup().nrIrrep());
+    }
+
+    void Meddle::computeResponseASCs(size_t nr_meps, const double meps[], double ascs[], int irrep) const
+    {
+        size_t size = cavity_->size();
+        Eigen::Map<Eigen::MatrixXd> asc(ascs, size, nr_meps);
+        if (hasDynamic_) {
+            asc = K_d_->computeCharges(Eigen::Map<const Eigen::MatrixXd>(meps, size, nr_meps), irrep);
+        } else {
+            asc = K_0_->computeCharges(Eigen::Map<const Eigen::MatrixXd>(meps, size, nr_meps), irrep);
+        }
+        // Renormalize
+        asc /= double(cavity_->pointGroup().nrIrrep());
+    }
+
+    int Meddle::registerBuffer(size_t size, double values[]) const
+    {
+        if (cavity_->size() != size)
+            PCMSOLVER_ERROR("You are trying to register a buffer of size different from the cavity!");
+        buffers_.push_back(values);
+        return (buffers_.size() - 1);
+    }
+
+    Eigen::Map<Eigen::VectorXd> Meddle::buffer(int handle) const
+    {
+        if (handle < 0 || static_cast<size_t>(handle) >= buffers_.size())
+            PCMSOLVER_ERROR("You are trying to access a non-registered buffer.");
+        return Eigen::Map<Eigen::VectorXd>(buffers_[handle], cavity_->size());
+    }
+
+    void Meddle::computeASC(int mep_handle, int asc_handle, int irrep) const
+    {
+        if (mep_handle == asc_handle)
+            PCMSOLVER_ERROR("The MEP and ASC buffers cannot be the same.");
+        Eigen::Map<Eigen::VectorXd> asc = buffer(asc_handle);
+        K_0_->computeChargeInto(buffer(mep_handle), asc, irrep);
+        // Renormalize
+        asc /= double(cavity_->pointGroup().nrIrrep());
+    }
+
+    void Meddle::computeResponseASC(int mep_handle, int asc_handle, int irrep) const
+    {
+        if (mep_handle == asc_handle)
+            PCMSOLVER_ERROR("The MEP and ASC buffers cannot be the same.");
+        Eigen::Map<Eigen::VectorXd> asc = buffer(asc_handle);
+        if (hasDynamic_) {
+            K_d_->computeChargeInto(buffer(mep_handle), asc, irrep);
+        } else {
+            K_0_->computeChargeInto(buffer(mep_handle), asc, irrep);
+        }
+        // Renormalize
+        asc /= double(cavity_->pointGroup().nrIrrep());
+    }
+
+    double Meddle::computePolarizationEnergy(int mep_handle, int asc_handle) const
+    {
+        return (buffer(mep_handle).dot(buffer(asc_handle)) / 2.0);
+    }
+
+    void Meddle::updateGeometry(int nr_nuclei, double charges[], double coordinates[])
+    {
+        if (input_.mode() == "EXPLICIT")
+            PCMSOLVER_ERROR("The geometry cannot be updated when the spheres are given explicitly (Mode = Explicit)!");
+        Eigen::VectorXd chg  = Eigen::Map<Eigen::VectorXd>(charges, nr_nuclei, 1);
+        Eigen::Matrix3Xd centers = Eigen::Map<Eigen::Matrix3Xd>(coordinates, 3, nr_nuclei);
+        Molecule molec;
+        initMolecule(input_, input_.molecule().pointGroup(), nr_nuclei, chg, centers, molec);
+        input_.molecule(molec);
+
+        releaseSolvers();
+        initSolvers();
+        initInfo();
+        // The surface functions and the buffers refer to the previous cavity
+        functions_.clear();
+        buffers_.clear();
+    }
+
+    void Meddle::updatePermittivity(double epsilon)
+    {
+        // The solver checks first that its permittivity can be updated
+        K_0_->updatePermittivity(epsilon);
+        input_.epsilonStaticOutside(epsilon);
+        delete gf_o_static_;
+        gf_o_static_ = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenOutsideType(),
+                input_.outsideStaticGreenParams());
+
+        initInfo();
+        infoStream_ << "Static permittivity updated to " << epsilon << std::endl;
+        if (hasDynamic_) infoStream_ << "Dynamic solver unchanged" << std::endl;
+    }
+
     void Meddle::getSurfaceFunction(size_t size, double values[], const char * name) const
     {
         if (cavity_->size() != size)
@@ -301,13 +456,13 @@ namespace pcm {
         std::string functionName(name);
         printer("\nLoading surface function " + functionName + " from .npy file");
         std::string fname = functionName + ".npy";
-        cnpy::NpyArray raw_surfFunc = cnpy::npy_load(fname);
+        cnpy::npy_mmap_t raw_surfFunc(fname);
         unsigned int dim = raw_surfFunc.shape[0];
         if (dim != cavity_->size()) {
             PCMSOLVER_ERROR("Inconsistent dimension of loaded surface function!");
         } else {
-            Eigen::VectorXd values = getFromRawBuffer<double>(dim, 1, raw_surfFunc.data);
-            SurfaceFunction func(dim, values);
+            // The values are copied straight from the memory-mapped file
+            SurfaceFunction func(dim, reinterpret_cast<double *>(raw_surfFunc.data));
             // Append to global map
             if (functions_.count(functionName) == 1) { // Key in map already
                 functions_[functionName] = func;
@@ -353,55 +508,62 @@ namespace pcm {
             initMolecule(input_, pg, nr_nuclei, chg, centers, molec);
             input_.molecule(molec);
         }
-
-        infoStream_ << std::endl;
-        infoStream_ << "~~~~~~~~~~ PCMSolver ~~~~~~~~~~" << std::endl;
-        infoStream_ << "Using CODATA " << input_.CODATAyear() << " set of constants." << std::endl;
-        infoStream_ << "Input parsing done " << input_.providedBy() << std::endl;
     }
 
     void Meddle::initCavity()
     {
         cavity_ = Factory<Cavity, cavityData>::TheFactory().create(input_.cavityType(), input_.cavityParams());
         cavity_->saveCavity();
+    }
 
-        infoStream_ << "========== Cavity " << std::endl;
-        infoStream_ << *cavity_ << std::endl;
+    void Meddle::initSolvers()
+    {
+        initCavity();
+        // The operators inside the cavity are shared by the static and dynamic solvers,
+        // they are released once both are built, unless kept for the next geometry
+        initStaticSolver(*operators_);
+        if (input_.isDynamic()) initDynamicSolver(*operators_);
+        if (!input_.incrementalUpdate()) operators_->clear();
     }
 
-    void Meddle::initStaticSolver()
+    void Meddle::releaseSolvers()
     {
-        IGreensFunction * gf_i = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenInsideType(),
+        delete cavity_;
+        delete K_0_;
+        delete K_d_;
+        // Matrix-free solvers hold on to the Green's functions,
+        // these can only be released after the solvers
+        delete gf_i_;
+        delete gf_o_static_;
+        delete gf_o_dynamic_;
+        cavity_ = NULL;
+        K_0_ = NULL;
+        K_d_ = NULL;
+        gf_i_ = NULL;
+        gf_o_static_ = NULL;
+        gf_o_dynamic_ = NULL;
+        hasDynamic_ = false;
+    }
+
+    void Meddle::initStaticSolver(OperatorCache & operators)
+    {
+        gf_i_ = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenInsideType(),
           input_.insideGreenParams());
-        IGreensFunction * gf_o = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenOutsideType(),
+        gf_o_static_ = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenOutsideType(),
                 input_.outsideStaticGreenParams());
         std::string modelType = input_.solverType();
         K_0_ = Factory<PCMSolver, solverData>::TheFactory().create(modelType, input_.solverParams());
-        K_0_->buildSystemMatrix(*cavity_, *gf_i, *gf_o);
-
-        infoStream_ << "========== Static solver " << std::endl;
-        infoStream_ << *K_0_ << std::endl;
-        mediumInfo(gf_i, gf_o);
-        delete gf_o;
-        delete gf_i;
+        K_0_->buildSystemMatrix(*cavity_, *gf_i_, *gf_o_static_, operators);
     }
 
-    void Meddle::initDynamicSolver()
+    void Meddle::initDynamicSolver(OperatorCache & operators)
     {
-        IGreensFunction * gf_i = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenInsideType(),
-                input_.insideGreenParams());
-        IGreensFunction * gf_o = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenOutsideType(),
+        gf_o_dynamic_ = Factory<IGreensFunction, greenData>::TheFactory().create(input_.greenOutsideType(),
                 input_.outsideDynamicGreenParams());
         std::string modelType = input_.solverType();
         K_d_ = Factory<PCMSolver, solverData>::TheFactory().create(modelType, input_.solverParams());
-        K_d_->buildSystemMatrix(*cavity_, *gf_i, *gf_o);
+        K_d_->buildSystemMatrix(*cavity_, *gf_i_, *gf_o_dynamic_, operators);
         hasDynamic_ = true;
-
-        infoStream_ << "========== Dynamic solver " << std::endl;
-        infoStream_ << *K_d_ << std::endl;
-        mediumInfo(gf_i, gf_o);
-        delete gf_o;
-        delete gf_i;
     }
 
     void Meddle::mediumInfo(IGreensFunction * gf_i, IGreensFunction * gf_o) const
@@ -420,6 +582,25 @@ namespace pcm {
         infoStream_ << tmp.str() << std::endl;
     }
 
+    void Meddle::initInfo() const
+    {
+        infoStream_.str("");
+        infoStream_ << std::endl;
+        infoStream_ << "~~~~~~~~~~ PCMSolver ~~~~~~~~~~" << std::endl;
+        infoStream_ << "Using CODATA " << input_.CODATAyear() << " set of constants." << std::endl;
+        infoStream_ << "Input parsing done " << input_.providedBy() << std::endl;
+        infoStream_ << "========== Cavity " << std::endl;
+        infoStream_ << *cavity_ << std::endl;
+        infoStream_ << "========== Static solver " << std::endl;
+        infoStream_ << *K_0_ << std::endl;
+        mediumInfo(gf_i_, gf_o_static_);
+        if (hasDynamic_) {
+            infoStream_ << "========== Dynamic solver " << std::endl;
+            infoStream_ << *K_d_ << std::endl;
+            mediumInfo(gf_i_, gf_o_dynamic_);
+        }
+    }
+
     void Meddle::printInfo() const
     {
         printer(citation_message());
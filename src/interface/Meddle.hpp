@@ -27,6 +27,7 @@
 #define MEDDLE_HPP
 
 #include <string>
+#include <vector>
 
 #include "Config.hpp"
 
@@ -36,6 +37,7 @@ class Cavity;
 class IGreensFunction;
 class Input;
 struct PCMInput;
+class OperatorCache;
 class PCMSolver;
 
 #include "Input.hpp"
@@ -113,6 +115,25 @@ namespace pcm {
              *  otherwise.
              */
             void computeResponseASC(const char * mep_name, const char * asc_name, int irrep) const;
+            /*! \brief Computes ASCs given a batch of MEPs and the desired irreducible representation
+             *  \param[in] nr_meps number of MEPs in the batch
+             *  \param[in] meps    the MEPs, one per column of a cavity size x nr_meps matrix in column-major order
+             *  \param[out] ascs   the ASCs, one per column of a cavity size x nr_meps matrix in column-major order
+             *  \param[in] irrep   index of the desired irreducible representation
+             *  All the ASCs are obtained by a single matrix-matrix product. The surface
+             *  function map is bypassed: the MEPs and ASCs are read from and written to the arrays.
+             */
+            void computeASCs(size_t nr_meps, const double meps[], double ascs[], int irrep) const;
+            /*! \brief Computes response ASCs given a batch of MEPs and the desired irreducible representation
+             *  \param[in] nr_meps number of MEPs in the batch
+             *  \param[in] meps    the MEPs, one per column of a cavity size x nr_meps matrix in column-major order
+             *  \param[out] ascs   the ASCs, one per column of a cavity size x nr_meps matrix in column-major order
+             *  \param[in] irrep   index of the desired irreducible representation
+             *  If `Nonequilibrium = True` in the input, calculates response
+             *  ASCs using the dynamic permittivity. Falls back to the solver with static permittivity
+             *  otherwise.
+             */
+            void computeResponseASCs(size_t nr_meps, const double meps[], double ascs[], int irrep) const;
             /*! \brief Computes the polarization energy
              *  \param[in] mep_name label of the MEP surface function
              *  \param[in] asc_name label of the ASC surface function
@@ -120,6 +141,52 @@ namespace pcm {
              *  This function calculates the dot product of the given MEP and ASC vectors.
              */
             double computePolarizationEnergy(const char * mep_name, const char * asc_name) const;
+            /*! \brief Registers a buffer owned by the host program
+             *  \param[in] size the size of the buffer
+             *  \param[in] values the buffer
+             *  \return the handle to the buffer
+             *  The buffer is neither copied nor released, it has to outlive the context.
+             *  Registered buffers are accessed by handle, avoiding the lookups in the
+             *  surface function map.
+             */
+            int registerBuffer(size_t size, double values[]) const;
+            /*! \brief Computes ASC given a MEP and the desired irreducible representation, using registered buffers
+             *  \param[in] mep_handle handle to the buffer holding the MEP
+             *  \param[in] asc_handle handle to the buffer where the ASC is written
+             *  \param[in] irrep index of the desired irreducible representation
+             */
+            void computeASC(int mep_handle, int asc_handle, int irrep) const;
+            /*! \brief Computes response ASC given a MEP and the desired irreducible representation, using registered buffers
+             *  \param[in] mep_handle handle to the buffer holding the MEP
+             *  \param[in] asc_handle handle to the buffer where the ASC is written
+             *  \param[in] irrep index of the desired irreducible representation
+             *  If `Nonequilibrium = True` in the input, calculates a response
+             *  ASC using the dynamic permittivity. Falls back to the solver with static permittivity
+             *  otherwise.
+             */
+            void computeResponseASC(int mep_handle, int asc_handle, int irrep) const;
+            /*! \brief Computes the polarization energy, using registered buffers
+             *  \param[in] mep_handle handle to the buffer holding the MEP
+             *  \param[in] asc_handle handle to the buffer holding the ASC
+             *  \return the polarization energy
+             */
+            double computePolarizationEnergy(int mep_handle, int asc_handle) const;
+            /*! \brief Updates the molecular geometry
+             *  \param[in] nr_nuclei     number of atoms in the molecule
+             *  \param[in] charges       atomic charges
+             *  \param[in] coordinates   atomic coordinates
+             *  The cavity and the solvers are built anew, the operators inside the cavity
+             *  are updated from those of the previous geometry with IncrementalUpdate.
+             *  The surface functions and the registered buffers are discarded.
+             */
+            void updateGeometry(int nr_nuclei, double charges[], double coordinates[]);
+            /*! \brief Updates the static permittivity outside the cavity
+             *  \param[in] epsilon the new static permittivity
+             *  Only the static solver and the Green's function outside the cavity with static permittivity
+             *  are updated, the boundary integral operators are not recomputed.
+             *  The dynamic solver is left unchanged.
+             */
+            void updatePermittivity(double epsilon);
             /*! \brief Retrieves data wrapped in a given surface function
              *  \param[in] size the size of the surface function
              *  \param[in] values the values wrapped in the surface function
@@ -158,22 +225,44 @@ namespace pcm {
             PCMSolver * K_0_;
             /*! Solver with dynamic permittivity */
             PCMSolver * K_d_;
+            /*! Green's function inside the cavity, shared by the static and dynamic solvers */
+            IGreensFunction * gf_i_;
+            /*! Green's function outside the cavity, static permittivity */
+            IGreensFunction * gf_o_static_;
+            /*! Green's function outside the cavity, dynamic permittivity */
+            IGreensFunction * gf_o_dynamic_;
+            /*! Operators inside the cavity, kept for the next geometry with IncrementalUpdate */
+            OperatorCache * operators_;
             /*! PCMSolver set up information */
             mutable std::ostringstream infoStream_;
             /*! Whether K_d_ was initialized */
             bool hasDynamic_;
             /*! SurfaceFunction map */
             mutable SurfaceFunctionMap functions_;
+            /*! Buffers owned by the host program, indexed by handle */
+            mutable std::vector<double *> buffers_;
+            /*! Wraps the registered buffer with the given handle */
+            Eigen::Map<Eigen::VectorXd> buffer(int handle) const;
             /*! Initialize input_ */
             void initInput(pcmsolver_reader_t input_reading, int nr_nuclei, double charges[], double coordinates[], int symmetry_info[], const PCMInput & host_input);
             /*! Initialize cavity_ */
             void initCavity();
-            /*! Initialize static solver K_0_ */
-            void initStaticSolver();
-            /*! Initialize dynamic solver K_d_ */
-            void initDynamicSolver();
+            /*! Initialize static solver K_0_
+             *  \param[in,out] operators cache of the operators inside the cavity
+             */
+            void initStaticSolver(OperatorCache & operators);
+            /*! Initialize dynamic solver K_d_
+             *  \param[in,out] operators cache of the operators inside the cavity
+             */
+            void initDynamicSolver(OperatorCache & operators);
+            /*! Build cavity_ and the solvers, sharing the operators inside the cavity */
+            void initSolvers();
+            /*! Release cavity_, the solvers and the Green's functions */
+            void releaseSolvers();
             /*! Collect info on medium */
             void mediumInfo(IGreensFunction * gf_i, IGreensFunction * gf_o) const;
+            /*! Collect set up information on the cavity, the solvers and the medium */
+            void initInfo() const;
             void printer(const std::string & message) const;
             void printer(const std::ostringstream & stream) const;
     };
@@ -26,7 +26,10 @@
 #include "CPCMSolver.hpp"
 
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <string>
 
 #include "Config.hpp"
@@ -38,32 +41,54 @@
 #include "Element.hpp"
 #include "IGreensFunction.hpp"
 #include "MathUtils.hpp"
+#include "MatrixCache.hpp"
 #include "SolverImpl.hpp"
 
 void CPCMSolver::buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
   if (!isotropic_) PCMSOLVER_ERROR("C-PCM is defined only for isotropic environments!");
-  fullPCMMatrix_ = CPCMMatrix(cavity, gf_i, profiles::epsilon(gf_o.permittivity()), correction_);
-  // Symmetrize K := (K + K+)/2
+  epsilon_ = profiles::epsilon(gf_o.permittivity());
+  std::string fingerprint;
+  if (!matrixCache_.empty()) {
+    std::ostringstream options;
+    options << std::setprecision(std::numeric_limits<double>::digits10 + 2)
+            << "CPCM" << hermitivitize_ << correction_;
+    fingerprint = PCMMatrixFingerprint(cavity, gf_i, gf_o, options.str());
+    cacheFile_ = PCMMatrixCacheFile(matrixCache_, fingerprint);
+    loadedFromCache_ = loadPCMMatrix(cacheFile_, fingerprint, cavity.pointGroup().nrIrrep(), cavity.irreducible_size(), blockPCMMatrix_);
+    if (loadedFromCache_) {
+      built_ = true;
+      return;
+    }
+  }
+  // Each irreducible representation is built and factorized separately,
+  // the full PCM matrix is never formed
+  blockPCMMatrix_ = CPCMBlocks(cavity, gf_i, epsilon_, correction_, operators_);
+  // Symmetrize K := (K + K+)/2, block by block
   if (hermitivitize_) {
-    hermitivitize(fullPCMMatrix_);
+    for (size_t i = 0; i < blockPCMMatrix_.size(); ++i) hermitivitize(blockPCMMatrix_[i]);
   }
-  // Symmetry-pack
-  // The number of irreps in the group
-  int nrBlocks = cavity.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cavity.irreducible_size();
-  symmetryPacking(blockPCMMatrix_, fullPCMMatrix_, dimBlock, nrBlocks);
+  if (!matrixCache_.empty()) savePCMMatrix(cacheFile_, fingerprint, blockPCMMatrix_);
 
   built_ = true;
 }
 
+void CPCMSolver::updatePermittivity_impl(double epsilon)
+{
+  // K = f(epsilon) * SI^-1, with f(epsilon) = (epsilon - 1)/(epsilon + correction)
+  double fact = (epsilon_ - 1.0)/(epsilon_ + correction_);
+  if (fact == 0.0) PCMSOLVER_ERROR("C-PCM matrix cannot be rescaled from a unit permittivity!");
+  double scaling = (epsilon - 1.0)/(epsilon + correction_) / fact;
+  for (size_t i = 0; i < blockPCMMatrix_.size(); ++i) blockPCMMatrix_[i] *= scaling;
+  epsilon_ = epsilon;
+}
+
 Eigen::VectorXd CPCMSolver::computeCharge_impl(const Eigen::VectorXd & potential, int irrep) const
 {
   // The potential and charge vector are of dimension equal to the
   // full dimension of the cavity. We have to select just the part
   // relative to the irrep needed.
-  int fullDim = fullPCMMatrix_.rows();
+  int fullDim = potential.size();
   Eigen::VectorXd charge = Eigen::VectorXd::Zero(fullDim);
   int nrBlocks = blockPCMMatrix_.size();
   int irrDim = fullDim/nrBlocks;
@@ -72,6 +97,30 @@ Eigen::VectorXd CPCMSolver::computeCharge_impl(const Eigen::VectorXd & potential
   return charge;
 }
 
+void CPCMSolver::computeChargeInto_impl(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+        int irrep) const
+{
+  int fullDim = potential.size();
+  charge.setZero();
+  int nrBlocks = blockPCMMatrix_.size();
+  int irrDim = fullDim/nrBlocks;
+  charge.segment(irrep*irrDim, irrDim).noalias() =
+    - blockPCMMatrix_[irrep] * potential.segment(irrep*irrDim, irrDim);
+}
+
+Eigen::MatrixXd CPCMSolver::computeCharges_impl(const Eigen::MatrixXd & potentials, int irrep) const
+{
+  // All the MEPs in the batch are multiplied by the block of the PCM matrix
+  // for the irrep needed at once.
+  int fullDim = potentials.rows();
+  Eigen::MatrixXd charges = Eigen::MatrixXd::Zero(fullDim, potentials.cols());
+  int nrBlocks = blockPCMMatrix_.size();
+  int irrDim = fullDim/nrBlocks;
+  charges.middleRows(irrep*irrDim, irrDim).noalias() =
+    - blockPCMMatrix_[irrep] * potentials.middleRows(irrep*irrDim, irrDim);
+  return charges;
+}
+
 std::ostream & CPCMSolver::printSolver(std::ostream & os)
 {
   os << "Solver Type: C-PCM" << std::endl;
@@ -80,6 +129,7 @@ std::ostream & CPCMSolver::printSolver(std::ostream & os)
   } else {
     os << "PCM matrix NOT hermitivitized (matches old DALTON)";
   }
+  if (!matrixCache_.empty()) os << std::endl << "PCM matrix cached in: " << matrixCache_;
 
   return os;
 }
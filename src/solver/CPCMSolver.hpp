@@ -53,10 +53,15 @@ public:
     /*! \brief Construct solver
      *  \param[in] symm whether the system matrix has to be symmetrized
      *  \param[in] corr factor to correct the conductor results
+     *  \param[in] cache directory of the on-disk PCM matrix cache, no caching when empty
      */
-    CPCMSolver(bool symm, double corr)
-        : PCMSolver(), hermitivitize_(symm), correction_(corr) {}
+    CPCMSolver(bool symm, double corr, const std::string & cache = "")
+        : PCMSolver(), hermitivitize_(symm), correction_(corr), matrixCache_(cache), loadedFromCache_(false) {}
     virtual ~CPCMSolver() {}
+    /*! Name of the cache file of the PCM matrix, empty when the PCM matrix is not cached */
+    const std::string & cacheFile() const { return cacheFile_; }
+    /*! Whether the PCM matrix was loaded from the cache file, rather than built */
+    bool loadedFromCache() const { return loadedFromCache_; }
     friend std::ostream & operator<<(std::ostream & os, CPCMSolver & solver) {
         return solver.printSolver(os);
     }
@@ -65,9 +70,15 @@ private:
     bool hermitivitize_;
     /*! Correction for the conductor results */
     double correction_;
-    /*! PCM matrix, not symmetry blocked */
-    Eigen::MatrixXd fullPCMMatrix_;
-    /*! PCM matrix, symmetry blocked form */
+    /*! Directory of the on-disk PCM matrix cache, no caching when empty */
+    std::string matrixCache_;
+    /*! Name of the cache file of the PCM matrix, empty when the PCM matrix is not cached */
+    std::string cacheFile_;
+    /*! Whether the PCM matrix was loaded from the cache file */
+    bool loadedFromCache_;
+    /*! Permittivity outside the cavity */
+    double epsilon_;
+    /*! PCM matrix, symmetry blocked form, one block per irreducible representation */
     std::vector<Eigen::MatrixXd> blockPCMMatrix_;
 
     /*! \brief Calculation of the PCM matrix
@@ -76,12 +87,31 @@ private:
      *  \param[in] gf_o Green's function outside the cavity
      */
     virtual void buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o) __override;
+    /*! \brief Updates the PCM matrix for a new permittivity outside the cavity
+     *  \param[in] epsilon the new permittivity outside the cavity
+     *
+     *  The permittivity only enters the scaling factor, the blocks are rescaled in \f$ O(N^2) \f$ operations.
+     */
+    virtual void updatePermittivity_impl(double epsilon) __override;
     /*! \brief Returns the ASC given the MEP and the desired irreducible representation
      *  \param[in] potential the vector containing the MEP at cavity points
      *  \param[in] irrep the irreducible representation of the MEP and ASC
      */
     virtual Eigen::VectorXd computeCharge_impl(const Eigen::VectorXd & potential,
             int irrep = 0) const __override;
+    /*! \brief Computes the ASC given the MEP and the desired irreducible representation
+     *  \param[in] potential the vector containing the MEP at cavity points
+     *  \param[out] charge the vector where the ASC at cavity points is written
+     *  \param[in] irrep the irreducible representation of the MEP and ASC
+     */
+    virtual void computeChargeInto_impl(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+            int irrep = 0) const __override;
+    /*! \brief Returns the ASCs given a batch of MEPs and the desired irreducible representation
+     *  \param[in] potentials the matrix containing the MEPs at cavity points, one per column
+     *  \param[in] irrep the irreducible representation of the MEPs and ASCs
+     */
+    virtual Eigen::MatrixXd computeCharges_impl(const Eigen::MatrixXd & potentials,
+            int irrep = 0) const __override;
     virtual std::ostream & printSolver(std::ostream & os) __override;
 };
 
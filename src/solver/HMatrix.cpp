@@ -0,0 +1,263 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "HMatrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+namespace
+{
+    /*! Orders points by one of their coordinates */
+    struct CoordinateLess
+    {
+        CoordinateLess(const Eigen::Matrix3Xd & points, int axis) : points_(points), axis_(axis) {}
+        bool operator()(int i, int j) const { return points_(axis_, i) < points_(axis_, j); }
+        const Eigen::Matrix3Xd & points_;
+        int axis_;
+    };
+}
+
+HMatrix::HMatrix(const Eigen::Matrix3Xd & points, const EntryFunction & entry, double tolerance,
+        double eta, int leafSize)
+    : size_(points.cols()), tolerance_(tolerance), eta_(eta), leafSize_(leafSize), points_(points), entry_(entry)
+{
+    if (tolerance_ <= 0.0 || tolerance_ >= 1.0) PCMSOLVER_ERROR("Cross approximation tolerance must be in (0, 1)!");
+    if (eta_ <= 0.0) PCMSOLVER_ERROR("Admissibility parameter must be positive!");
+    if (leafSize_ < 1) PCMSOLVER_ERROR("Clusters must contain at least one point!");
+    permutation_.resize(size_);
+    for (int i = 0; i < size_; ++i) permutation_[i] = i;
+    Cluster root;
+    root.begin = 0;
+    root.end = size_;
+    tree_.push_back(root);
+    subdivide(0);
+    partition(0, 0);
+    // The blocks are independent, only the entries they need are evaluated
+    int nBlocks = blocks_.size();
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int b = 0; b < nBlocks; ++b) {
+        try {
+            Block & block = blocks_[b];
+            if (block.lowRank) block.lowRank = crossApproximation(block);
+            if (!block.lowRank) denseBlock(block);
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+}
+
+void HMatrix::subdivide(int cluster)
+{
+    int begin = tree_[cluster].begin, end = tree_[cluster].end;
+    // Bounding box of the points in the cluster
+    Eigen::Vector3d lower = Eigen::Vector3d::Constant(0.0), upper = Eigen::Vector3d::Constant(0.0);
+    if (end > begin) {
+        lower = points_.col(permutation_[begin]);
+        upper = lower;
+    }
+    for (int k = begin; k < end; ++k) {
+        lower = lower.cwiseMin(points_.col(permutation_[k]));
+        upper = upper.cwiseMax(points_.col(permutation_[k]));
+    }
+    Eigen::Vector3d center = 0.5 * (lower + upper);
+    double radius = 0.0;
+    for (int k = begin; k < end; ++k) {
+        radius = std::max(radius, (points_.col(permutation_[k]) - center).norm());
+    }
+    tree_[cluster].center = center;
+    tree_[cluster].radius = radius;
+    // Coincident points cannot be separated any further
+    if (end - begin <= leafSize_ || radius == 0.0) return;
+
+    // Bisect along the longest side of the bounding box, at the median
+    int axis = 0;
+    (upper - lower).maxCoeff(&axis);
+    int middle = begin + (end - begin) / 2;
+    std::nth_element(permutation_.begin() + begin, permutation_.begin() + middle,
+            permutation_.begin() + end, CoordinateLess(points_, axis));
+    Cluster left, right;
+    left.begin = begin;
+    left.end = middle;
+    right.begin = middle;
+    right.end = end;
+    // tree_ might be reallocated, children are appended by index
+    tree_.push_back(left);
+    tree_[cluster].children.push_back(tree_.size() - 1);
+    tree_.push_back(right);
+    tree_[cluster].children.push_back(tree_.size() - 1);
+    for (size_t i = 0; i < tree_[cluster].children.size(); ++i) {
+        subdivide(tree_[cluster].children[i]);
+    }
+}
+
+void HMatrix::partition(int rows, int cols)
+{
+    const Cluster & r = tree_[rows];
+    const Cluster & c = tree_[cols];
+    double distance = (r.center - c.center).norm() - r.radius - c.radius;
+    bool admissible = (distance > 0.0 && 2.0 * std::min(r.radius, c.radius) <= eta_ * distance);
+    if (admissible || (r.children.empty() && c.children.empty())) {
+        Block block;
+        block.rows = rows;
+        block.cols = cols;
+        block.lowRank = admissible;
+        blocks_.push_back(block);
+        return;
+    }
+    // Subdivide the larger cluster, unless it is a leaf
+    if (c.children.empty() || (!r.children.empty() && r.radius >= c.radius)) {
+        for (size_t i = 0; i < r.children.size(); ++i) partition(r.children[i], cols);
+    } else {
+        for (size_t i = 0; i < c.children.size(); ++i) partition(rows, c.children[i]);
+    }
+}
+
+bool HMatrix::crossApproximation(Block & block) const
+{
+    const Cluster & r = tree_[block.rows];
+    const Cluster & c = tree_[block.cols];
+    int m = r.end - r.begin, n = c.end - c.begin;
+    // Beyond this rank the dense block takes less memory
+    int maxRank = (m * n) / (m + n);
+    std::vector<Eigen::VectorXd> us, vs;
+    std::vector<bool> used(m, false);
+    // Squared Frobenius norm of the approximation, updated at each step
+    double normSquared = 0.0;
+    int pivotRow = 0;
+    while (pivotRow >= 0) {
+        int k = us.size();
+        // Residual of the pivot row
+        Eigen::VectorXd v(n);
+        int row = permutation_[r.begin + pivotRow];
+        for (int j = 0; j < n; ++j) v(j) = entry_(row, permutation_[c.begin + j]);
+        for (int l = 0; l < k; ++l) v -= us[l](pivotRow) * vs[l];
+        used[pivotRow] = true;
+        int pivotCol = 0;
+        double pivot = v.cwiseAbs().maxCoeff(&pivotCol);
+        if (pivot == 0.0) {
+            // The row is already approximated exactly, try the next one
+            pivotRow = std::find(used.begin(), used.end(), false) - used.begin();
+            if (pivotRow == m) pivotRow = -1;
+            continue;
+        }
+        v /= v(pivotCol);
+        // Residual of the pivot column
+        Eigen::VectorXd u(m);
+        int col = permutation_[c.begin + pivotCol];
+        for (int i = 0; i < m; ++i) u(i) = entry_(permutation_[r.begin + i], col);
+        for (int l = 0; l < k; ++l) u -= vs[l](pivotCol) * us[l];
+        for (int l = 0; l < k; ++l) normSquared += 2.0 * us[l].dot(u) * vs[l].dot(v);
+        double update = u.norm() * v.norm();
+        normSquared += update * update;
+        us.push_back(u);
+        vs.push_back(v);
+        if (update <= tolerance_ * std::sqrt(normSquared)) break;
+        if (static_cast<int>(us.size()) >= maxRank) return false;
+        // The next pivot row is the one of the largest element of the column
+        pivotRow = -1;
+        double largest = -1.0;
+        for (int i = 0; i < m; ++i) {
+            if (!used[i] && std::abs(u(i)) > largest) {
+                largest = std::abs(u(i));
+                pivotRow = i;
+            }
+        }
+    }
+    int rank = us.size();
+    block.U.resize(m, rank);
+    block.V.resize(n, rank);
+    for (int l = 0; l < rank; ++l) {
+        block.U.col(l) = us[l];
+        block.V.col(l) = vs[l];
+    }
+    return true;
+}
+
+void HMatrix::denseBlock(Block & block) const
+{
+    const Cluster & r = tree_[block.rows];
+    const Cluster & c = tree_[block.cols];
+    block.U.resize(r.end - r.begin, c.end - c.begin);
+    for (int j = c.begin; j < c.end; ++j) {
+        for (int i = r.begin; i < r.end; ++i) {
+            block.U(i - r.begin, j - c.begin) = entry_(permutation_[i], permutation_[j]);
+        }
+    }
+    block.V.resize(0, 0);
+}
+
+Eigen::VectorXd HMatrix::apply(const Eigen::VectorXd & x) const
+{
+    Eigen::VectorXd xp(size_), yp = Eigen::VectorXd::Zero(size_);
+    for (int k = 0; k < size_; ++k) xp(k) = x(permutation_[k]);
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        const Block & block = blocks_[b];
+        const Cluster & r = tree_[block.rows];
+        const Cluster & c = tree_[block.cols];
+        if (block.lowRank) {
+            yp.segment(r.begin, r.end - r.begin) += block.U * (block.V.transpose() * xp.segment(c.begin, c.end - c.begin));
+        } else {
+            yp.segment(r.begin, r.end - r.begin) += block.U * xp.segment(c.begin, c.end - c.begin);
+        }
+    }
+    Eigen::VectorXd y(size_);
+    for (int k = 0; k < size_; ++k) y(permutation_[k]) = yp(k);
+    return y;
+}
+
+size_t HMatrix::storage() const
+{
+    size_t elements = 0;
+    for (size_t b = 0; b < blocks_.size(); ++b) elements += blocks_[b].U.size() + blocks_[b].V.size();
+    return elements;
+}
+
+size_t HMatrix::lowRankBlocks() const
+{
+    size_t count = 0;
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        if (blocks_[b].lowRank) ++count;
+    }
+    return count;
+}
+
+int HMatrix::maxRank() const
+{
+    int rank = 0;
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        if (blocks_[b].lowRank) rank = std::max(rank, static_cast<int>(blocks_[b].U.cols()));
+    }
+    return rank;
+}
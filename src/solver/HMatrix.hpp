@@ -0,0 +1,147 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef HMATRIX_HPP
+#define HMATRIX_HPP
+
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+/*! \file HMatrix.hpp
+ *  \class HMatrix
+ *  \brief Hierarchical matrix compression of a boundary integral operator
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  The points, i.e. the finite elements centers, are sorted into a binary cluster tree
+ *  by recursive bisection of their bounding box along its longest side.
+ *  The matrix is partitioned into blocks coupling pairs of clusters.
+ *  A block is admissible, i.e. numerically low-rank, when the clusters are well separated:
+ *  \f[
+ *      \min(\mathrm{diam}(\tau), \mathrm{diam}(\sigma)) \leq \eta\,\mathrm{dist}(\tau, \sigma)
+ *  \f]
+ *  Admissible blocks are stored as \f$ \mathbf{U}\mathbf{V}^t \f$, computed by adaptive
+ *  cross approximation (ACA) with partial pivoting from a few rows and columns, as described in
+ *  M. Bebendorf, Numer. Math. 86, 565 (2000)
+ *  The remaining blocks between leaves of the tree are stored dense.
+ *  For the kernels of the Green's functions, the memory and the cost of building the matrix
+ *  and of its product with a vector are \f$ O(N\log N) \f$ for a fixed tolerance.
+ *  Only the entries needed are evaluated, by means of a function returning the matrix element.
+ */
+
+class HMatrix
+{
+public:
+    /*! Returns the matrix element (i, j), in the original ordering of the points */
+    typedef pcm::function<double(int, int)> EntryFunction;
+    /*! \brief Builds the hierarchical matrix
+     *  \param[in] points the points, 3 x N
+     *  \param[in] entry function returning the matrix elements
+     *  \param[in] tolerance relative tolerance of the cross approximation, in (0, 1)
+     *  \param[in] eta admissibility parameter
+     *  \param[in] leafSize maximum number of points in a leaf
+     */
+    HMatrix(const Eigen::Matrix3Xd & points, const EntryFunction & entry, double tolerance,
+            double eta = 2.0, int leafSize = 16);
+    /*! \brief Returns the product of the matrix with a vector
+     *  \param[in] x the vector
+     */
+    Eigen::VectorXd apply(const Eigen::VectorXd & x) const;
+    /*! Number of matrix elements stored */
+    size_t storage() const;
+    /*! Number of matrix elements of the dense matrix */
+    size_t denseStorage() const { return static_cast<size_t>(size_) * size_; }
+    /*! Number of low-rank blocks */
+    size_t lowRankBlocks() const;
+    /*! Maximum rank of the low-rank blocks */
+    int maxRank() const;
+private:
+    struct Cluster {
+        /*! Center of the bounding box */
+        Eigen::Vector3d center;
+        /*! Radius of the sphere centered in center and enclosing all points in the cluster */
+        double radius;
+        /*! Index of the first point of the cluster in the permutation */
+        int begin;
+        /*! Index past the last point of the cluster in the permutation */
+        int end;
+        /*! Indices of the children clusters, empty for a leaf */
+        std::vector<int> children;
+    };
+    struct Block {
+        /*! Index of the row cluster */
+        int rows;
+        /*! Index of the column cluster */
+        int cols;
+        /*! Whether the block is stored as U * V^t */
+        bool lowRank;
+        /*! The dense block or the U factor */
+        Eigen::MatrixXd U;
+        /*! The V factor, empty for a dense block */
+        Eigen::MatrixXd V;
+    };
+    /*! Dimension of the matrix */
+    int size_;
+    /*! Relative tolerance of the cross approximation */
+    double tolerance_;
+    /*! Admissibility parameter */
+    double eta_;
+    /*! Maximum number of points in a leaf */
+    int leafSize_;
+    /*! The points */
+    Eigen::Matrix3Xd points_;
+    /*! Function returning the matrix elements */
+    EntryFunction entry_;
+    /*! Permutation of the points, points in a cluster are contiguous */
+    std::vector<int> permutation_;
+    /*! The cluster tree, root first */
+    std::vector<Cluster> tree_;
+    /*! The blocks of the partition of the matrix */
+    std::vector<Block> blocks_;
+
+    /*! \brief Bisects a cluster and its descendants
+     *  \param[in] cluster index of the cluster in the tree
+     */
+    void subdivide(int cluster);
+    /*! \brief Partitions the block coupling two clusters
+     *  \param[in] rows index of the row cluster
+     *  \param[in] cols index of the column cluster
+     */
+    void partition(int rows, int cols);
+    /*! \brief Adaptive cross approximation of a block, with partial pivoting
+     *  \param[in,out] block the block
+     *  \return false when the block is not compressible, the block is then stored dense
+     */
+    bool crossApproximation(Block & block) const;
+    /*! \brief Fills a block with the dense matrix elements
+     *  \param[in,out] block the block
+     */
+    void denseBlock(Block & block) const;
+};
+
+#endif // HMATRIX_HPP
@@ -28,6 +28,9 @@
 #include <iostream>
 #include <cmath>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -40,56 +43,85 @@
 #include "Element.hpp"
 #include "IGreensFunction.hpp"
 #include "MathUtils.hpp"
+#include "MatrixCache.hpp"
+#include "OperatorCache.hpp"
 #include "SolverImpl.hpp"
 
 void IEFSolver::buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
     isotropic_ = (gf_i.uniform() && gf_o.uniform());
+    std::string fingerprint;
+    if (!matrixCache_.empty()) {
+        std::ostringstream options;
+        options << std::setprecision(std::numeric_limits<double>::digits10 + 2)
+                << "IEFPCM" << isotropic_ << hermitivitize_;
+        fingerprint = PCMMatrixFingerprint(cavity, gf_i, gf_o, options.str());
+        cacheFile_ = PCMMatrixCacheFile(matrixCache_, fingerprint);
+        int nrBlocks = cavity.pointGroup().nrIrrep(), dimBlock = cavity.irreducible_size();
+        loadedFromCache_ = loadPCMMatrix(cacheFile_, fingerprint, nrBlocks, dimBlock, blockPCMMatrix_);
+        // The spectral representation is needed as well, if retained
+        if (loadedFromCache_ && spectral_ && isotropic_) {
+            loadedFromCache_ = loadPCMSpectra(cacheFile_, fingerprint, nrBlocks, dimBlock, spectralLeft_, spectralRight_, eigenvalues_);
+        }
+        if (loadedFromCache_) {
+            built_ = true;
+            return;
+        }
+    }
     isotropic_ ? buildIsotropicMatrix(cavity, gf_i, gf_o) : buildAnisotropicMatrix(cavity, gf_i, gf_o);
+    if (!matrixCache_.empty()) savePCMMatrix(cacheFile_, fingerprint, blockPCMMatrix_, spectralLeft_, spectralRight_, eigenvalues_);
 }
 
 void IEFSolver::buildAnisotropicMatrix(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
-    fullPCMMatrix_ = anisotropicIEFMatrix(cav, gf_i, gf_o);
-    // Symmetrize K := (K + K+)/2
+    // Each irreducible representation is built and factorized separately,
+    // the full PCM matrix is never formed.
+    // The timer also reports the peak memory at the end of the build
+    TIMER_ON("IEFSolver::buildAnisotropicMatrix");
+    blockPCMMatrix_ = anisotropicIEFBlocks(cav, gf_i, gf_o, operators_);
+    TIMER_OFF("IEFSolver::buildAnisotropicMatrix");
+    // Symmetrize K := (K + K+)/2, block by block
     if (hermitivitize_) {
-        hermitivitize(fullPCMMatrix_);
+        for (size_t i = 0; i < blockPCMMatrix_.size(); ++i) hermitivitize(blockPCMMatrix_[i]);
     }
-    // Pack into a block diagonal matrix
-    // The number of irreps in the group
-    int nrBlocks = cav.pointGroup().nrIrrep();
-    // The size of the irreducible portion of the cavity
-    int dimBlock = cav.irreducible_size();
-    // For the moment just packs into a std::vector<Eigen::MatrixXd>
-    symmetryPacking(blockPCMMatrix_, fullPCMMatrix_, dimBlock, nrBlocks);
 
     built_ = true;
 }
 
 void IEFSolver::buildIsotropicMatrix(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
-    fullPCMMatrix_ = isotropicIEFMatrix(cav, gf_i, profiles::epsilon(gf_o.permittivity()));
-    // Symmetrize K := (K + K+)/2
+    // Each irreducible representation is built and factorized separately,
+    // the full PCM matrix is never formed
+    // The spectral representation needs the same operators, these are computed only once
+    OperatorCache localOperators;
+    OperatorCache * operators = (spectral_ && !operators_) ? &localOperators : operators_;
+    blockPCMMatrix_ = isotropicIEFBlocks(cav, gf_i, profiles::epsilon(gf_o.permittivity()), operators);
+    // Symmetrize K := (K + K+)/2, block by block
     if (hermitivitize_) {
-        hermitivitize(fullPCMMatrix_);
+        for (size_t i = 0; i < blockPCMMatrix_.size(); ++i) hermitivitize(blockPCMMatrix_[i]);
     }
-    // Pack into a block diagonal matrix
-    // The number of irreps in the group
-    int nrBlocks = cav.pointGroup().nrIrrep();
-    // The size of the irreducible portion of the cavity
-    int dimBlock = cav.irreducible_size();
-    // For the moment just packs into a std::vector<Eigen::MatrixXd>
-    symmetryPacking(blockPCMMatrix_, fullPCMMatrix_, dimBlock, nrBlocks);
+    if (spectral_) isotropicIEFSpectra(cav, gf_i, spectralLeft_, spectralRight_, eigenvalues_, operators);
 
     built_ = true;
 }
 
+void IEFSolver::updatePermittivity_impl(double epsilon)
+{
+    if (eigenvalues_.empty()) PCMSOLVER_ERROR("Permittivity can be updated only if the spectral representation is retained (PermittivityUpdate = True)!");
+    // The blocks are formed once, the charges are then obtained by real matrix-vector products
+    for (size_t i = 0; i < eigenvalues_.size(); ++i) {
+        blockPCMMatrix_[i] = isotropicIEFSpectralBlock(spectralLeft_[i], spectralRight_[i],
+                isotropicIEFWeights(eigenvalues_[i], epsilon));
+        if (hermitivitize_) hermitivitize(blockPCMMatrix_[i]);
+    }
+}
+
 Eigen::VectorXd IEFSolver::computeCharge_impl(const Eigen::VectorXd & potential, int irrep) const
 {
     // The potential and charge vector are of dimension equal to the
     // full dimension of the cavity. We have to select just the part
     // relative to the irrep needed.
-    int fullDim = fullPCMMatrix_.rows();
+    int fullDim = potential.size();
     Eigen::VectorXd charge = Eigen::VectorXd::Zero(fullDim);
     int nrBlocks = blockPCMMatrix_.size();
     int irrDim = fullDim/nrBlocks;
@@ -98,6 +130,30 @@ Eigen::VectorXd IEFSolver::computeCharge_impl(const Eigen::VectorXd & potential,
     return charge;
 }
 
+void IEFSolver::computeChargeInto_impl(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+        int irrep) const
+{
+    int fullDim = potential.size();
+    charge.setZero();
+    int nrBlocks = blockPCMMatrix_.size();
+    int irrDim = fullDim/nrBlocks;
+    charge.segment(irrep*irrDim, irrDim).noalias() =
+        - blockPCMMatrix_[irrep] * potential.segment(irrep*irrDim, irrDim);
+}
+
+Eigen::MatrixXd IEFSolver::computeCharges_impl(const Eigen::MatrixXd & potentials, int irrep) const
+{
+    // All the MEPs in the batch are multiplied by the block of the PCM matrix
+    // for the irrep needed at once.
+    int fullDim = potentials.rows();
+    Eigen::MatrixXd charges = Eigen::MatrixXd::Zero(fullDim, potentials.cols());
+    int nrBlocks = blockPCMMatrix_.size();
+    int irrDim = fullDim/nrBlocks;
+    charges.middleRows(irrep*irrDim, irrDim).noalias() =
+        - blockPCMMatrix_[irrep] * potentials.middleRows(irrep*irrDim, irrDim);
+    return charges;
+}
+
 std::ostream & IEFSolver::printSolver(std::ostream & os)
 {
     std::string type;
@@ -112,6 +168,8 @@ std::ostream & IEFSolver::printSolver(std::ostream & os)
     } else {
         os << "PCM matrix NOT hermitivitized (matches old DALTON)";
     }
+    if (!matrixCache_.empty()) os << std::endl << "PCM matrix cached in: " << matrixCache_;
+    if (spectral_) os << std::endl << "Spectral representation of the PCM matrix retained for permittivity updates";
 
     return os;
 }
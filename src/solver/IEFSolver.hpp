@@ -52,8 +52,11 @@ public:
     IEFSolver() {}
     /*! \brief Construct solver
      *  \param[in] symm whether the system matrix has to be symmetrized
+     *  \param[in] cache directory of the on-disk PCM matrix cache, no caching when empty
+     *  \param[in] spectral whether the spectral representation of the isotropic PCM matrix has to be retained
      */
-    IEFSolver(bool symm) : PCMSolver(), hermitivitize_(symm) {}
+    IEFSolver(bool symm, const std::string & cache = "", bool spectral = false)
+        : PCMSolver(), hermitivitize_(symm), matrixCache_(cache), loadedFromCache_(false), spectral_(spectral) {}
     virtual ~IEFSolver() {}
     /*! \brief Builds PCM matrix for an anisotropic environment
      *  \param[in] cavity the cavity to be used.
@@ -67,16 +70,32 @@ public:
      *  \param[in] gf_o Green's function outside the cavity
      */
     void buildIsotropicMatrix(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o);
+    /*! Name of the cache file of the PCM matrix, empty when the PCM matrix is not cached */
+    const std::string & cacheFile() const { return cacheFile_; }
+    /*! Whether the PCM matrix was loaded from the cache file, rather than built */
+    bool loadedFromCache() const { return loadedFromCache_; }
     friend std::ostream & operator<<(std::ostream & os, IEFSolver & solver) {
         return solver.printSolver(os);
     }
 private:
     /*! Whether the system matrix has to be symmetrized */
     bool hermitivitize_;
-    /*! PCM matrix, not symmetry blocked */
-    Eigen::MatrixXd fullPCMMatrix_;
-    /*! PCM matrix, symmetry blocked form */
+    /*! Directory of the on-disk PCM matrix cache, no caching when empty */
+    std::string matrixCache_;
+    /*! Name of the cache file of the PCM matrix, empty when the PCM matrix is not cached */
+    std::string cacheFile_;
+    /*! Whether the PCM matrix was loaded from the cache file */
+    bool loadedFromCache_;
+    /*! Whether the spectral representation of the isotropic PCM matrix is retained */
+    bool spectral_;
+    /*! PCM matrix, symmetry blocked form, one block per irreducible representation */
     std::vector<Eigen::MatrixXd> blockPCMMatrix_;
+    /*! Spectral representation, \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ per irreducible representation */
+    std::vector<Eigen::MatrixXcd> spectralLeft_;
+    /*! Spectral representation, \f$ \mathbf{V}^{-1} \f$ per irreducible representation */
+    std::vector<Eigen::MatrixXcd> spectralRight_;
+    /*! Spectral representation, eigenvalues of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$ per irreducible representation */
+    std::vector<Eigen::VectorXcd> eigenvalues_;
 
     /*! \brief Calculation of the PCM matrix
      *  \param[in] cavity the cavity to be used
@@ -84,12 +103,33 @@ private:
      *  \param[in] gf_o Green's function outside the cavity
      */
     virtual void buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o) __override;
+    /*! \brief Updates the PCM matrix for a new permittivity outside the cavity
+     *  \param[in] epsilon the new permittivity outside the cavity
+     *
+     *  Only the diagonal of the spectral representation is recomputed, in \f$ O(N) \f$ operations.
+     *  The blocks of the PCM matrix are then formed again from the spectral representation,
+     *  once per update, and the charges are obtained by real matrix-vector products.
+     */
+    virtual void updatePermittivity_impl(double epsilon) __override;
     /*! \brief Returns the ASC given the MEP and the desired irreducible representation
      *  \param[in] potential the vector containing the MEP at cavity points
      *  \param[in] irrep the irreducible representation of the MEP and ASC
      */
     virtual Eigen::VectorXd computeCharge_impl(const Eigen::VectorXd & potential,
             int irrep = 0) const __override;
+    /*! \brief Computes the ASC given the MEP and the desired irreducible representation
+     *  \param[in] potential the vector containing the MEP at cavity points
+     *  \param[out] charge the vector where the ASC at cavity points is written
+     *  \param[in] irrep the irreducible representation of the MEP and ASC
+     */
+    virtual void computeChargeInto_impl(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+            int irrep = 0) const __override;
+    /*! \brief Returns the ASCs given a batch of MEPs and the desired irreducible representation
+     *  \param[in] potentials the matrix containing the MEPs at cavity points, one per column
+     *  \param[in] irrep the irreducible representation of the MEPs and ASCs
+     */
+    virtual Eigen::MatrixXd computeCharges_impl(const Eigen::MatrixXd & potentials,
+            int irrep = 0) const __override;
     virtual std::ostream & printSolver(std::ostream & os) __override;
 };
 
@@ -0,0 +1,222 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "IterativeSolver.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "Cavity.hpp"
+#include "Element.hpp"
+#include "HMatrix.hpp"
+#include "IGreensFunction.hpp"
+#include "KrylovSolvers.hpp"
+#include "MathUtils.hpp"
+#include "Treecode.hpp"
+
+void IterativeSolver::buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
+{
+    isotropic_ = (gf_i.uniform() && gf_o.uniform());
+    if (!isotropic_) PCMSOLVER_ERROR("Matrix-free solvers are defined only for isotropic environments!");
+    if (openingAngle_ > 0.0 && compression_ > 0.0)
+        PCMSOLVER_ERROR("Treecode and hierarchical matrix compression cannot be used together!");
+    gf_i_ = &gf_i;
+    epsilonInside_ = profiles::epsilon(gf_i.permittivity());
+    epsilon_ = profiles::epsilon(gf_o.permittivity());
+    nrBlocks_ = cavity.pointGroup().nrIrrep();
+    dimBlock_ = cavity.irreducible_size();
+
+    size_t cavitySize = cavity.size();
+    centers_ = cavity.elementCenter();
+    normals_ = cavity.elementNormal();
+    normals_.colwise().normalize();
+    areas_ = cavity.elementArea();
+    // The diagonal elements are obtained from the integrator policy of the
+    // Green's function, by building the operators on each finite element alone.
+    // The diagonal of D by the sum rule is computed once the operators are set up
+    bool sumRule = !conductor_ && gf_i.sumRuleDiagonal();
+    diagonalS_ = Eigen::VectorXd::Zero(cavitySize);
+    diagonalD_ = Eigen::VectorXd::Zero(cavitySize);
+    for (size_t i = 0; i < cavitySize; ++i) {
+        std::vector<Element> single(1, cavity.elements()[i]);
+        diagonalS_(i) = gf_i.singleLayer(single)(0, 0);
+        if (!conductor_ && !sumRule) diagonalD_(i) = gf_i.doubleLayer(single)(0, 0);
+    }
+    guess_.assign(nrBlocks_, Eigen::VectorXd::Zero(cavitySize));
+    if (openingAngle_ > 0.0) {
+        treecode_ = pcm::make_shared<Treecode>(centers_, openingAngle_);
+    } else {
+        treecode_.reset();
+    }
+    singleLayer_.reset();
+    doubleLayer_.reset();
+    // D_ii = -(2 * M_PI + sum_{j != i} D_ij * a_j) / a_i, the sum is the action
+    // of the off-diagonal part of D, with a zero diagonal, on the areas
+    if (sumRule) diagonalD_ = - (2 * M_PI + applyD(areas_).array()) / areas_.array();
+    if (compression_ > 0.0) {
+        singleLayer_ = pcm::make_shared<HMatrix>(centers_,
+                pcm::bind(&IterativeSolver::entryS, this, pcm::_1, pcm::_2), compression_);
+        if (!conductor_) doubleLayer_ = pcm::make_shared<HMatrix>(centers_,
+                pcm::bind(&IterativeSolver::entryD, this, pcm::_1, pcm::_2), compression_);
+    }
+
+    built_ = true;
+}
+
+double IterativeSolver::entryS(int i, int j) const
+{
+    if (i == j) return diagonalS_(i);
+    return gf_i_->kernelS(centers_.col(i), centers_.col(j));
+}
+
+double IterativeSolver::entryD(int i, int j) const
+{
+    if (i == j) return diagonalD_(i);
+    return gf_i_->kernelD(normals_.col(j), centers_.col(i), centers_.col(j));
+}
+
+Eigen::VectorXd IterativeSolver::applyS(const Eigen::VectorXd & x) const
+{
+    if (singleLayer_) return singleLayer_->apply(x);
+    size_t cavitySize = x.size();
+    Eigen::VectorXd Sx = diagonalS_.cwiseProduct(x);
+    if (treecode_) {
+        // The kernel is 1 / (epsilon * r)
+        Sx += treecode_->potential(x, Eigen::Matrix3Xd::Zero(3, cavitySize)) / epsilonInside_;
+        return Sx;
+    }
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t i = 0; i < cavitySize; ++i) {
+        try {
+            Eigen::Vector3d source = centers_.col(i);
+            for (size_t j = 0; j < cavitySize; ++j) {
+                if (i != j) Sx(i) += gf_i_->kernelS(source, centers_.col(j)) * x(j);
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    return Sx;
+}
+
+Eigen::VectorXd IterativeSolver::applyD(const Eigen::VectorXd & x) const
+{
+    if (doubleLayer_) return doubleLayer_->apply(x);
+    size_t cavitySize = x.size();
+    Eigen::VectorXd Dx = diagonalD_.cwiseProduct(x);
+    if (treecode_) {
+        // The kernel is the potential of a unit dipole along the normal
+        Dx += treecode_->potential(Eigen::VectorXd::Zero(cavitySize), normals_ * x.asDiagonal());
+        return Dx;
+    }
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t i = 0; i < cavitySize; ++i) {
+        try {
+            Eigen::Vector3d source = centers_.col(i);
+            for (size_t j = 0; j < cavitySize; ++j) {
+                if (i != j) Dx(i) += gf_i_->kernelD(normals_.col(j), source, centers_.col(j)) * x(j);
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    return Dx;
+}
+
+Eigen::VectorXd IterativeSolver::applyT(const Eigen::VectorXd & x) const
+{
+    // T = (2 * M_PI * fact * aInv - DI) * a * SI
+    double fact = (epsilon_ + 1.0)/(epsilon_ - 1.0);
+    Eigen::VectorXd Sx = applyS(x);
+    return (2 * M_PI * fact * Sx - applyD(areas_.cwiseProduct(Sx)));
+}
+
+Eigen::VectorXd IterativeSolver::computeCharge_impl(const Eigen::VectorXd & potential, int irrep) const
+{
+    // The potential and charge vector are of dimension equal to the
+    // full dimension of the cavity. We have to select just the part
+    // relative to the irrep needed.
+    // The operators act on the full cavity, thus the symmetry adapted
+    // potential is transformed back, the system solved and the charge
+    // symmetry adapted again.
+    int fullDim = potential.size();
+    Eigen::VectorXd mep = Eigen::VectorXd::Zero(fullDim);
+    mep.segment(irrep*dimBlock_, dimBlock_) = potential.segment(irrep*dimBlock_, dimBlock_);
+    mep = symmetryAdapt(mep, dimBlock_, nrBlocks_, true);
+
+    Eigen::VectorXd & charge = guess_[irrep];
+    if (conductor_) {
+        // Solve SI * q = - f(epsilon) * v by conjugate gradient
+        double fact = (epsilon_ - 1.0)/(epsilon_ + correction_);
+        krylov::conjugateGradient(pcm::bind(&IterativeSolver::applyS, this, pcm::_1),
+                - fact * mep, charge, threshold_, maxIterations_);
+    } else {
+        // Solve T * q = - R * a * v by GMRES
+        // R * a = (2 * M_PI * aInv - DI) * a
+        Eigen::VectorXd rhs = - (2 * M_PI * mep - applyD(areas_.cwiseProduct(mep)));
+        krylov::gmres(pcm::bind(&IterativeSolver::applyT, this, pcm::_1),
+                rhs, charge, threshold_, maxIterations_);
+    }
+
+    Eigen::VectorXd asc = Eigen::VectorXd::Zero(fullDim);
+    asc.segment(irrep*dimBlock_, dimBlock_) =
+        symmetryAdapt(charge, dimBlock_, nrBlocks_).segment(irrep*dimBlock_, dimBlock_);
+    return asc;
+}
+
+std::ostream & IterativeSolver::printSolver(std::ostream & os)
+{
+    if (conductor_) {
+        os << "Solver Type: C-PCM, matrix-free (conjugate gradient)" << std::endl;
+    } else {
+        os << "Solver Type: IEFPCM, isotropic, matrix-free (GMRES)" << std::endl;
+    }
+    os << "Convergence threshold: " << threshold_ << std::endl;
+    os << "Maximum number of iterations: " << maxIterations_;
+    if (openingAngle_ > 0.0) {
+        os << std::endl << "Operators applied by treecode, opening angle: " << openingAngle_;
+    }
+    if (singleLayer_) {
+        size_t storage = singleLayer_->storage() + (doubleLayer_ ? doubleLayer_->storage() : 0);
+        size_t dense = singleLayer_->denseStorage() * (doubleLayer_ ? 2 : 1);
+        os << std::endl << "Operators compressed as hierarchical matrices, tolerance: " << compression_;
+        os << std::endl << "Storage: " << (100.0 * storage) / dense << "% of the dense operators";
+    }
+
+    return os;
+}
@@ -0,0 +1,178 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef ITERATIVESOLVER_HPP
+#define ITERATIVESOLVER_HPP
+
+#include <iosfwd>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+class Cavity;
+class IGreensFunction;
+
+#include "HMatrix.hpp"
+#include "PCMSolver.hpp"
+#include "Treecode.hpp"
+
+/*! \file IterativeSolver.hpp
+ *  \class IterativeSolver
+ *  \brief Matrix-free IEFPCM and C-PCM collocation solver
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  The PCM matrix is never formed. The action of the S and D operators on a vector
+ *  is computed on-the-fly from the kernels of the Green's function inside the cavity.
+ *  The linear system is solved by conjugate gradient for C-PCM:
+ *  \f[
+ *      \mathbf{S}_\mathrm{i}\mathbf{q} = -f(\varepsilon)\mathbf{v}
+ *  \f]
+ *  and by GMRES for the isotropic IEFPCM:
+ *  \f[
+ *      \left(2\pi\frac{\varepsilon+1}{\varepsilon-1}\mathbf{I} - \mathbf{D}_\mathrm{i}\mathbf{A}\right)\mathbf{S}_\mathrm{i}\mathbf{q}
+ *      = -\left(2\pi\mathbf{I} - \mathbf{D}_\mathrm{i}\mathbf{A}\right)\mathbf{v}
+ *  \f]
+ *  The solution for the previous call is used as initial guess for the next one
+ *  in the same irreducible representation.
+ *  When a positive opening angle is given, the off-diagonal part of the operators is applied
+ *  by a Barnes-Hut treecode, in \f$ O(N\log N) \f$ operations, instead of the
+ *  \f$ O(N^2) \f$ direct summation.
+ *  When a positive compression tolerance is given, the operators are instead stored
+ *  as hierarchical matrices, for any Green's function, and applied in \f$ O(N\log N) \f$ operations.
+ *  The diagonal elements are those of the integrator of the Green's function on each finite
+ *  element alone. When the integrator obtains the diagonal of D by the sum rule, as
+ *  PurisimaIntegrator does, the solver applies the sum rule to its off-diagonal elements.
+ *  \warning The Green's function inside the cavity is **not** copied, it has to outlive the solver.
+ *  The PCM matrix cannot be hermitivitized.
+ */
+
+class IterativeSolver : public PCMSolver
+{
+public:
+    IterativeSolver() {}
+    /*! \brief Construct solver
+     *  \param[in] conductor whether the C-PCM or the IEFPCM equation has to be solved
+     *  \param[in] corr factor to correct the conductor results
+     *  \param[in] thresh convergence threshold on the relative residual
+     *  \param[in] maxIt maximum number of iterations
+     *  \param[in] theta opening angle for the treecode, direct summation when zero
+     *  \param[in] hTol tolerance of the hierarchical matrix compression, no compression when zero
+     */
+    IterativeSolver(bool conductor, double corr, double thresh, int maxIt, double theta = 0.0, double hTol = 0.0)
+        : PCMSolver(), conductor_(conductor), correction_(corr), threshold_(thresh),
+          maxIterations_(maxIt), openingAngle_(theta), compression_(hTol), gf_i_(NULL) {}
+    virtual ~IterativeSolver() {}
+    friend std::ostream & operator<<(std::ostream & os, IterativeSolver & solver) {
+        return solver.printSolver(os);
+    }
+private:
+    /*! Whether the C-PCM or the IEFPCM equation has to be solved */
+    bool conductor_;
+    /*! Correction for the conductor results */
+    double correction_;
+    /*! Convergence threshold on the relative residual */
+    double threshold_;
+    /*! Maximum number of iterations */
+    int maxIterations_;
+    /*! Opening angle for the treecode, direct summation when zero */
+    double openingAngle_;
+    /*! Treecode for the off-diagonal part of the operators */
+    pcm::shared_ptr<Treecode> treecode_;
+    /*! Tolerance of the hierarchical matrix compression, no compression when zero */
+    double compression_;
+    /*! The S operator as a hierarchical matrix */
+    pcm::shared_ptr<HMatrix> singleLayer_;
+    /*! The D operator as a hierarchical matrix */
+    pcm::shared_ptr<HMatrix> doubleLayer_;
+    /*! Permittivity inside the cavity */
+    double epsilonInside_;
+    /*! Green's function inside the cavity, not owned */
+    const IGreensFunction * gf_i_;
+    /*! Permittivity outside the cavity */
+    double epsilon_;
+    /*! Number of irreducible representations */
+    int nrBlocks_;
+    /*! Size of the irreducible portion of the cavity */
+    int dimBlock_;
+    /*! Finite elements centers */
+    Eigen::Matrix3Xd centers_;
+    /*! Finite elements normals, normalized */
+    Eigen::Matrix3Xd normals_;
+    /*! Finite elements areas */
+    Eigen::VectorXd areas_;
+    /*! Diagonal of the S operator */
+    Eigen::VectorXd diagonalS_;
+    /*! Diagonal of the D operator */
+    Eigen::VectorXd diagonalD_;
+    /*! Solutions of the last call, per irreducible representation, on the full cavity */
+    mutable std::vector<Eigen::VectorXd> guess_;
+
+    /*! \brief Sets up the solver, no matrix is built
+     *  \param[in] cavity the cavity to be used
+     *  \param[in] gf_i Green's function inside the cavity
+     *  \param[in] gf_o Green's function outside the cavity
+     */
+    virtual void buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o) __override;
+    /*! \brief Updates the solver for a new permittivity outside the cavity
+     *  \param[in] epsilon the new permittivity outside the cavity
+     *
+     *  No matrix is stored, only the permittivity is changed.
+     */
+    virtual void updatePermittivity_impl(double epsilon) __override { epsilon_ = epsilon; }
+    /*! \brief Returns the ASC given the MEP and the desired irreducible representation
+     *  \param[in] potential the vector containing the MEP at cavity points
+     *  \param[in] irrep the irreducible representation of the MEP and ASC
+     */
+    virtual Eigen::VectorXd computeCharge_impl(const Eigen::VectorXd & potential,
+            int irrep = 0) const __override;
+    virtual std::ostream & printSolver(std::ostream & os) __override;
+    /*! \brief Matrix element of the S operator
+     *  \param[in] i row index
+     *  \param[in] j column index
+     */
+    double entryS(int i, int j) const;
+    /*! \brief Matrix element of the D operator
+     *  \param[in] i row index
+     *  \param[in] j column index
+     */
+    double entryD(int i, int j) const;
+    /*! \brief Action of the S operator on a vector
+     *  \param[in] x the vector
+     */
+    Eigen::VectorXd applyS(const Eigen::VectorXd & x) const;
+    /*! \brief Action of the D operator on a vector
+     *  \param[in] x the vector
+     */
+    Eigen::VectorXd applyD(const Eigen::VectorXd & x) const;
+    /*! \brief Action of the IEFPCM T operator on a vector
+     *  \param[in] x the vector
+     */
+    Eigen::VectorXd applyT(const Eigen::VectorXd & x) const;
+};
+
+#endif // ITERATIVESOLVER_HPP
@@ -0,0 +1,152 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef KRYLOVSOLVERS_HPP
+#define KRYLOVSOLVERS_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+/*! \file KrylovSolvers.hpp
+ *  \brief Iterative solvers for linear systems given only the action of the matrix on a vector
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ */
+
+namespace krylov {
+/*! \typedef LinearOperator
+ *  \brief functor handle to the matrix-vector product \f$ \mathbf{y} = \mathbf{A}\mathbf{x} \f$
+ */
+typedef pcm::function<Eigen::VectorXd(const Eigen::VectorXd &)> LinearOperator;
+
+/*! \brief Solves \f$ \mathbf{A}\mathbf{x} = \mathbf{b} \f$ by the conjugate gradient method
+ *  \param[in] A matrix-vector product for a symmetric positive definite matrix
+ *  \param[in] b right-hand side
+ *  \param[in,out] x initial guess on input, solution on output
+ *  \param[in] threshold convergence threshold on the relative residual norm
+ *  \param[in] maxIterations maximum number of iterations
+ *  \return the number of iterations performed
+ */
+inline int conjugateGradient(const LinearOperator & A, const Eigen::VectorXd & b, Eigen::VectorXd & x,
+                             double threshold, int maxIterations)
+{
+    double bNorm = b.norm();
+    if (bNorm == 0.0) {
+        x.setZero(b.size());
+        return 0;
+    }
+    Eigen::VectorXd r = b - A(x);
+    Eigen::VectorXd p = r;
+    double rr = r.squaredNorm();
+    int iter = 0;
+    while (std::sqrt(rr) > threshold * bNorm) {
+        if (iter == maxIterations)
+            PCMSOLVER_ERROR("Conjugate gradient did not converge in the maximum number of iterations!");
+        Eigen::VectorXd Ap = A(p);
+        double alpha = rr / p.dot(Ap);
+        x += alpha * p;
+        r -= alpha * Ap;
+        double rr_new = r.squaredNorm();
+        p = r + (rr_new / rr) * p;
+        rr = rr_new;
+        ++iter;
+    }
+    return iter;
+}
+
+/*! \brief Solves \f$ \mathbf{A}\mathbf{x} = \mathbf{b} \f$ by the restarted GMRES method
+ *  \param[in] A matrix-vector product for a general square matrix
+ *  \param[in] b right-hand side
+ *  \param[in,out] x initial guess on input, solution on output
+ *  \param[in] threshold convergence threshold on the relative residual norm
+ *  \param[in] maxIterations maximum number of iterations, summed over all restarts
+ *  \param[in] restart dimension of the Krylov subspace before restarting
+ *  \return the number of iterations performed
+ *
+ *  The least-squares problem on the Hessenberg matrix is solved by Givens rotations,
+ *  as described in Y. Saad, Iterative Methods for Sparse Linear Systems, 2nd ed. (2003)
+ */
+inline int gmres(const LinearOperator & A, const Eigen::VectorXd & b, Eigen::VectorXd & x,
+                 double threshold, int maxIterations, int restart = 50)
+{
+    double bNorm = b.norm();
+    if (bNorm == 0.0) {
+        x.setZero(b.size());
+        return 0;
+    }
+    int m = std::min(restart, static_cast<int>(b.size()));
+    int iter = 0;
+    while (true) {
+        Eigen::VectorXd r = b - A(x);
+        double beta = r.norm();
+        if (beta <= threshold * bNorm) return iter;
+        if (iter >= maxIterations)
+            PCMSOLVER_ERROR("GMRES did not converge in the maximum number of iterations!");
+        // Arnoldi basis, Hessenberg matrix and Givens rotations
+        Eigen::MatrixXd V = Eigen::MatrixXd::Zero(b.size(), m + 1);
+        Eigen::MatrixXd H = Eigen::MatrixXd::Zero(m + 1, m);
+        Eigen::VectorXd cs = Eigen::VectorXd::Zero(m), sn = Eigen::VectorXd::Zero(m);
+        Eigen::VectorXd g = Eigen::VectorXd::Zero(m + 1);
+        V.col(0) = r / beta;
+        g(0) = beta;
+        int k = 0;
+        while (k < m && iter < maxIterations) {
+            // Modified Gram-Schmidt orthogonalization of the new Krylov vector
+            Eigen::VectorXd w = A(V.col(k));
+            for (int i = 0; i <= k; ++i) {
+                H(i, k) = w.dot(V.col(i));
+                w -= H(i, k) * V.col(i);
+            }
+            H(k + 1, k) = w.norm();
+            if (H(k + 1, k) != 0.0) V.col(k + 1) = w / H(k + 1, k);
+            // Apply previous rotations to the new column, then compute the new one
+            for (int i = 0; i < k; ++i) {
+                double tmp = cs(i) * H(i, k) + sn(i) * H(i + 1, k);
+                H(i + 1, k) = -sn(i) * H(i, k) + cs(i) * H(i + 1, k);
+                H(i, k) = tmp;
+            }
+            double denom = std::sqrt(H(k, k) * H(k, k) + H(k + 1, k) * H(k + 1, k));
+            cs(k) = H(k, k) / denom;
+            sn(k) = H(k + 1, k) / denom;
+            H(k, k) = denom;
+            H(k + 1, k) = 0.0;
+            g(k + 1) = -sn(k) * g(k);
+            g(k) = cs(k) * g(k);
+            ++k;
+            ++iter;
+            if (std::abs(g(k)) <= threshold * bNorm) break;
+        }
+        // Solve the upper triangular system and update the solution
+        Eigen::VectorXd y = H.topLeftCorner(k, k).triangularView<Eigen::Upper>().solve(g.head(k));
+        x += V.leftCols(k) * y;
+    }
+}
+} // namespace krylov
+
+#endif // KRYLOVSOLVERS_HPP
@@ -0,0 +1,274 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "MatrixCache.hpp"
+
+#include <complex>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "Cavity.hpp"
+#include "Element.hpp"
+#include "IGreensFunction.hpp"
+#include "cnpy.hpp"
+
+namespace
+{
+    /*! \brief Accumulates a sequence of bytes into a 64-bit FNV-1a hash
+     *  \param[in] hash the current value of the hash
+     *  \param[in] data pointer to the bytes
+     *  \param[in] nBytes number of bytes
+     */
+    unsigned long long fnv1a(unsigned long long hash, const void * data, size_t nBytes)
+    {
+        const unsigned char * bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < nBytes; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    template <typename Derived>
+    unsigned long long fnv1a(unsigned long long hash, const Eigen::DenseBase<Derived> & matrix)
+    {
+        typename Derived::PlainObject copy = matrix;
+        return fnv1a(hash, copy.data(), copy.size() * sizeof(typename Derived::Scalar));
+    }
+
+    unsigned long long fnv1a(unsigned long long hash, const std::string & str)
+    {
+        return fnv1a(hash, str.data(), str.size());
+    }
+
+    /*! \brief Samples the kernels and the diagonal elements of a Green's function
+     *  \param[in] cavity the cavity
+     *  \param[in] gf the Green's function
+     *
+     *  These depend on all the parameters of the Green's function and of its
+     *  integrator, without the need to know its concrete type.
+     */
+    Eigen::VectorXd sampleGreensFunction(const Cavity & cavity, const IGreensFunction & gf)
+    {
+        size_t size = cavity.size();
+        size_t samples[] = {0, size / 3, (2 * size) / 3, size - 1};
+        Eigen::VectorXd values(10);
+        for (int k = 0; k < 3; ++k) {
+            Eigen::Vector3d source = cavity.elementCenter(samples[k]);
+            Eigen::Vector3d probe = cavity.elementCenter(samples[k + 1]);
+            values(2 * k) = (samples[k] == samples[k + 1]) ? 0.0 : gf.kernelS(source, probe);
+            values(2 * k + 1) = (samples[k] == samples[k + 1]) ? 0.0 :
+                gf.kernelD(cavity.elementNormal(samples[k + 1]), source, probe);
+        }
+        for (int k = 0; k < 2; ++k) {
+            std::vector<Element> single(1, cavity.elements()[samples[3 * k]]);
+            values(6 + 2 * k) = gf.singleLayer(single)(0, 0);
+            values(7 + 2 * k) = gf.doubleLayer(single)(0, 0);
+        }
+        return values;
+    }
+
+    /*! \brief Accumulates the finite elements data of a cavity into a 64-bit FNV-1a hash
+     *  \param[in] hash the current value of the hash
+     *  \param[in] cavity the cavity
+     */
+    unsigned long long fnv1a(unsigned long long hash, const Cavity & cavity)
+    {
+        int nrIrrep = cavity.pointGroup().nrIrrep();
+        hash = fnv1a(hash, &nrIrrep, sizeof(int));
+        hash = fnv1a(hash, cavity.elementCenter());
+        hash = fnv1a(hash, cavity.elementNormal());
+        hash = fnv1a(hash, cavity.elementArea());
+        hash = fnv1a(hash, cavity.elementRadius());
+        return fnv1a(hash, cavity.elementSphereCenter());
+    }
+
+    /*! \brief Accumulates the type and the integrator parameter of a Green's function into a 64-bit FNV-1a hash
+     *  \param[in] hash the current value of the hash
+     *  \param[in] gf the Green's function
+     */
+    unsigned long long fnv1a(unsigned long long hash, const IGreensFunction & gf)
+    {
+        double parameter = gf.integratorParameter();
+        hash = fnv1a(hash, std::string(typeid(gf).name()));
+        return fnv1a(hash, &parameter, sizeof(double));
+    }
+
+    /*! \brief Copies an array of the cache file into a matrix
+     *  \param[in] cache the cache file
+     *  \param[in] name name of the array
+     *  \param[in] rows expected number of rows
+     *  \param[in] cols expected number of columns, 1 for a vector
+     *  \param[out] matrix the matrix
+     *  \return whether the array was found with the expected dimensions
+     */
+    template <typename Matrix>
+    bool loadArray(const cnpy::npz_mmap_t & cache, const std::string & name, int rows, int cols,
+            Matrix & matrix)
+    {
+        typedef typename Matrix::Scalar Scalar;
+        cnpy::npz_mmap_t::const_iterator raw = cache.find(name);
+        if (raw == cache.end() || raw->second.word_size != sizeof(Scalar)) return false;
+        const std::vector<unsigned int> & shape = raw->second.shape;
+        bool found = (cols == 1) ? (shape.size() == 1 && static_cast<int>(shape[0]) == rows)
+            : (shape.size() == 2 && static_cast<int>(shape[0]) == rows && static_cast<int>(shape[1]) == cols);
+        if (found) matrix = Eigen::Map<Matrix>(reinterpret_cast<Scalar *>(raw->second.data), rows, cols);
+        return found;
+    }
+
+    std::string toHex(unsigned long long hash)
+    {
+        std::ostringstream fingerprint;
+        fingerprint << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return fingerprint.str();
+    }
+}
+
+std::string PCMMatrixFingerprint(const Cavity & cavity, const IGreensFunction & gf_i,
+        const IGreensFunction & gf_o, const std::string & options)
+{
+    unsigned long long hash = fnv1a(14695981039346656037ULL, cavity);
+    hash = fnv1a(hash, gf_i);
+    hash = fnv1a(hash, sampleGreensFunction(cavity, gf_i));
+    hash = fnv1a(hash, gf_o);
+    hash = fnv1a(hash, sampleGreensFunction(cavity, gf_o));
+    hash = fnv1a(hash, options);
+    return toHex(hash);
+}
+
+std::string BoundaryOperatorsFingerprint(const Cavity & cavity, const IGreensFunction & gf)
+{
+    unsigned long long hash = fnv1a(14695981039346656037ULL, cavity);
+    hash = fnv1a(hash, gf);
+    hash = fnv1a(hash, sampleGreensFunction(cavity, gf));
+    return toHex(hash);
+}
+
+std::string GreensFunctionFingerprint(const IGreensFunction & gf)
+{
+    Eigen::Vector3d source(0.1, 0.2, 0.3), probe(1.7, -0.4, 0.9), direction(0.0, 0.6, 0.8);
+    Eigen::Vector2d values(gf.kernelS(source, probe), gf.kernelD(direction, source, probe));
+    unsigned long long hash = fnv1a(fnv1a(14695981039346656037ULL, gf), values);
+    return toHex(hash);
+}
+
+std::string PCMMatrixCacheFile(const std::string & directory, const std::string & fingerprint)
+{
+    return directory + "/PCMMatrix_" + fingerprint + ".npz";
+}
+
+bool loadPCMMatrix(const std::string & fname, const std::string & fingerprint, int nrBlocks, int dimBlock,
+        std::vector<Eigen::MatrixXd> & blocks)
+{
+    // A missing file is a cache miss
+    if (!std::ifstream(fname.c_str())) return false;
+
+    // The blocks are copied straight from the memory-mapped file
+    cnpy::npz_mmap_t cache(fname);
+    cnpy::npz_mmap_t::const_iterator raw_fingerprint = cache.find("fingerprint");
+    bool hit = (raw_fingerprint != cache.end()
+            && std::string(raw_fingerprint->second.data, raw_fingerprint->second.shape[0]) == fingerprint);
+    std::vector<Eigen::MatrixXd> loaded(nrBlocks);
+    for (int i = 0; hit && i < nrBlocks; ++i) {
+        cnpy::npz_mmap_t::const_iterator raw_block = cache.find("block_" + pcm::to_string(i));
+        hit = (raw_block != cache.end()
+                && raw_block->second.shape.size() == 2
+                && static_cast<int>(raw_block->second.shape[0]) == dimBlock
+                && static_cast<int>(raw_block->second.shape[1]) == dimBlock
+                && raw_block->second.word_size == sizeof(double));
+        if (hit) {
+            loaded[i] = Eigen::Map<Eigen::MatrixXd>(reinterpret_cast<double *>(raw_block->second.data),
+                    dimBlock, dimBlock);
+        }
+    }
+    if (hit) blocks.swap(loaded);
+    return hit;
+}
+
+bool loadPCMSpectra(const std::string & fname, const std::string & fingerprint, int nrBlocks, int dimBlock,
+        std::vector<Eigen::MatrixXcd> & left, std::vector<Eigen::MatrixXcd> & right,
+        std::vector<Eigen::VectorXcd> & eigenvalues)
+{
+    // A missing file, or one saved without the spectral representation, is a cache miss
+    if (!std::ifstream(fname.c_str())) return false;
+
+    cnpy::npz_mmap_t cache(fname);
+    cnpy::npz_mmap_t::const_iterator raw_fingerprint = cache.find("fingerprint");
+    bool hit = (raw_fingerprint != cache.end()
+            && std::string(raw_fingerprint->second.data, raw_fingerprint->second.shape[0]) == fingerprint);
+    std::vector<Eigen::MatrixXcd> loadedLeft(nrBlocks), loadedRight(nrBlocks);
+    std::vector<Eigen::VectorXcd> loadedEigenvalues(nrBlocks);
+    for (int i = 0; hit && i < nrBlocks; ++i) {
+        std::string irrep = pcm::to_string(i);
+        hit = loadArray(cache, "spectral_left_" + irrep, dimBlock, dimBlock, loadedLeft[i])
+            && loadArray(cache, "spectral_right_" + irrep, dimBlock, dimBlock, loadedRight[i])
+            && loadArray(cache, "eigenvalues_" + irrep, dimBlock, 1, loadedEigenvalues[i]);
+    }
+    if (hit) {
+        left.swap(loadedLeft);
+        right.swap(loadedRight);
+        eigenvalues.swap(loadedEigenvalues);
+    }
+    return hit;
+}
+
+void savePCMMatrix(const std::string & fname, const std::string & fingerprint,
+        const std::vector<Eigen::MatrixXd> & blocks,
+        const std::vector<Eigen::MatrixXcd> & left, const std::vector<Eigen::MatrixXcd> & right,
+        const std::vector<Eigen::VectorXcd> & eigenvalues)
+{
+    std::string tmp = fname + ".tmp";
+    if (!std::ofstream(tmp.c_str(), std::ios_base::out | std::ios_base::binary)) {
+        PCMSOLVER_ERROR("Unable to write the PCM matrix cache file " + fname);
+    }
+    const unsigned int fingerprint_shape[] = {static_cast<unsigned int>(fingerprint.size())};
+    cnpy::npz_save(tmp, "fingerprint", fingerprint.data(), fingerprint_shape, 1, "w", false);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const unsigned int block_shape[] = {static_cast<unsigned int>(blocks[i].rows()),
+            static_cast<unsigned int>(blocks[i].cols())};
+        cnpy::npz_save(tmp, "block_" + pcm::to_string(i), blocks[i].data(), block_shape, 2, "a", true);
+    }
+    for (size_t i = 0; i < eigenvalues.size(); ++i) {
+        std::string irrep = pcm::to_string(i);
+        const unsigned int dim = static_cast<unsigned int>(eigenvalues[i].size());
+        const unsigned int matrix_shape[] = {dim, dim};
+        const unsigned int vector_shape[] = {dim};
+        cnpy::npz_save(tmp, "spectral_left_" + irrep, left[i].data(), matrix_shape, 2, "a", true);
+        cnpy::npz_save(tmp, "spectral_right_" + irrep, right[i].data(), matrix_shape, 2, "a", true);
+        cnpy::npz_save(tmp, "eigenvalues_" + irrep, eigenvalues[i].data(), vector_shape, 1, "a", true);
+    }
+    if (std::rename(tmp.c_str(), fname.c_str()) != 0) {
+        PCMSOLVER_ERROR("Unable to write the PCM matrix cache file " + fname);
+    }
+}
@@ -0,0 +1,138 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef MATRIXCACHE_HPP
+#define MATRIXCACHE_HPP
+
+#include <string>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+class Cavity;
+class IGreensFunction;
+
+/*! \file MatrixCache.hpp
+ *  \brief On-disk cache of the symmetry blocked PCM matrix
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  The blocks of the PCM matrix are saved to a .npz file, named after a fingerprint
+ *  of the cavity, of the Green's functions and of the solver options.
+ *  Subsequent calculations at the same geometry and with the same medium, e.g.
+ *  restarts, property calculations or multiple states, load the matrix from the
+ *  cache instead of building it again.
+ */
+
+/*! \brief Returns the fingerprint of a PCM matrix, as an hexadecimal string
+ *  \param[in] cavity the cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[in] gf_o Green's function outside the cavity
+ *  \param[in] options description of the solver and of its options
+ *
+ *  The fingerprint is a 64-bit FNV-1a hash of the finite elements data, of the
+ *  type of the Green's functions and of the parameter of their integrators, of their kernels sampled at a few pairs of
+ *  cavity points, of the diagonal elements of their boundary integral operators
+ *  and of the solver options.
+ */
+std::string PCMMatrixFingerprint(const Cavity & cavity, const IGreensFunction & gf_i,
+        const IGreensFunction & gf_o, const std::string & options);
+
+/*! \brief Returns the fingerprint of the boundary integral operators of a Green's function
+ *  \param[in] cavity the cavity
+ *  \param[in] gf the Green's function
+ *
+ *  As PCMMatrixFingerprint, for a single Green's function and without solver options.
+ */
+std::string BoundaryOperatorsFingerprint(const Cavity & cavity, const IGreensFunction & gf);
+
+/*! \brief Returns the fingerprint of a Green's function, independent of the cavity
+ *  \param[in] gf the Green's function
+ *
+ *  The fingerprint is a 64-bit FNV-1a hash of the type of the Green's function,
+ *  of the parameter of its integrator and of its kernels sampled at a few fixed pairs of points.
+ *  The diagonal elements of the boundary integral operators are not included, the integrator
+ *  parameter distinguishes e.g. numerical integrations of the diagonal to different tolerances.
+ */
+std::string GreensFunctionFingerprint(const IGreensFunction & gf);
+
+/*! \brief Returns the name of the cache file for a given fingerprint
+ *  \param[in] directory the cache directory
+ *  \param[in] fingerprint the fingerprint of the PCM matrix
+ */
+std::string PCMMatrixCacheFile(const std::string & directory, const std::string & fingerprint);
+
+/*! \brief Loads the blocks of the PCM matrix from the cache
+ *  \param[in] fname name of the cache file
+ *  \param[in] fingerprint the fingerprint of the PCM matrix
+ *  \param[in] nrBlocks the number of irreducible representations
+ *  \param[in] dimBlock the size of the irreducible portion of the cavity
+ *  \param[out] blocks the blocks of the PCM matrix
+ *  \return whether the blocks were found in the cache
+ *
+ *  A file that does not exist, with a different fingerprint or with blocks
+ *  of the wrong dimension is a cache miss.
+ */
+bool loadPCMMatrix(const std::string & fname, const std::string & fingerprint, int nrBlocks, int dimBlock,
+        std::vector<Eigen::MatrixXd> & blocks);
+
+/*! \brief Loads the spectral representation of the isotropic IEFPCM matrix from the cache
+ *  \param[in] fname name of the cache file
+ *  \param[in] fingerprint the fingerprint of the PCM matrix
+ *  \param[in] nrBlocks the number of irreducible representations
+ *  \param[in] dimBlock the size of the irreducible portion of the cavity
+ *  \param[out] left the \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ matrices
+ *  \param[out] right the \f$ \mathbf{V}^{-1} \f$ matrices
+ *  \param[out] eigenvalues the eigenvalues of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$
+ *  \return whether the spectral representation was found in the cache
+ *
+ *  A cache file saved without the spectral representation is a cache miss.
+ */
+bool loadPCMSpectra(const std::string & fname, const std::string & fingerprint, int nrBlocks, int dimBlock,
+        std::vector<Eigen::MatrixXcd> & left, std::vector<Eigen::MatrixXcd> & right,
+        std::vector<Eigen::VectorXcd> & eigenvalues);
+
+/*! \brief Saves the blocks of the PCM matrix to the cache
+ *  \param[in] fname name of the cache file
+ *  \param[in] fingerprint the fingerprint of the PCM matrix
+ *  \param[in] blocks the blocks of the PCM matrix
+ *  \param[in] left the \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ matrices, none when empty
+ *  \param[in] right the \f$ \mathbf{V}^{-1} \f$ matrices, none when empty
+ *  \param[in] eigenvalues the eigenvalues of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$, none when empty
+ *
+ *  The spectral representation of the isotropic IEFPCM matrix is saved along with the blocks,
+ *  its eigendecomposition is not computed again on a cache hit.
+ *  The file is first written under a temporary name and then renamed,
+ *  so that concurrent calculations never read an incomplete file.
+ */
+void savePCMMatrix(const std::string & fname, const std::string & fingerprint,
+        const std::vector<Eigen::MatrixXd> & blocks,
+        const std::vector<Eigen::MatrixXcd> & left = std::vector<Eigen::MatrixXcd>(),
+        const std::vector<Eigen::MatrixXcd> & right = std::vector<Eigen::MatrixXcd>(),
+        const std::vector<Eigen::VectorXcd> & eigenvalues = std::vector<Eigen::VectorXcd>());
+
+#endif // MATRIXCACHE_HPP
@@ -0,0 +1,200 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "OperatorCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "Cavity.hpp"
+#include "Element.hpp"
+#include "IGreensFunction.hpp"
+#include "MatrixCache.hpp"
+#include "SolverImpl.hpp"
+
+namespace
+{
+    typedef std::pair<long long, std::pair<long long, long long> > PointKey;
+
+    /*! \brief Key of a point, rounded to 1.0e-8 au, for the lookup of finite elements */
+    PointKey pointKey(const Eigen::Vector3d & point)
+    {
+        return std::make_pair(static_cast<long long>(std::floor(point(0) * 1.0e+08 + 0.5)),
+                std::make_pair(static_cast<long long>(std::floor(point(1) * 1.0e+08 + 0.5)),
+                    static_cast<long long>(std::floor(point(2) * 1.0e+08 + 0.5))));
+    }
+
+    bool same(double a, double b)
+    {
+        return (std::abs(a - b) <= 1.0e-12 * std::max(std::abs(a), std::abs(b)));
+    }
+
+    /*! \brief Diagonal element of an operator for a finite element alone
+     *  \param[in] gf the Green's function
+     *  \param[in] e the finite element
+     *  \param[in] single whether the S or the D operator is requested
+     */
+    double diagonal(const IGreensFunction & gf, const Element & e, bool single)
+    {
+        std::vector<Element> alone(1, e);
+        return (single ? gf.singleLayer(alone)(0, 0) : gf.doubleLayer(alone)(0, 0));
+    }
+}
+
+const std::vector<Eigen::MatrixXd> & OperatorCache::singleLayerBlocks(const Cavity & cav, const IGreensFunction & gf)
+{
+    return lookup(singleLayer_, cav, gf, true);
+}
+
+const std::vector<Eigen::MatrixXd> & OperatorCache::doubleLayerBlocks(const Cavity & cav, const IGreensFunction & gf)
+{
+    return lookup(doubleLayer_, cav, gf, false);
+}
+
+const std::vector<Eigen::MatrixXd> & OperatorCache::lookup(OperatorMap & cache, const Cavity & cav,
+        const IGreensFunction & gf, bool single)
+{
+    std::string fingerprint = BoundaryOperatorsFingerprint(cav, gf);
+    OperatorMap::iterator found = cache.find(fingerprint);
+    if (found != cache.end()) {
+        ++hits_;
+        return found->second.blocks;
+    }
+    Operator entry;
+    if (incremental_) {
+        entry.greensFunction = GreensFunctionFingerprint(gf);
+        entry.centers = cav.elementCenter();
+        entry.normals = cav.elementNormal();
+        entry.areas = cav.elementArea();
+        entry.radii = cav.elementRadius();
+        OperatorMap::iterator previous = cache.begin();
+        while (previous != cache.end() && previous->second.greensFunction != entry.greensFunction) ++previous;
+        if (previous != cache.end()) {
+            if (cav.pointGroup().nrIrrep() == 1 && previous->second.blocks.size() == 1) {
+                Eigen::MatrixXd updated;
+                if (updateOperator(previous->second, cav, gf, single, updated)) {
+                    entry.blocks.push_back(Eigen::MatrixXd());
+                    entry.blocks[0].swap(updated);
+                    ++updates_;
+                }
+            }
+            // Only the latest operator for a Green's function is kept
+            cache.erase(previous);
+        }
+    }
+    if (entry.blocks.empty()) {
+        ++misses_;
+        entry.blocks = single ? ::singleLayerBlocks(cav, gf) : ::doubleLayerBlocks(cav, gf);
+    }
+    Operator & stored = cache[fingerprint];
+    stored.greensFunction.swap(entry.greensFunction);
+    stored.centers.swap(entry.centers);
+    stored.normals.swap(entry.normals);
+    stored.areas.swap(entry.areas);
+    stored.radii.swap(entry.radii);
+    stored.blocks.swap(entry.blocks);
+    return stored.blocks;
+}
+
+bool OperatorCache::updateOperator(const Operator & previous, const Cavity & cav,
+        const IGreensFunction & gf, bool single, Eigen::MatrixXd & M)
+{
+    size_t cavitySize = cav.size();
+    const Eigen::MatrixXd & cached = previous.blocks[0];
+    std::map<PointKey, size_t> lookupTable;
+    for (int j = 0; j < previous.centers.cols(); ++j) lookupTable[pointKey(previous.centers.col(j))] = j;
+    // Index of each finite element in the previous cavity, -1 if it changed
+    std::vector<long> index(cavitySize, -1);
+    std::vector<size_t> changed, unchanged;
+    for (size_t i = 0; i < cavitySize; ++i) {
+        std::map<PointKey, size_t>::const_iterator match = lookupTable.find(pointKey(cav.elementCenter(i)));
+        if (match != lookupTable.end()) {
+            size_t j = match->second;
+            if ((cav.elementNormal(i) - previous.normals.col(j)).norm() <= 1.0e-12 * previous.normals.col(j).norm()
+                    && same(cav.elementArea(i), previous.areas(j)) && same(cav.elementRadius(i), previous.radii(j))) {
+                index[i] = j;
+                unchanged.push_back(i);
+                continue;
+            }
+        }
+        changed.push_back(i);
+    }
+    if (unchanged.empty() || 2 * changed.size() > cavitySize) return false;
+    // The diagonal elements of the unchanged finite elements are copied, which
+    // is only correct when they do not depend on the other finite elements.
+    // This also checks that the integrators are the same.
+    size_t sample = unchanged[unchanged.size() / 2];
+    if (!same(diagonal(gf, cav.elements()[sample], single), cached(index[sample], index[sample]))) return false;
+
+    M.resize(cavitySize, cavitySize);
+    for (size_t j = 0; j < unchanged.size(); ++j) {
+        for (size_t i = 0; i < unchanged.size(); ++i) {
+            M(unchanged[i], unchanged[j]) = cached(index[unchanged[i]], index[unchanged[j]]);
+        }
+    }
+    if (changed.empty()) return true;
+    // Rows of the changed finite elements, listed first
+    std::vector<Element> elements;
+    elements.reserve(cavitySize);
+    for (size_t k = 0; k < changed.size(); ++k) elements.push_back(cav.elements()[changed[k]]);
+    for (size_t k = 0; k < unchanged.size(); ++k) elements.push_back(cav.elements()[unchanged[k]]);
+    Eigen::MatrixXd rows = single ? gf.singleLayer(elements, changed.size()) : gf.doubleLayer(elements, changed.size());
+    for (size_t k = 0; k < changed.size(); ++k) {
+        for (size_t l = 0; l < changed.size(); ++l) M(changed[k], changed[l]) = rows(k, l);
+        for (size_t l = 0; l < unchanged.size(); ++l) M(changed[k], unchanged[l]) = rows(k, changed.size() + l);
+    }
+    // Columns of the changed finite elements in the unchanged rows, off-diagonal only
+    ParallelError error;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (size_t k = 0; k < unchanged.size(); ++k) {
+        try {
+            Eigen::Vector3d source = cav.elementCenter(unchanged[k]);
+            for (size_t l = 0; l < changed.size(); ++l) {
+                Eigen::Vector3d probe = cav.elementCenter(changed[l]);
+                if (single) {
+                    M(unchanged[k], changed[l]) = gf.kernelS(source, probe);
+                } else {
+                    Eigen::Vector3d probeNormal = cav.elementNormal(changed[l]);
+                    probeNormal.normalize();
+                    M(unchanged[k], changed[l]) = gf.kernelD(probeNormal, source, probe);
+                }
+            }
+        } catch (const std::exception & e) {
+            error.record(e);
+        }
+    }
+    error.raise();
+    return true;
+}
@@ -0,0 +1,141 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef OPERATORCACHE_HPP
+#define OPERATORCACHE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+class Cavity;
+class IGreensFunction;
+
+/*! \file OperatorCache.hpp
+ *  \class OperatorCache
+ *  \brief In-memory cache of the symmetry blocked boundary integral operators
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  The diagonal blocks of the S and D operators are stored, keyed by the fingerprint
+ *  of the cavity and of the Green's function they were computed for.
+ *  Solvers built on the same cavity with the same Green's function inside it,
+ *  e.g. the static and dynamic solvers in a nonequilibrium calculation,
+ *  compute the inside operators only once.
+ *
+ *  In incremental mode, the operators of a cavity not found in the cache are obtained
+ *  by updating those of the cached cavity with the same Green's function, e.g. the
+ *  cavity of the previous step of a geometry optimization.
+ *  The finite elements of the new cavity are matched to the cached ones by their
+ *  center, normal, area and radius: tesserae on spheres that did not move, nor
+ *  intersect a sphere that moved, are unchanged.
+ *  The matrix elements among unchanged finite elements are copied, only the rows
+ *  and columns of the changed ones are computed.
+ *  The update is done for cavities without symmetry and when the diagonal elements
+ *  of the operators only depend on the finite element they refer to.
+ *  Otherwise, or when more than half of the finite elements changed, the operators
+ *  are computed anew. Only the latest operators for each Green's function are kept.
+ */
+
+class OperatorCache
+{
+public:
+    /*! \brief Constructs an empty cache
+     *  \param[in] incremental whether operators are updated from those of another cavity
+     */
+    explicit OperatorCache(bool incremental = false)
+        : incremental_(incremental), hits_(0), misses_(0), updates_(0) {}
+    /*! \brief Returns the diagonal blocks of the symmetry blocked S operator
+     *  \param[in] cav the discretized cavity
+     *  \param[in] gf  the Green's function
+     *
+     *  The blocks are computed on a cache miss.
+     */
+    const std::vector<Eigen::MatrixXd> & singleLayerBlocks(const Cavity & cav, const IGreensFunction & gf);
+    /*! \brief Returns the diagonal blocks of the symmetry blocked D operator
+     *  \param[in] cav the discretized cavity
+     *  \param[in] gf  the Green's function
+     *
+     *  The blocks are computed on a cache miss.
+     */
+    const std::vector<Eigen::MatrixXd> & doubleLayerBlocks(const Cavity & cav, const IGreensFunction & gf);
+    /*! Number of operators found in the cache */
+    int hits() const { return hits_; }
+    /*! Number of operators computed */
+    int misses() const { return misses_; }
+    /*! Number of operators updated from those of another cavity */
+    int updates() const { return updates_; }
+    /*! Releases all the operators */
+    void clear() { singleLayer_.clear(); doubleLayer_.clear(); }
+private:
+    struct Operator {
+        /*! Fingerprint of the Green's function, independent of the cavity */
+        std::string greensFunction;
+        /*! Finite elements centers */
+        Eigen::Matrix3Xd centers;
+        /*! Finite elements normals */
+        Eigen::Matrix3Xd normals;
+        /*! Finite elements areas */
+        Eigen::VectorXd areas;
+        /*! Finite elements radii */
+        Eigen::VectorXd radii;
+        /*! Diagonal blocks of the operator */
+        std::vector<Eigen::MatrixXd> blocks;
+    };
+    typedef std::map<std::string, Operator> OperatorMap;
+    /*! Whether operators are updated from those of another cavity */
+    bool incremental_;
+    /*! S operators, keyed by fingerprint */
+    OperatorMap singleLayer_;
+    /*! D operators, keyed by fingerprint */
+    OperatorMap doubleLayer_;
+    int hits_;
+    int misses_;
+    int updates_;
+    /*! \brief Returns the diagonal blocks of an operator, computed or updated on a cache miss
+     *  \param[in] cache the cached operators of the same kind
+     *  \param[in] cav the discretized cavity
+     *  \param[in] gf  the Green's function
+     *  \param[in] single whether the S or the D operator is requested
+     */
+    const std::vector<Eigen::MatrixXd> & lookup(OperatorMap & cache, const Cavity & cav,
+            const IGreensFunction & gf, bool single);
+    /*! \brief Updates a cached operator for a new cavity
+     *  \param[in] previous the cached operator
+     *  \param[in] cav the new discretized cavity
+     *  \param[in] gf  the Green's function
+     *  \param[in] single whether the S or the D operator is requested
+     *  \param[out] M the operator for the new cavity
+     *  \return whether the update was done
+     */
+    static bool updateOperator(const Operator & previous, const Cavity & cav,
+            const IGreensFunction & gf, bool single, Eigen::MatrixXd & M);
+};
+
+#endif // OPERATORCACHE_HPP
@@ -32,6 +32,7 @@
 
 class Cavity;
 class IGreensFunction;
+class OperatorCache;
 
 /*! \file PCMSolver.hpp
  *  \class PCMSolver
@@ -45,7 +46,7 @@ class IGreensFunction;
 class PCMSolver
 {
 public:
-    PCMSolver() : built_(false), isotropic_(true) {}
+    PCMSolver() : built_(false), isotropic_(true), operators_(NULL) {}
     virtual ~PCMSolver() {}
 
     /*! \brief Calculation of the PCM matrix
@@ -56,6 +57,32 @@ public:
     void buildSystemMatrix(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o) {
         buildSystemMatrix_impl(cavity, gf_i, gf_o);
     }
+    /*! \brief Calculation of the PCM matrix, sharing the boundary integral operators
+     *  \param[in] cavity the cavity to be used
+     *  \param[in] gf_i Green's function inside the cavity
+     *  \param[in] gf_o Green's function outside the cavity
+     *  \param[in,out] operators cache of the operators of the Green's function inside the cavity
+     *
+     *  The operators are looked up in, or added to, the cache.
+     *  Solvers that do not form the operators ignore it.
+     */
+    void buildSystemMatrix(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o,
+            OperatorCache & operators) {
+        operators_ = &operators;
+        buildSystemMatrix_impl(cavity, gf_i, gf_o);
+        operators_ = NULL;
+    }
+    /*! \brief Updates the PCM matrix for a new permittivity outside the cavity
+     *  \param[in] epsilon the new permittivity outside the cavity
+     *
+     *  The matrix is updated without recomputing the boundary integral operators.
+     *  Only solvers for isotropic environments can be updated.
+     */
+    void updatePermittivity(double epsilon) {
+        if (!built_) PCMSOLVER_ERROR("PCM matrix not calculated yet");
+        if (!isotropic_) PCMSOLVER_ERROR("Permittivity can be updated only for isotropic environments!");
+        updatePermittivity_impl(epsilon);
+    }
     /*! \brief Returns the ASC given the MEP and the desired irreducible representation
      *  \param[in] potential the vector containing the MEP at cavity points
      *  \param[in] irrep the irreducible representation of the MEP and ASC
@@ -64,6 +91,27 @@ public:
         if (!built_) PCMSOLVER_ERROR("PCM matrix not calculated yet");
         return computeCharge_impl(potential, irrep);
     }
+    /*! \brief Computes the ASC given the MEP and the desired irreducible representation
+     *  \param[in] potential the vector containing the MEP at cavity points
+     *  \param[out] charge the vector where the ASC at cavity points is written
+     *  \param[in] irrep the irreducible representation of the MEP and ASC
+     *
+     *  The ASC is written directly into the memory referenced by charge,
+     *  for example a buffer owned by the host program wrapped in an Eigen::Map
+     */
+    void computeChargeInto(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+            int irrep = 0) const {
+        if (!built_) PCMSOLVER_ERROR("PCM matrix not calculated yet");
+        computeChargeInto_impl(potential, charge, irrep);
+    }
+    /*! \brief Returns the ASCs given a batch of MEPs and the desired irreducible representation
+     *  \param[in] potentials the matrix containing the MEPs at cavity points, one per column
+     *  \param[in] irrep the irreducible representation of the MEPs and ASCs
+     */
+    Eigen::MatrixXd computeCharges(const Eigen::MatrixXd & potentials, int irrep = 0) const {
+        if (!built_) PCMSOLVER_ERROR("PCM matrix not calculated yet");
+        return computeCharges_impl(potentials, irrep);
+    }
 
     friend std::ostream & operator<<(std::ostream & os, PCMSolver & solver) {
         return solver.printSolver(os);
@@ -73,6 +121,8 @@ protected:
     bool built_;
     /*! Whether the solver is isotropic */
     bool isotropic_;
+    /*! Cache of the operators inside the cavity, not owned and only set while building the PCM matrix */
+    OperatorCache * operators_;
 
     /*! \brief Calculation of the PCM matrix
      *  \param[in] cavity the cavity to be used
@@ -80,11 +130,41 @@ protected:
      *  \param[in] gf_o Green's function outside the cavity
      */
     virtual void buildSystemMatrix_impl(const Cavity & cavity, const IGreensFunction & gf_i, const IGreensFunction & gf_o) = 0;
+    /*! \brief Updates the PCM matrix for a new permittivity outside the cavity
+     *  \param[in] epsilon the new permittivity outside the cavity
+     */
+    virtual void updatePermittivity_impl(double epsilon) = 0;
     /*! \brief Returns the ASC given the MEP and the desired irreducible representation
      *  \param[in] potential the vector containing the MEP at cavity points
      *  \param[in] irrep the irreducible representation of the MEP and ASC
      */
     virtual Eigen::VectorXd computeCharge_impl(const Eigen::VectorXd & potential, int irrep = 0) const = 0;
+    /*! \brief Computes the ASC given the MEP and the desired irreducible representation
+     *  \param[in] potential the vector containing the MEP at cavity points
+     *  \param[out] charge the vector where the ASC at cavity points is written
+     *  \param[in] irrep the irreducible representation of the MEP and ASC
+     *
+     *  Solvers holding the PCM matrix override this to avoid any temporary.
+     *  By default, the ASC returned by computeCharge_impl is copied into charge.
+     */
+    virtual void computeChargeInto_impl(const Eigen::Ref<const Eigen::VectorXd> & potential, Eigen::Ref<Eigen::VectorXd> charge,
+            int irrep = 0) const {
+        charge = computeCharge_impl(potential, irrep);
+    }
+    /*! \brief Returns the ASCs given a batch of MEPs and the desired irreducible representation
+     *  \param[in] potentials the matrix containing the MEPs at cavity points, one per column
+     *  \param[in] irrep the irreducible representation of the MEPs and ASCs
+     *
+     *  Solvers holding the PCM matrix override this to act on all the MEPs at once.
+     *  By default, the ASCs are computed one column at a time.
+     */
+    virtual Eigen::MatrixXd computeCharges_impl(const Eigen::MatrixXd & potentials, int irrep = 0) const {
+        Eigen::MatrixXd charges(potentials.rows(), potentials.cols());
+        for (int i = 0; i < potentials.cols(); ++i) {
+            charges.col(i) = computeCharge_impl(potentials.col(i), irrep);
+        }
+        return charges;
+    }
     virtual std::ostream & printSolver(std::ostream & os) = 0;
 };
 
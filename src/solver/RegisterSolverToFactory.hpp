@@ -32,6 +32,7 @@
 #include "Factory.hpp"
 #include "CPCMSolver.hpp"
 #include "IEFSolver.hpp"
+#include "IterativeSolver.hpp"
 
 /*! \file RegisterSolverToFactory.hpp
  *  \brief Register each solver to the factory.
@@ -48,7 +49,7 @@ namespace
 {
     PCMSolver * createCPCMSolver(const solverData & data)
     {
-        return new CPCMSolver(data.hermitivitize, data.correction);
+        return new CPCMSolver(data.hermitivitize, data.correction, data.matrixCache);
     }
     const std::string CPCMSOLVER("CPCM");
     const bool registeredCPCMSolver =
@@ -59,11 +60,33 @@ namespace
 {
     PCMSolver * createIEFSolver(const solverData & data)
     {
-        return new IEFSolver(data.hermitivitize);
+        return new IEFSolver(data.hermitivitize, data.matrixCache, data.permittivityUpdate);
     }
     const std::string IEFSOLVER("IEFPCM");
     const bool registeredIEFSolver =
         Factory<PCMSolver, solverData>::TheFactory().registerObject(IEFSOLVER, createIEFSolver);
 }
 
+namespace
+{
+    PCMSolver * createIterativeCPCMSolver(const solverData & data)
+    {
+        return new IterativeSolver(true, data.correction, data.threshold, data.maxIterations, data.openingAngle, data.compression);
+    }
+    const std::string ITERATIVECPCMSOLVER("ITERATIVECPCM");
+    const bool registeredIterativeCPCMSolver =
+        Factory<PCMSolver, solverData>::TheFactory().registerObject(ITERATIVECPCMSOLVER, createIterativeCPCMSolver);
+}
+
+namespace
+{
+    PCMSolver * createIterativeIEFSolver(const solverData & data)
+    {
+        return new IterativeSolver(false, data.correction, data.threshold, data.maxIterations, data.openingAngle, data.compression);
+    }
+    const std::string ITERATIVEIEFSOLVER("ITERATIVEIEFPCM");
+    const bool registeredIterativeIEFSolver =
+        Factory<PCMSolver, solverData>::TheFactory().registerObject(ITERATIVEIEFSOLVER, createIterativeIEFSolver);
+}
+
 #endif // REGISTERSOLVERTOFACTORY_HPP
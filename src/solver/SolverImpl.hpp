@@ -24,16 +24,21 @@
 /* pcmsolver_copyright_end */
 
 #include <cmath>
+#include <complex>
+#include <vector>
 
 #include "Config.hpp"
 
 #include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
 #include <Eigen/LU>
 
 #include "Cavity.hpp"
 #include "Element.hpp"
 #include "IGreensFunction.hpp"
 #include "MathUtils.hpp"
+#include "OperatorCache.hpp"
 
 /*! \file SolverImpl.cpp
  *  \brief Functions common to all solvers
@@ -41,6 +46,308 @@
  *  \date 2015
  */
 
+/*! \brief Solves \f$ \mathbf{S}\mathbf{X} = \mathbf{B} \f$ for the single layer operator
+ *  \param[in] S matrix representation of the single layer operator
+ *  \param[in] B right-hand sides
+ *  \return \f$ \mathbf{X} = \mathbf{S}^{-1}\mathbf{B} \f$
+ *
+ *  When S is symmetric a Cholesky decomposition is attempted first,
+ *  the single layer operator being positive definite for the uniform Green's functions.
+ *  We fall back to LU decomposition with partial pivoting otherwise.
+ *  The inverse is never formed explicitly.
+ */
+inline Eigen::MatrixXd singleLayerSolve(const Eigen::MatrixXd & S, const Eigen::MatrixXd & B)
+{
+  if (S.isApprox(S.transpose())) {
+    Eigen::LLT<Eigen::MatrixXd> S_LLT(S);
+    if (S_LLT.info() == Eigen::Success) return S_LLT.solve(B);
+  }
+  Eigen::PartialPivLU<Eigen::MatrixXd> S_LU(S);
+  if (!isInvertible(S_LU)) PCMSOLVER_ERROR("SI matrix is not invertible!");
+  return S_LU.solve(B);
+}
+
+/*! \brief Solves \f$ \mathbf{S}\mathbf{X} = \mathbf{B} \f$ for the single layer operator, in place
+ *  \param[in,out] S matrix representation of the single layer operator, released on exit
+ *  \param[in,out] B right-hand sides, overwritten with the solution
+ *
+ *  As singleLayerSolve, but S is released as soon as it has been factorized
+ *  and the triangular solves overwrite B. No other matrix of the size of B is allocated
+ *  in double precision.
+ */
+inline void singleLayerSolveInPlace(Eigen::MatrixXd & S, Eigen::MatrixXd & B)
+{
+  if (S.isApprox(S.transpose())) {
+    Eigen::LLT<Eigen::MatrixXd> S_LLT(S);
+    if (S_LLT.info() == Eigen::Success) {
+      S.resize(0, 0);
+      S_LLT.solveInPlace(B);
+      return;
+    }
+  }
+  Eigen::PartialPivLU<Eigen::MatrixXd> S_LU(S);
+  if (!isInvertible(S_LU)) PCMSOLVER_ERROR("SI matrix is not invertible!");
+  S.resize(0, 0);
+  // The row permutation is applied in place, followed by the triangular solves
+  B = S_LU.permutationP() * B;
+  S_LU.matrixLU().template triangularView<Eigen::UnitLower>().solveInPlace(B);
+  S_LU.matrixLU().template triangularView<Eigen::Upper>().solveInPlace(B);
+}
+
+/*! \brief Solves \f$ \mathbf{T}\mathbf{X} = \mathbf{B} \f$ for the PCM system matrix
+ *  \param[in] T the system matrix
+ *  \param[in] B right-hand sides
+ *  \return \f$ \mathbf{X} = \mathbf{T}^{-1}\mathbf{B} \f$
+ *
+ *  Uses LU decomposition with partial pivoting and triangular solves
+ *  against all the right-hand sides at once.
+ *  The inverse is never formed explicitly.
+ */
+inline Eigen::MatrixXd systemSolve(const Eigen::MatrixXd & T, const Eigen::MatrixXd & B)
+{
+  Eigen::PartialPivLU<Eigen::MatrixXd> T_LU(T);
+  if (!isInvertible(T_LU)) PCMSOLVER_ERROR("T matrix is not invertible!");
+  return T_LU.solve(B);
+}
+
+/*! \brief Builds the symmetry blocked matrix representation of the S operator
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf  the Green's function
+ *
+ *  Only the rows relative to the irreducible finite elements are calculated,
+ *  the diagonal blocks are then assembled using the characters of the point group.
+ *  If the group is C1 the full matrix is calculated.
+ */
+inline Eigen::MatrixXd singleLayerBlocked(const Cavity & cav, const IGreensFunction & gf)
+{
+  if (cav.pointGroup().nrGenerators() == 0) return gf.singleLayer(cav.elements());
+  return symmetryBlockingFromRows(gf.singleLayer(cav.elements(), cav.irreducible_size()),
+      cav.irreducible_size(), cav.pointGroup().nrIrrep());
+}
+
+/*! \brief Builds the symmetry blocked matrix representation of the D operator
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf  the Green's function
+ *
+ *  Only the rows relative to the irreducible finite elements are calculated,
+ *  the diagonal blocks are then assembled using the characters of the point group.
+ *  If the group is C1 the full matrix is calculated.
+ */
+inline Eigen::MatrixXd doubleLayerBlocked(const Cavity & cav, const IGreensFunction & gf)
+{
+  if (cav.pointGroup().nrGenerators() == 0) return gf.doubleLayer(cav.elements());
+  return symmetryBlockingFromRows(gf.doubleLayer(cav.elements(), cav.irreducible_size()),
+      cav.irreducible_size(), cav.pointGroup().nrIrrep());
+}
+
+/*! \brief Builds the diagonal blocks of the symmetry blocked S operator
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf  the Green's function
+ *
+ *  Only the rows relative to the irreducible finite elements are calculated.
+ *  If the group is C1 the only block is the full matrix.
+ */
+inline std::vector<Eigen::MatrixXd> singleLayerBlocks(const Cavity & cav, const IGreensFunction & gf)
+{
+  std::vector<Eigen::MatrixXd> blocks;
+  if (cav.pointGroup().nrGenerators() == 0) {
+    blocks.push_back(gf.singleLayer(cav.elements()));
+  } else {
+    symmetryBlocksFromRows(blocks, gf.singleLayer(cav.elements(), cav.irreducible_size()),
+        cav.irreducible_size(), cav.pointGroup().nrIrrep());
+  }
+  return blocks;
+}
+
+/*! \brief Builds the diagonal blocks of the symmetry blocked D operator
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf  the Green's function
+ *
+ *  Only the rows relative to the irreducible finite elements are calculated.
+ *  If the group is C1 the only block is the full matrix.
+ */
+inline std::vector<Eigen::MatrixXd> doubleLayerBlocks(const Cavity & cav, const IGreensFunction & gf)
+{
+  std::vector<Eigen::MatrixXd> blocks;
+  if (cav.pointGroup().nrGenerators() == 0) {
+    blocks.push_back(gf.doubleLayer(cav.elements()));
+  } else {
+    symmetryBlocksFromRows(blocks, gf.doubleLayer(cav.elements(), cav.irreducible_size()),
+        cav.irreducible_size(), cav.pointGroup().nrIrrep());
+  }
+  return blocks;
+}
+
+/*! \brief Returns the ratio of the S operators outside and inside the cavity, when the kernels are proportional
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[in] gf_o Green's function outside the cavity
+ *  \return the ratio \f$ c \f$, zero when the operators are not proportional
+ *
+ *  When the kernels of the S operators differ by the factor c, as for a Vacuum and a UniformDielectric,
+ *  the kernels of the D operators coincide and the off-diagonal elements satisfy
+ *  \f$ \mathbf{S}_\mathrm{e} = c\mathbf{S}_\mathrm{i} \f$ and \f$ \mathbf{D}_\mathrm{e} = \mathbf{D}_\mathrm{i} \f$.
+ *  The diagonal elements also depend on the integrators: these are compared on the
+ *  irreducible finite elements only, the others being their images.
+ */
+inline double outsideOperatorsRatio(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
+{
+  double ratio = profiles::kernelRatio(gf_i.permittivity(), gf_o.permittivity());
+  if (ratio == 0.0) return 0.0;
+  double tolerance = 1.0e-12;
+  for (size_t i = 0; i < cav.irreducible_size(); ++i) {
+    std::vector<Element> single(1, cav.elements()[i]);
+    double SI = gf_i.singleLayer(single)(0, 0), SE = gf_o.singleLayer(single)(0, 0);
+    double DI = gf_i.doubleLayer(single)(0, 0), DE = gf_o.doubleLayer(single)(0, 0);
+    if (std::abs(SE - ratio * SI) > tolerance * std::abs(SE)) return 0.0;
+    if (std::abs(DE - DI) > tolerance * std::abs(DE)) return 0.0;
+  }
+  return ratio;
+}
+
+/*! \brief Builds the **anisotropic** IEFPCM matrix from the operators
+ *  \param[in,out] SI single layer operator inside the cavity, released on exit
+ *  \param[in,out] DI double layer operator inside the cavity, released on exit
+ *  \param[in,out] SE single layer operator outside the cavity, released on exit
+ *  \param[in,out] DE double layer operator outside the cavity, released on exit
+ *  \param[in] areas the finite elements areas
+ *  \return the \f$ \mathbf{K} = \mathbf{T}^{-1}\mathbf{R}\mathbf{A} \f$ matrix
+ *
+ *  The operators are either the full matrices or one of their symmetry blocks.
+ *  They are updated in place and released as soon as they are consumed:
+ *  besides the operators, only T and the factorizations are allocated.
+ *  The diagonal matrix of the areas only ever scales rows and columns.
+ */
+inline Eigen::MatrixXd anisotropicIEFBlock(Eigen::MatrixXd & SI, Eigen::MatrixXd & DI,
+    Eigen::MatrixXd & SE, Eigen::MatrixXd & DE, const Eigen::VectorXd & areas)
+{
+  // T = (2 * M_PI - DE * a) * SI + SE * (2 * M_PI + (DI * a)^+)
+  // R * a = (2 * M_PI - DE * a) - SE * SI^-1 * (2 * M_PI - DI * a)
+  DI = DI * areas.asDiagonal();
+  DE = DE * areas.asDiagonal();
+  // 1. Form T
+  Eigen::MatrixXd T = 2 * M_PI * (SI + SE);
+  T.noalias() -= DE * SI;
+  T.noalias() += SE * DI.adjoint();
+  // 2. Form R * a in place of DE, the SI^-1 product is obtained by solving
+  //    against multiple right-hand sides in place of DI
+  DI = -DI;
+  DI.diagonal().array() += 2 * M_PI;
+  singleLayerSolveInPlace(SI, DI);
+  DE = -DE;
+  DE.diagonal().array() += 2 * M_PI;
+  DE.noalias() -= SE * DI;
+  SE.resize(0, 0);
+  DI.resize(0, 0);
+  // 3. Solve T * K = R * a
+  Eigen::MatrixXd K = systemSolve(T, DE);
+  DE.resize(0, 0);
+  return K;
+}
+
+/*! \brief Builds the **isotropic** IEFPCM matrix from the operators
+ *  \param[in] SI single layer operator inside the cavity
+ *  \param[in] DI double layer operator inside the cavity
+ *  \param[in] areas the finite elements areas
+ *  \param[in] epsilon permittivity outside the cavity
+ *  \return the \f$ \mathbf{K} = \mathbf{T}^{-1}\mathbf{R}\mathbf{A} \f$ matrix
+ *
+ *  The operators are either the full matrices or one of their symmetry blocks.
+ */
+inline Eigen::MatrixXd isotropicIEFBlock(const Eigen::MatrixXd & SI, const Eigen::MatrixXd & DI,
+    const Eigen::VectorXd & areas, double epsilon)
+{
+  // Tq = -Rv -> q = -(T^-1 * R)v = -Kv
+  // T = (2 * M_PI * fact * aInv - DI) * a * SI; R = (2 * M_PI * aInv - DI)
+  // K = T^-1 * R * a
+  // 1. Form R * a = 2 * M_PI - DI * a
+  Eigen::MatrixXd Ra = - DI * areas.asDiagonal();
+  Ra.diagonal().array() += 2 * M_PI;
+  // 2. Form T = 2 * M_PI * (fact - 1) * SI + R * a * SI
+  double fact = (epsilon + 1.0)/(epsilon - 1.0);
+  Eigen::MatrixXd T = 2 * M_PI * (fact - 1.0) * SI;
+  T.noalias() += Ra * SI;
+  // 3. Solve T * K = R * a by LU decomposition and triangular solves,
+  //    T^-1 is never formed explicitly
+  return systemSolve(T, Ra);
+}
+
+/*! \brief Builds the spectral representation of the **isotropic** IEFPCM matrix from the operators
+ *  \param[in] SI single layer operator inside the cavity
+ *  \param[in] DI double layer operator inside the cavity
+ *  \param[in] areas the finite elements areas
+ *  \param[out] left the \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ matrix
+ *  \param[out] right the \f$ \mathbf{V}^{-1} \f$ matrix
+ *  \param[out] eigenvalues the eigenvalues \f$ \lambda_k \f$ of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$
+ *
+ *  Given the eigendecomposition \f$ \mathbf{D}_\mathrm{i}\mathbf{A} = \mathbf{V}\Lambda\mathbf{V}^{-1} \f$,
+ *  the PCM matrix depends on the permittivity only through a diagonal matrix:
+ *  \f[
+ *      \mathbf{K}(\varepsilon) = \mathbf{S}_\mathrm{i}^{-1}\mathbf{V}\mathbf{G}(\varepsilon)\mathbf{V}^{-1}, \quad
+ *      G_{kk}(\varepsilon) = \frac{2\pi - \lambda_k}{2\pi\frac{\varepsilon+1}{\varepsilon-1} - \lambda_k}
+ *  \f]
+ *  \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$ is not symmetric, its eigenpairs are in general complex.
+ *  The operators are either the full matrices or one of their symmetry blocks.
+ */
+inline void isotropicIEFSpectrum(const Eigen::MatrixXd & SI, const Eigen::MatrixXd & DI, const Eigen::VectorXd & areas,
+    Eigen::MatrixXcd & left, Eigen::MatrixXcd & right, Eigen::VectorXcd & eigenvalues)
+{
+  Eigen::EigenSolver<Eigen::MatrixXd> DA(DI * areas.asDiagonal());
+  if (DA.info() != Eigen::Success) PCMSOLVER_ERROR("Eigendecomposition of the DI operator failed!");
+  eigenvalues = DA.eigenvalues();
+  Eigen::MatrixXcd V = DA.eigenvectors();
+  right = Eigen::PartialPivLU<Eigen::MatrixXcd>(V).inverse();
+  // SI is real: the real and imaginary parts of the eigenvectors are solved for at once
+  int dim = V.rows();
+  Eigen::MatrixXd parts(dim, 2 * dim);
+  parts << V.real(), V.imag();
+  parts = singleLayerSolve(SI, parts);
+  left.resize(dim, dim);
+  left.real() = parts.leftCols(dim);
+  left.imag() = parts.rightCols(dim);
+}
+
+/*! \brief Returns the diagonal of \f$ \mathbf{G}(\varepsilon) \f$ in the spectral representation of the IEFPCM matrix
+ *  \param[in] eigenvalues the eigenvalues of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$
+ *  \param[in] epsilon permittivity outside the cavity
+ */
+inline Eigen::VectorXcd isotropicIEFWeights(const Eigen::VectorXcd & eigenvalues, double epsilon)
+{
+  double fact = (epsilon + 1.0)/(epsilon - 1.0);
+  Eigen::ArrayXcd lambda = eigenvalues.array();
+  return ((-lambda + std::complex<double>(2 * M_PI)) / (-lambda + std::complex<double>(2 * M_PI * fact))).matrix();
+}
+
+/*! \brief Forms the IEFPCM matrix from its spectral representation
+ *  \param[in] left the \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ matrix
+ *  \param[in] right the \f$ \mathbf{V}^{-1} \f$ matrix
+ *  \param[in] weights the diagonal of \f$ \mathbf{G}(\varepsilon) \f$
+ *  \return the \f$ \mathbf{K}(\varepsilon) \f$ matrix, real up to rounding
+ *
+ *  The eigenpairs of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$ come in complex conjugate
+ *  pairs, the imaginary part of the product vanishes.
+ */
+inline Eigen::MatrixXd isotropicIEFSpectralBlock(const Eigen::MatrixXcd & left, const Eigen::MatrixXcd & right,
+    const Eigen::VectorXcd & weights)
+{
+  return (left * weights.asDiagonal() * right).real();
+}
+
+/*! \brief Builds the CPCM matrix from the single layer operator
+ *  \param[in] SI single layer operator inside the cavity
+ *  \param[in] epsilon permittivity outside the cavity
+ *  \param[in] correction CPCM correction factor
+ *  \return the \f$ \mathbf{K} = f(\varepsilon)\mathbf{S}^{-1} \f$ matrix
+ *
+ *  The operator is either the full matrix or one of its symmetry blocks.
+ */
+inline Eigen::MatrixXd CPCMBlock(const Eigen::MatrixXd & SI, double epsilon, double correction)
+{
+  double fact = (epsilon - 1.0)/(epsilon + correction);
+  // Invert SI by solving against the identity, using Cholesky decomposition when possible
+  return fact * singleLayerSolve(SI, Eigen::MatrixXd::Identity(SI.rows(), SI.cols()));
+}
+
 /*! \brief Builds the **anisotropic** IEFPCM matrix
  *  \param[in] cav the discretized cavity
  *  \param[in] gf_i Green's function inside the cavity
@@ -60,49 +367,18 @@
  *     \end{align}
  *  \f]
  *  The matrix is not symmetrized and is not symmetry packed.
+ *  SE and DE are not assembled when the kernels are proportional, see outsideOperatorsRatio
  */
 inline Eigen::MatrixXd anisotropicIEFMatrix(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI, DI and SE, DE on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-  Eigen::MatrixXd SE = gf_o.singleLayer(cav.elements());
-  Eigen::MatrixXd DE = gf_o.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the fullPCMMatrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(DE, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SE, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = a.inverse();
-
-  // 1. Form T
-  Eigen::MatrixXd fullPCMMatrix = ((2 * M_PI * aInv - DE) * a * SI + SE * a * (2 * M_PI * aInv + DI.adjoint().eval()));
-  // 2. Invert T using LU decomposition with full pivoting
-  //    This is a rank-revealing LU decomposition, this allows us
-  //    to test if T is invertible before attempting to invert it.
-  Eigen::FullPivLU<Eigen::MatrixXd> T_LU(fullPCMMatrix);
-  if (!(T_LU.isInvertible())) PCMSOLVER_ERROR("T matrix is not invertible!");
-  fullPCMMatrix = T_LU.inverse();
-  Eigen::FullPivLU<Eigen::MatrixXd> SI_LU(SI);
-  if (!(SI_LU.isInvertible())) PCMSOLVER_ERROR("SI matrix is not invertible!");
-  fullPCMMatrix *= ((2 * M_PI * aInv - DE) - SE * SI_LU.inverse() * (2 * M_PI * aInv - DI));
-  fullPCMMatrix *= a;
-
-  return fullPCMMatrix;
+  // Compute the symmetry blocked SI, DI and SE, DE from the irreducible rows
+  // SE and DE are derived from SI and DI when the kernels are proportional
+  Eigen::MatrixXd SI = singleLayerBlocked(cav, gf_i);
+  Eigen::MatrixXd DI = doubleLayerBlocked(cav, gf_i);
+  double ratio = outsideOperatorsRatio(cav, gf_i, gf_o);
+  Eigen::MatrixXd SE = (ratio != 0.0) ? Eigen::MatrixXd(ratio * SI) : singleLayerBlocked(cav, gf_o);
+  Eigen::MatrixXd DE = (ratio != 0.0) ? DI : doubleLayerBlocked(cav, gf_o);
+  return anisotropicIEFBlock(SI, DI, SE, DE, cav.elementArea());
 }
 
 /*! \brief Builds the **isotropic** IEFPCM matrix
@@ -124,48 +400,8 @@ inline Eigen::MatrixXd anisotropicIEFMatrix(const Cavity & cav, const IGreensFun
  */
 inline Eigen::MatrixXd isotropicIEFMatrix(const Cavity & cav, const IGreensFunction & gf_i, double epsilon)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI and DI on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the fullPCMMatrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = Eigen::MatrixXd::Zero(cavitySize, cavitySize);
-  aInv = a.inverse();
-
-  // Tq = -Rv -> q = -(T^-1 * R)v = -Kv
-  // T = (2 * M_PI * fact * aInv - DI) * a * SI; R = (2 * M_PI * aInv - DI)
-  // fullPCMMatrix_ = K = T^-1 * R * a
-  // 1. Form T
-  double fact = (epsilon + 1.0)/(epsilon - 1.0);
-  Eigen::MatrixXd fullPCMMatrix = (2 * M_PI * fact * aInv - DI) * a * SI;
-  // 2. Invert T using LU decomposition with full pivoting
-  //    This is a rank-revealing LU decomposition, this allows us
-  //    to test if T is invertible before attempting to invert it.
-  Eigen::FullPivLU<Eigen::MatrixXd> T_LU(fullPCMMatrix);
-  if (!(T_LU.isInvertible()))
-    PCMSOLVER_ERROR("T matrix is not invertible!");
-  fullPCMMatrix = T_LU.inverse();
-  // 3. Multiply T^-1 and R
-  fullPCMMatrix *= (2 * M_PI * aInv - DI);
-  // 4. Multiply by a
-  fullPCMMatrix *= a;
-
-  return fullPCMMatrix;
+  // Compute the symmetry blocked SI and DI from the irreducible rows
+  return isotropicIEFBlock(singleLayerBlocked(cav, gf_i), doubleLayerBlocked(cav, gf_i), cav.elementArea(), epsilon);
 }
 
 /*! \brief Builds the CPCM matrix
@@ -180,31 +416,139 @@ inline Eigen::MatrixXd isotropicIEFMatrix(const Cavity & cav, const IGreensFunct
  */
 inline Eigen::MatrixXd CPCMMatrix(const Cavity & cav, const IGreensFunction & gf_i, double epsilon, double correction)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI and DI on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the fullPCMMatrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
+  // Compute the symmetry blocked SI from the irreducible rows
+  return CPCMBlock(singleLayerBlocked(cav, gf_i), epsilon, correction);
+}
+
+/*! \brief Builds the **anisotropic** IEFPCM matrix, one irreducible representation at a time
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[in] gf_o Green's function outside the cavity
+ *  \param[in,out] operators cache of the operators inside the cavity, none when NULL
+ *  \return the diagonal blocks of the symmetry blocked \f$ \mathbf{K} \f$ matrix
+ *
+ *  The blocks of T and R are formed and factorized independently,
+ *  the full PCM matrix is never formed.
+ *  The matrices are not symmetrized.
+ *  SE and DE are not assembled when the kernels are proportional, see outsideOperatorsRatio
+ */
+inline std::vector<Eigen::MatrixXd> anisotropicIEFBlocks(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o,
+    OperatorCache * operators = NULL)
+{
+  // The blocks are consumed while building K: the cached operators are copied
+  std::vector<Eigen::MatrixXd> SI = operators ? operators->singleLayerBlocks(cav, gf_i) : singleLayerBlocks(cav, gf_i);
+  std::vector<Eigen::MatrixXd> DI = operators ? operators->doubleLayerBlocks(cav, gf_i) : doubleLayerBlocks(cav, gf_i);
+  // SE and DE are derived from SI and DI, one block at a time, when the kernels are proportional
+  double ratio = outsideOperatorsRatio(cav, gf_i, gf_o);
+  std::vector<Eigen::MatrixXd> SE, DE;
+  if (ratio == 0.0) {
+    SE = singleLayerBlocks(cav, gf_o);
+    DE = doubleLayerBlocks(cav, gf_o);
   }
 
-  double fact = (epsilon - 1.0)/(epsilon + correction);
-  // Invert SI  using LU decomposition with full pivoting
-  // This is a rank-revealing LU decomposition, this allows us
-  // to test if SI is invertible before attempting to invert it.
-  Eigen::FullPivLU<Eigen::MatrixXd> SI_LU(SI);
-  if (!(SI_LU.isInvertible()))
-    PCMSOLVER_ERROR("SI matrix is not invertible!");
-  return fact * SI_LU.inverse();
+  int dimBlock = SI[0].rows();
+  std::vector<Eigen::MatrixXd> K(SI.size());
+  for (size_t i = 0; i < SI.size(); ++i) {
+    Eigen::MatrixXd SE_block, DE_block;
+    if (ratio != 0.0) {
+      SE_block = ratio * SI[i];
+      DE_block = DI[i];
+    } else {
+      SE_block.swap(SE[i]);
+      DE_block.swap(DE[i]);
+    }
+    // The finite elements in each block are images of the irreducible ones, with the same areas.
+    // The operator blocks are released as soon as they are consumed
+    K[i] = anisotropicIEFBlock(SI[i], DI[i], SE_block, DE_block, cav.elementArea().segment(i * dimBlock, dimBlock));
+  }
+  return K;
+}
+
+/*! \brief Builds the **isotropic** IEFPCM matrix, one irreducible representation at a time
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[in] epsilon permittivity outside the cavity
+ *  \param[in,out] operators cache of the operators inside the cavity, none when NULL
+ *  \return the diagonal blocks of the symmetry blocked \f$ \mathbf{K} \f$ matrix
+ *
+ *  The blocks of T and R are formed and factorized independently,
+ *  the full PCM matrix is never formed.
+ *  The matrices are not symmetrized.
+ */
+inline std::vector<Eigen::MatrixXd> isotropicIEFBlocks(const Cavity & cav, const IGreensFunction & gf_i, double epsilon,
+    OperatorCache * operators = NULL)
+{
+  std::vector<Eigen::MatrixXd> SI_local, DI_local;
+  if (!operators) {
+    SI_local = singleLayerBlocks(cav, gf_i);
+    DI_local = doubleLayerBlocks(cav, gf_i);
+  }
+  const std::vector<Eigen::MatrixXd> & SI = operators ? operators->singleLayerBlocks(cav, gf_i) : SI_local;
+  const std::vector<Eigen::MatrixXd> & DI = operators ? operators->doubleLayerBlocks(cav, gf_i) : DI_local;
+
+  int dimBlock = SI[0].rows();
+  std::vector<Eigen::MatrixXd> K(SI.size());
+  for (size_t i = 0; i < SI.size(); ++i) {
+    // The finite elements in each block are images of the irreducible ones, with the same areas
+    K[i] = isotropicIEFBlock(SI[i], DI[i], cav.elementArea().segment(i * dimBlock, dimBlock), epsilon);
+  }
+  return K;
+}
+
+/*! \brief Builds the spectral representation of the **isotropic** IEFPCM matrix, one irreducible representation at a time
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[out] left the \f$ \mathbf{S}_\mathrm{i}^{-1}\mathbf{V} \f$ matrices, one per block
+ *  \param[out] right the \f$ \mathbf{V}^{-1} \f$ matrices, one per block
+ *  \param[out] eigenvalues the eigenvalues of \f$ \mathbf{D}_\mathrm{i}\mathbf{A} \f$, one set per block
+ *  \param[in,out] operators cache of the operators inside the cavity, none when NULL
+ *
+ *  \sa isotropicIEFSpectrum
+ */
+inline void isotropicIEFSpectra(const Cavity & cav, const IGreensFunction & gf_i,
+    std::vector<Eigen::MatrixXcd> & left, std::vector<Eigen::MatrixXcd> & right, std::vector<Eigen::VectorXcd> & eigenvalues,
+    OperatorCache * operators = NULL)
+{
+  std::vector<Eigen::MatrixXd> SI_local, DI_local;
+  if (!operators) {
+    SI_local = singleLayerBlocks(cav, gf_i);
+    DI_local = doubleLayerBlocks(cav, gf_i);
+  }
+  const std::vector<Eigen::MatrixXd> & SI = operators ? operators->singleLayerBlocks(cav, gf_i) : SI_local;
+  const std::vector<Eigen::MatrixXd> & DI = operators ? operators->doubleLayerBlocks(cav, gf_i) : DI_local;
+
+  int dimBlock = SI[0].rows();
+  left.resize(SI.size());
+  right.resize(SI.size());
+  eigenvalues.resize(SI.size());
+  for (size_t i = 0; i < SI.size(); ++i) {
+    isotropicIEFSpectrum(SI[i], DI[i], cav.elementArea().segment(i * dimBlock, dimBlock), left[i], right[i], eigenvalues[i]);
+  }
+}
+
+/*! \brief Builds the CPCM matrix, one irreducible representation at a time
+ *  \param[in] cav the discretized cavity
+ *  \param[in] gf_i Green's function inside the cavity
+ *  \param[in] epsilon permittivity outside the cavity
+ *  \param[in] correction CPCM correction factor
+ *  \param[in,out] operators cache of the operators inside the cavity, none when NULL
+ *  \return the diagonal blocks of the symmetry blocked \f$ \mathbf{K} \f$ matrix
+ *
+ *  The blocks of SI are factorized independently, the full PCM matrix is never formed.
+ *  The matrices are not symmetrized.
+ */
+inline std::vector<Eigen::MatrixXd> CPCMBlocks(const Cavity & cav, const IGreensFunction & gf_i, double epsilon, double correction,
+    OperatorCache * operators = NULL)
+{
+  std::vector<Eigen::MatrixXd> SI_local;
+  if (!operators) SI_local = singleLayerBlocks(cav, gf_i);
+  const std::vector<Eigen::MatrixXd> & SI = operators ? operators->singleLayerBlocks(cav, gf_i) : SI_local;
+
+  std::vector<Eigen::MatrixXd> K(SI.size());
+  for (size_t i = 0; i < SI.size(); ++i) {
+    K[i] = CPCMBlock(SI[i], epsilon, correction);
+  }
+  return K;
 }
 
 /*! \brief Builds the **anisotropic** \f$ \mathbf{T}_\varepsilon \f$ matrix
@@ -221,37 +565,25 @@ inline Eigen::MatrixXd CPCMMatrix(const Cavity & cav, const IGreensFunction & gf
  *      \mathbf{A}\mathbf{D}_\mathrm{i}^\dagger\right)
  *  \f]
  *  The matrix is not symmetrized and is not symmetry packed.
+ *  SE and DE are not assembled when the kernels are proportional, see outsideOperatorsRatio
  */
 inline Eigen::MatrixXd anisotropicTEpsilon(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI, DI and SE, DE on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-  Eigen::MatrixXd SE = gf_o.singleLayer(cav.elements());
-  Eigen::MatrixXd DE = gf_o.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the matrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(DE, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SE, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = a.inverse();
-
-  // Form T
-  return ((2 * M_PI * aInv - DE) * a * SI + SE * a * (2 * M_PI * aInv + DI.adjoint().eval()));
+  // Compute the symmetry blocked SI, DI and SE, DE from the irreducible rows
+  // SE and DE are derived from SI and DI when the kernels are proportional
+  Eigen::MatrixXd SI = singleLayerBlocked(cav, gf_i);
+  Eigen::MatrixXd DI = doubleLayerBlocked(cav, gf_i);
+  double ratio = outsideOperatorsRatio(cav, gf_i, gf_o);
+  Eigen::MatrixXd SE = (ratio != 0.0) ? Eigen::MatrixXd(ratio * SI) : singleLayerBlocked(cav, gf_o);
+  Eigen::MatrixXd DE = (ratio != 0.0) ? DI : doubleLayerBlocked(cav, gf_o);
+
+  // Form T = (2 * M_PI - DE * a) * SI + SE * (2 * M_PI + (DI * a)^+)
+  DI = DI * cav.elementArea().asDiagonal();
+  DE = DE * cav.elementArea().asDiagonal();
+  Eigen::MatrixXd T = 2 * M_PI * (SI + SE);
+  T.noalias() -= DE * SI;
+  T.noalias() += SE * DI.adjoint();
+  return T;
 }
 
 /*! \brief Builds the **isotropic** \f$ \mathbf{T}_\varepsilon \f$ matrix
@@ -269,30 +601,16 @@ inline Eigen::MatrixXd anisotropicTEpsilon(const Cavity & cav, const IGreensFunc
  */
 inline Eigen::MatrixXd isotropicTEpsilon(const Cavity & cav, const IGreensFunction & gf_i, double epsilon)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI, DI and SE, DE on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the matrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = a.inverse();
+  // Compute the symmetry blocked SI and DI from the irreducible rows
+  Eigen::MatrixXd SI = singleLayerBlocked(cav, gf_i);
+  Eigen::MatrixXd DI = doubleLayerBlocked(cav, gf_i);
 
+  // T = 2 * M_PI * fact * SI - DI * a * SI
   double fact = (epsilon + 1.0)/(epsilon - 1.0);
-  return (2 * M_PI * fact * aInv - DI) * a * SI;
+  DI = DI * cav.elementArea().asDiagonal();
+  Eigen::MatrixXd T = 2 * M_PI * fact * SI;
+  T.noalias() -= DI * SI;
+  return T;
 }
 
 /*! \brief Builds the **anisotropic** \f$ \mathbf{R}_\infty \f$ matrix
@@ -308,39 +626,26 @@ inline Eigen::MatrixXd isotropicTEpsilon(const Cavity & cav, const IGreensFuncti
  *      \mathbf{S}_\mathrm{e}\mathbf{S}^{-1}_\mathrm{i}\left(2\pi\mathbf{A}^{-1}-\mathbf{D}_\mathrm{i}\right)
  *  \f]
  *  The matrix is not symmetrized and is not symmetry packed.
+ *  SE and DE are not assembled when the kernels are proportional, see outsideOperatorsRatio
  */
 inline Eigen::MatrixXd anisotropicRinfinity(const Cavity & cav, const IGreensFunction & gf_i, const IGreensFunction & gf_o)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI, DI and SE, DE on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd SI = gf_i.singleLayer(cav.elements());
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-  Eigen::MatrixXd SE = gf_o.singleLayer(cav.elements());
-  Eigen::MatrixXd DE = gf_o.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the matrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SI, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(DE, cavitySize, dimBlock, nrBlocks);
-    symmetryBlocking(SE, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = a.inverse();
-
-  // Form T
-  Eigen::FullPivLU<Eigen::MatrixXd> SI_LU(SI);
-  if (!(SI_LU.isInvertible())) PCMSOLVER_ERROR("SI matrix is not invertible!");
-  return (((2 * M_PI * aInv - DE) - SE * SI_LU.inverse() * (2 * M_PI * aInv - DI)) * a);
+  // Compute the symmetry blocked SI, DI and SE, DE from the irreducible rows
+  // SE and DE are derived from SI and DI when the kernels are proportional
+  Eigen::MatrixXd SI = singleLayerBlocked(cav, gf_i);
+  Eigen::MatrixXd DI = doubleLayerBlocked(cav, gf_i);
+  double ratio = outsideOperatorsRatio(cav, gf_i, gf_o);
+  Eigen::MatrixXd SE = (ratio != 0.0) ? Eigen::MatrixXd(ratio * SI) : singleLayerBlocked(cav, gf_o);
+  Eigen::MatrixXd DE = (ratio != 0.0) ? DI : doubleLayerBlocked(cav, gf_o);
+
+  // Form R * a = (2 * M_PI - DE * a) - SE * SI^-1 * (2 * M_PI - DI * a)
+  DI = - DI * cav.elementArea().asDiagonal();
+  DI.diagonal().array() += 2 * M_PI;
+  singleLayerSolveInPlace(SI, DI);
+  DE = - DE * cav.elementArea().asDiagonal();
+  DE.diagonal().array() += 2 * M_PI;
+  DE.noalias() -= SE * DI;
+  return DE;
 }
 
 /*! \brief Builds the **isotropic** \f$ \mathbf{R}_\infty \f$ matrix
@@ -357,25 +662,11 @@ inline Eigen::MatrixXd anisotropicRinfinity(const Cavity & cav, const IGreensFun
  */
 inline Eigen::MatrixXd isotropicRinfinity(const Cavity & cav, const IGreensFunction & gf_i)
 {
-  // The total size of the cavity
-  size_t cavitySize = cav.size();
-  // The number of irreps in the group
-  int nrBlocks = cav.pointGroup().nrIrrep();
-  // The size of the irreducible portion of the cavity
-  int dimBlock = cav.irreducible_size();
-
-  // Compute SI, DI and SE, DE on the whole cavity, regardless of symmetry
-  Eigen::MatrixXd DI = gf_i.doubleLayer(cav.elements());
-
-  // Perform symmetry blocking
-  // If the group is C1 avoid symmetry blocking, we will just pack the matrix
-  // into "block diagonal" when all other manipulations are done.
-  if (cav.pointGroup().nrGenerators() != 0) {
-    symmetryBlocking(DI, cavitySize, dimBlock, nrBlocks);
-  }
-
-  Eigen::MatrixXd a = cav.elementArea().asDiagonal();
-  Eigen::MatrixXd aInv = a.inverse();
+  // Compute the symmetry blocked DI from the irreducible rows
+  Eigen::MatrixXd DI = doubleLayerBlocked(cav, gf_i);
 
-  return ((2 * M_PI * aInv - DI) * a);
+  // R * a = 2 * M_PI - DI * a
+  DI = - DI * cav.elementArea().asDiagonal();
+  DI.diagonal().array() += 2 * M_PI;
+  return DI;
 }
@@ -0,0 +1,195 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "Treecode.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+Treecode::Treecode(const Eigen::Matrix3Xd & points, double theta, int order, int leafSize)
+    : theta_(theta), order_(order), leafSize_(leafSize), points_(points)
+{
+    if (theta_ <= 0.0 || theta_ >= 1.0) PCMSOLVER_ERROR("Treecode opening angle must be in (0, 1)!");
+    if (order_ < 0) PCMSOLVER_ERROR("Treecode expansion order must be non-negative!");
+    if (leafSize_ < 1) PCMSOLVER_ERROR("Treecode leaves must contain at least one point!");
+    // Multi-indices sorted by total degree: the recurrence for the Taylor
+    // coefficients of degree n only needs those of degree n-1 and n-2
+    position_.assign((order_ + 1) * (order_ + 1) * (order_ + 1), -1);
+    for (int n = 0; n <= order_; ++n) {
+        for (int i = n; i >= 0; --i) {
+            for (int j = n - i; j >= 0; --j) {
+                position_[(i * (order_ + 1) + j) * (order_ + 1) + n - i - j] = multiIndices_.size();
+                multiIndices_.push_back(Eigen::Vector3i(i, j, n - i - j));
+                degrees_.push_back(n);
+            }
+        }
+    }
+    for (size_t t = 0; t < multiIndices_.size(); ++t) {
+        Eigen::Vector3i k = multiIndices_[t];
+        lowered_.push_back(Eigen::Vector3i(position(k(0) - 1, k(1), k(2)),
+                    position(k(0), k(1) - 1, k(2)), position(k(0), k(1), k(2) - 1)));
+        loweredTwice_.push_back(Eigen::Vector3i(position(k(0) - 2, k(1), k(2)),
+                    position(k(0), k(1) - 2, k(2)), position(k(0), k(1), k(2) - 2)));
+    }
+
+    int nPoints = points_.cols();
+    permutation_.resize(nPoints);
+    for (int i = 0; i < nPoints; ++i) permutation_[i] = i;
+    Node root;
+    root.begin = 0;
+    root.end = nPoints;
+    tree_.push_back(root);
+    subdivide(0);
+}
+
+void Treecode::subdivide(int node)
+{
+    int begin = tree_[node].begin, end = tree_[node].end;
+    // Bounding box of the points in the node
+    Eigen::Vector3d lower = Eigen::Vector3d::Constant(0.0), upper = Eigen::Vector3d::Constant(0.0);
+    if (end > begin) {
+        lower = points_.col(permutation_[begin]);
+        upper = lower;
+    }
+    for (int k = begin; k < end; ++k) {
+        lower = lower.cwiseMin(points_.col(permutation_[k]));
+        upper = upper.cwiseMax(points_.col(permutation_[k]));
+    }
+    Eigen::Vector3d center = 0.5 * (lower + upper);
+    double radius = 0.0;
+    for (int k = begin; k < end; ++k) {
+        radius = std::max(radius, (points_.col(permutation_[k]) - center).norm());
+    }
+    tree_[node].center = center;
+    tree_[node].radius = radius;
+    // Coincident points cannot be separated any further
+    if (end - begin <= leafSize_ || radius == 0.0) return;
+
+    // Sort the points into the octants of the bounding box.
+    // Since the children bounding boxes are recomputed, at least two octants are not empty
+    std::vector<std::vector<int> > octants(8);
+    for (int k = begin; k < end; ++k) {
+        int index = permutation_[k];
+        Eigen::Vector3d point = points_.col(index);
+        int octant = (point(0) > center(0)) + 2 * (point(1) > center(1)) + 4 * (point(2) > center(2));
+        octants[octant].push_back(index);
+    }
+    int offset = begin;
+    for (int i = 0; i < 8; ++i) {
+        if (octants[i].empty()) continue;
+        Node child;
+        child.begin = offset;
+        child.end = offset + octants[i].size();
+        for (size_t k = 0; k < octants[i].size(); ++k) permutation_[offset + k] = octants[i][k];
+        offset = child.end;
+        tree_.push_back(child);
+        // tree_ might be reallocated, children are appended by index
+        tree_[node].children.push_back(tree_.size() - 1);
+    }
+    for (size_t i = 0; i < tree_[node].children.size(); ++i) {
+        subdivide(tree_[node].children[i]);
+    }
+}
+
+Eigen::VectorXd Treecode::potential(const Eigen::VectorXd & charges, const Eigen::Matrix3Xd & dipoles) const
+{
+    int nPoints = points_.cols();
+    size_t nNodes = tree_.size();
+    size_t nTerms = multiIndices_.size();
+    // Upward pass: moments of each node with respect to its center
+    // m_k = \sum_j q_j d_j^k + \sum_j \sum_i p_{j,i} k_i d_j^{k - e_i}
+    Eigen::MatrixXd moments = Eigen::MatrixXd::Zero(nTerms, nNodes);
+    Eigen::MatrixXd powers(order_ + 1, 3);
+    for (size_t n = 0; n < nNodes; ++n) {
+        const Node & node = tree_[n];
+        for (int k = node.begin; k < node.end; ++k) {
+            int j = permutation_[k];
+            Eigen::Vector3d d = points_.col(j) - node.center;
+            powers.row(0).setOnes();
+            for (int m = 1; m <= order_; ++m) powers.row(m) = powers.row(m - 1).cwiseProduct(d.transpose());
+            for (size_t t = 0; t < nTerms; ++t) {
+                const Eigen::Vector3i & index = multiIndices_[t];
+                double moment = charges(j) * powers(index(0), 0) * powers(index(1), 1) * powers(index(2), 2);
+                if (index(0) > 0) moment += dipoles(0, j) * index(0) * powers(index(0) - 1, 0) * powers(index(1), 1) * powers(index(2), 2);
+                if (index(1) > 0) moment += dipoles(1, j) * index(1) * powers(index(0), 0) * powers(index(1) - 1, 1) * powers(index(2), 2);
+                if (index(2) > 0) moment += dipoles(2, j) * index(2) * powers(index(0), 0) * powers(index(1), 1) * powers(index(2) - 1, 2);
+                moments(t, n) += moment;
+            }
+        }
+    }
+
+    // Downward pass: traverse the tree for each point
+    Eigen::VectorXd phi = Eigen::VectorXd::Zero(nPoints);
+    Eigen::VectorXd coefficients(nTerms);
+    std::vector<int> stack;
+    for (int i = 0; i < nPoints; ++i) {
+        Eigen::Vector3d target = points_.col(i);
+        double value = 0.0;
+        stack.push_back(0);
+        while (!stack.empty()) {
+            int n = stack.back();
+            stack.pop_back();
+            const Node & node = tree_[n];
+            Eigen::Vector3d R = target - node.center;
+            double distance = R.norm();
+            int size = node.end - node.begin;
+            if (node.radius < theta_ * distance && size > static_cast<int>(nTerms)) {
+                // Taylor coefficients of 1 / |x - y| about the center of the node
+                double R2Inv = 1.0 / (distance * distance);
+                coefficients(0) = 1.0 / distance;
+                for (size_t t = 1; t < nTerms; ++t) {
+                    const Eigen::Vector3i & lowered = lowered_[t];
+                    const Eigen::Vector3i & loweredTwice = loweredTwice_[t];
+                    double first = 0.0, second = 0.0;
+                    for (int m = 0; m < 3; ++m) {
+                        if (lowered(m) >= 0) first += R(m) * coefficients(lowered(m));
+                        if (loweredTwice(m) >= 0) second += coefficients(loweredTwice(m));
+                    }
+                    int degree = degrees_[t];
+                    coefficients(t) = ((2 * degree - 1) * first - (degree - 1) * second) * R2Inv / degree;
+                }
+                value += coefficients.dot(moments.col(n));
+            } else if (node.children.empty() || node.radius < theta_ * distance) {
+                // Leaves and far nodes with fewer points than expansion terms are summed directly
+                for (int k = node.begin; k < node.end; ++k) {
+                    int j = permutation_[k];
+                    if (j == i) continue;
+                    Eigen::Vector3d d = target - points_.col(j);
+                    double rInv = 1.0 / d.norm();
+                    value += charges(j) * rInv + dipoles.col(j).dot(d) * rInv * rInv * rInv;
+                }
+            } else {
+                stack.insert(stack.end(), node.children.begin(), node.children.end());
+            }
+        }
+        phi(i) = value;
+    }
+    return phi;
+}
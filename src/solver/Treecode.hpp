@@ -0,0 +1,126 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef TREECODE_HPP
+#define TREECODE_HPP
+
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+/*! \file Treecode.hpp
+ *  \class Treecode
+ *  \brief Barnes-Hut treecode for the Coulomb potential of point charges and dipoles
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  The points are sorted into an octree. The potential generated at each point
+ *  by the charges \f$ q_j \f$ and dipoles \f$ \mathbf{p}_j \f$ sitting on all the
+ *  other points:
+ *  \f[
+ *      \phi_i = \sum_{j\neq i} \frac{q_j}{|\mathbf{r}_i - \mathbf{r}_j|}
+ *             + \frac{\mathbf{p}_j\cdot(\mathbf{r}_i - \mathbf{r}_j)}{|\mathbf{r}_i - \mathbf{r}_j|^3}
+ *  \f]
+ *  is computed by direct summation for the near field and by a Cartesian Taylor
+ *  expansion of the kernel about the center of a node of the tree for the far field.
+ *  The Taylor coefficients are obtained by recurrence, as described in
+ *  K. Lindsay and R. Krasny, J. Comput. Phys. 172, 879 (2001)
+ *  A node of the tree is in the far field of a point when the ratio of its radius
+ *  to its distance from the point is smaller than the opening angle \f$ \theta \f$.
+ *  The cost of a potential evaluation is \f$ O(N\log N) \f$, the error decreases
+ *  as \f$ \theta^{p+1} \f$ for an expansion of order \f$ p \f$.
+ *  These are the actions of the collocation S and D operators for the \f$ 1/r \f$
+ *  kernel, without the diagonal elements.
+ */
+
+class Treecode
+{
+public:
+    /*! \brief Builds the octree
+     *  \param[in] points the points, 3 x N
+     *  \param[in] theta opening angle, in (0, 1)
+     *  \param[in] order order of the Taylor expansion
+     *  \param[in] leafSize maximum number of points in a leaf
+     */
+    Treecode(const Eigen::Matrix3Xd & points, double theta, int order = 6, int leafSize = 32);
+    /*! \brief Returns the potential at the points
+     *  \param[in] charges the charges sitting on the points
+     *  \param[in] dipoles the dipoles sitting on the points, 3 x N
+     *
+     *  The self-interaction is excluded.
+     */
+    Eigen::VectorXd potential(const Eigen::VectorXd & charges, const Eigen::Matrix3Xd & dipoles) const;
+    /*! Number of nodes in the octree */
+    size_t nodes() const { return tree_.size(); }
+private:
+    struct Node {
+        /*! Center of the bounding box, origin of the multipole expansion */
+        Eigen::Vector3d center;
+        /*! Radius of the sphere centered in center and enclosing all points in the node */
+        double radius;
+        /*! Index of the first point of the node in the permutation */
+        int begin;
+        /*! Index past the last point of the node in the permutation */
+        int end;
+        /*! Indices of the children nodes, empty for a leaf */
+        std::vector<int> children;
+    };
+    /*! Opening angle */
+    double theta_;
+    /*! Order of the Taylor expansion */
+    int order_;
+    /*! Maximum number of points in a leaf */
+    int leafSize_;
+    /*! Multi-indices of the Taylor expansion, sorted by increasing total degree */
+    std::vector<Eigen::Vector3i> multiIndices_;
+    /*! Total degree of the multi-indices */
+    std::vector<int> degrees_;
+    /*! Position of a multi-index in multiIndices_, -1 for degrees higher than order_ */
+    std::vector<int> position_;
+    /*! Positions of the multi-indices lowered by one along each direction, -1 if not valid */
+    std::vector<Eigen::Vector3i> lowered_;
+    /*! Positions of the multi-indices lowered by two along each direction, -1 if not valid */
+    std::vector<Eigen::Vector3i> loweredTwice_;
+    /*! The points */
+    Eigen::Matrix3Xd points_;
+    /*! Permutation of the points, points in a node are contiguous */
+    std::vector<int> permutation_;
+    /*! The octree, root first */
+    std::vector<Node> tree_;
+
+    /*! \brief Subdivides a node and its descendants
+     *  \param[in] node index of the node in the tree
+     */
+    void subdivide(int node);
+    /*! \brief Position of a multi-index in multiIndices_, -1 if out of range */
+    int position(int i, int j, int k) const {
+        if (i < 0 || j < 0 || k < 0) return -1;
+        return position_[(i * (order_ + 1) + j) * (order_ + 1) + k];
+    }
+};
+
+#endif // TREECODE_HPP
@@ -27,7 +27,9 @@
 #define ERRORHANDLING_HPP
 
 #include <cassert>
+#include <exception>
 #include <stdexcept>
+#include <string>
 
 
 /*! \file ErrorHandling.hpp
@@ -66,6 +68,21 @@
  *  Same usage pattern as for normal assertions. Static assertions are
  *  checked at compile-time.
  *  See also here: http://www.boost.org/doc/libs/1_59_0/doc/html/boost_staticassert.html
+ *
+ *  Errors in OpenMP parallel regions:
+ *
+ *  An exception escaping a parallel region calls std::terminate.
+ *  The body of the loop catches the exception and records it in
+ *  a ParallelError, the error is raised after the region.
+ *
+ *  \verbatim
+ *  ParallelError error;
+ *  #pragma omp parallel for
+ *  for (int i = 0; i < n; ++i) {
+ *      try { <Body> } catch (const std::exception & e) { error.record(e); }
+ *  }
+ *  error.raise();
+ *  \endverbatim
  */
 
 /// Macro to be used to throw exceptions
@@ -82,4 +99,31 @@
 #define PCMSOLVER_STATIC_ASSERT(arg, msg) BOOST_STATIC_ASSERT_MSG(arg, msg)
 #endif /* HAS_CXX11_STATIC_ASSERT */
 
+/*! \class ParallelError
+ *  \brief Keeps the first error recorded by the threads of a parallel region
+ */
+class ParallelError
+{
+public:
+    ParallelError() : failed_(false), message_() {}
+    /*! Records an error, only the first one is kept */
+    void record(const std::exception & e)
+    {
+#ifdef HAVE_OPENMP
+#pragma omp critical (parallel_error)
+#endif
+        {
+            if (!failed_) {
+                failed_ = true;
+                message_ = e.what();
+            }
+        }
+    }
+    /*! Raises the recorded error, if any. To be called outside of the parallel region */
+    void raise() const { if (failed_) PCMSOLVER_ERROR(message_); }
+private:
+    bool failed_;
+    std::string message_;
+};
+
 #endif /* ERRORHANDLING_HPP */
@@ -71,10 +71,12 @@ struct greenData {
     Eigen::Vector3d origin;
     /*! Maximum angular momentum */
     int maxL;
+    /*! Relative tolerance of the adaptive numerical integration of the diagonal of S and D */
+    double integratorTolerance;
     /*! Whether the structure was initialized with user input or not */
     bool empty;
 
-    greenData() { empty = true;}
+    greenData() : integratorTolerance(0.0) { empty = true;}
     greenData(int how_d, int how_i, int how_p,
               double _epsilon = 1.0,
               double _kappa = 0.0,
@@ -94,7 +96,7 @@ struct greenData {
     epsilon(_epsilon), kappa(_kappa), epsilonTensor(epstens), eulerAngles(euler),
 	epsilonReal(_epsReal), epsilonImaginary(_epsImaginary),
     NPspheres(_sphere), NPradii(_sphRadius),
-    epsilon1(_e1), epsilon2(_e2), center(_c), width(_w), origin(_o), maxL(l) { empty = false; }
+    epsilon1(_e1), epsilon2(_e2), center(_c), width(_w), origin(_o), maxL(l), integratorTolerance(0.0) { empty = false; }
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW /* See http://eigen.tuxfamily.org/dox/group__TopicStructHavingEigenMembers.html */
 };
 
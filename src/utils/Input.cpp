@@ -162,13 +162,21 @@ void Input::reader(const std::string & filename)
         epsilonStaticOutside_ = solvent_.epsStatic();
         epsilonDynamicOutside_ = solvent_.epsDynamic();
     }
-    integratorType_ = integratorPolicy("COLLOCATION"); // Currently hardcoded!!!
+    integratorType_ = integratorPolicy(medium.getStr("DIAGONALINTEGRATOR"));
+    integratorTolerance_ = medium.getDbl("DIAGONALTOLERANCE");
 
     solverType_ = medium.getStr("SOLVERTYPE");
     equationType_ = integralEquation(medium.getStr("EQUATIONTYPE"));
     correction_ = medium.getDbl("CORRECTION");
     hermitivitize_ = medium.getBool("MATRIXSYMM");
     isDynamic_ = medium.getBool("NONEQUILIBRIUM");
+    solverThreshold_ = medium.getDbl("SOLVERTHRESHOLD");
+    maxIterations_ = medium.getInt("MAXITERATIONS");
+    openingAngle_ = medium.getDbl("OPENINGANGLE");
+    compression_ = medium.getDbl("COMPRESSION");
+    matrixCache_ = medium.getStr("MATRIXCACHE");
+    incrementalUpdate_ = medium.getBool("INCREMENTALUPDATE");
+    permittivityUpdate_ = medium.getBool("PERMITTIVITYUPDATE");
 
     providedBy_ = std::string("API-side");
 }
@@ -237,7 +245,8 @@ void Input::reader(const PCMInput & host_input)
         epsilonStaticOutside_ = solvent_.epsStatic();
         epsilonDynamicOutside_ = solvent_.epsDynamic();
     }
-    integratorType_ = integratorPolicy("COLLOCATION"); // Currently hardcoded!!!
+    integratorType_ = integratorPolicy("COLLOCATION");
+    integratorTolerance_ = 0.0;
 
     solverType_ = trim_and_upper(host_input.solver_type);
     std::string inteq = trim_and_upper(host_input.equation_type);
@@ -245,6 +254,13 @@ void Input::reader(const PCMInput & host_input)
     correction_ = host_input.correction;
     hermitivitize_ = true;
     isDynamic_ = false;
+    solverThreshold_ = 1.0e-10;
+    maxIterations_ = 200;
+    openingAngle_ = 0.0;
+    compression_ = 0.0;
+    matrixCache_ = std::string("");
+    incrementalUpdate_ = false;
+    permittivityUpdate_ = false;
 
     providedBy_ = std::string("host-side");
 }
@@ -321,6 +337,7 @@ greenData Input::insideGreenParams()
     if (insideGreenData_.empty) {
         int profile = profilePolicy("UNIFORM");
         insideGreenData_ = greenData(derivativeInsideType_, integratorType_, profile, epsilonInside_);
+        insideGreenData_.integratorTolerance = integratorTolerance_;
     }
     return insideGreenData_;
 }
@@ -331,6 +348,7 @@ greenData Input::outsideStaticGreenParams()
         int profile = profilePolicy("UNIFORM");
         outsideStaticGreenData_ = greenData(derivativeOutsideType_,
                                             integratorType_, profile,  epsilonStaticOutside_);
+        outsideStaticGreenData_.integratorTolerance = integratorTolerance_;
         if (not hasSolvent_) {
            outsideStaticGreenData_.howProfile = profileType_;
            outsideStaticGreenData_.epsilon1 = epsilonStatic1_;
@@ -350,6 +368,7 @@ greenData Input::outsideDynamicGreenParams()
         int profile = profilePolicy("UNIFORM");
         outsideDynamicGreenData_ = greenData(derivativeOutsideType_,
                                              integratorType_, profile, epsilonDynamicOutside_);
+        outsideDynamicGreenData_.integratorTolerance = integratorTolerance_;
         if (not hasSolvent_) {
            outsideDynamicGreenData_.howProfile  = profileType_;
            outsideDynamicGreenData_.epsilon1 = epsilonDynamic1_;
@@ -366,7 +385,8 @@ greenData Input::outsideDynamicGreenParams()
 solverData Input::solverParams()
 {
     if (solverData_.empty) {
-        solverData_ = solverData(correction_, equationType_, hermitivitize_);
+        solverData_ = solverData(correction_, equationType_, hermitivitize_, solverThreshold_, maxIterations_, openingAngle_, matrixCache_, compression_,
+                permittivityUpdate_);
     }
     return solverData_;
 }
@@ -378,6 +398,7 @@ int derivativeTraits(const std::string & name)
     mapStringToInt.insert(std::map<std::string, int>::value_type("DERIVATIVE", 1));
     mapStringToInt.insert(std::map<std::string, int>::value_type("GRADIENT", 2));
     mapStringToInt.insert(std::map<std::string, int>::value_type("HESSIAN", 3));
+    mapStringToInt.insert(std::map<std::string, int>::value_type("ANALYTIC", 4));
 
     return mapStringToInt.find(name)->second;
 }
@@ -386,7 +407,8 @@ int integratorPolicy(const std::string & name)
 {
     static std::map<std::string, int> mapStringToInt;
     mapStringToInt.insert(std::map<std::string, int>::value_type("COLLOCATION", 0));
-    mapStringToInt.insert(std::map<std::string, int>::value_type("NUMERICAL", 1));
+    mapStringToInt.insert(std::map<std::string, int>::value_type("PURISIMA", 1));
+    mapStringToInt.insert(std::map<std::string, int>::value_type("NUMERICAL", 2));
 
     return mapStringToInt.find(name)->second;
 }
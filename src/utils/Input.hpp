@@ -87,7 +87,7 @@ public:
     Sphere spheres(int i) const { return spheres_[i]; }
     Molecule molecule() const { return molecule_; }
     /// This method sets the molecule and the list of spheres
-    void molecule(const Molecule & m) { molecule_ = m; spheres_ = molecule_.spheres(); }
+    void molecule(const Molecule & m) { molecule_ = m; spheres_ = molecule_.spheres(); cavData_ = cavityData(); }
     void initMolecule();
     /// @}
 
@@ -98,6 +98,17 @@ public:
     int equationType() const { return equationType_; }
     double correction() const { return correction_; }
     bool hermitivitize() const { return hermitivitize_; }
+    double solverThreshold() const { return solverThreshold_; }
+    int maxIterations() const { return maxIterations_; }
+    double openingAngle() const { return openingAngle_; }
+    double compression() const { return compression_; }
+    std::string matrixCache() const { return matrixCache_; }
+    bool incrementalUpdate() const { return incrementalUpdate_; }
+    bool permittivityUpdate() const { return permittivityUpdate_; }
+    /// This method sets the static permittivity outside the cavity
+    void epsilonStaticOutside(double epsilon) { epsilonStaticOutside_ = epsilon; outsideStaticGreenData_.epsilon = epsilon; }
+    int integratorType() const { return integratorType_; }
+    double integratorTolerance() const { return integratorTolerance_; }
     bool isDynamic() const { return isDynamic_; }
     /// @}
 
@@ -190,10 +201,26 @@ private:
     bool hermitivitize_;
     /// Whether the dynamic PCM matrix should be used
     bool isDynamic_;
+    /// Convergence threshold on the relative residual (iterative solvers)
+    double solverThreshold_;
+    /// Maximum number of iterations (iterative solvers)
+    int maxIterations_;
+    /// Opening angle for the treecode (iterative solvers)
+    double openingAngle_;
+    /// Tolerance of the hierarchical matrix compression (iterative solvers)
+    double compression_;
+    /// Directory of the on-disk PCM matrix cache (collocation solvers)
+    std::string matrixCache_;
+    /// Whether the operators inside the cavity are updated from those of the previous geometry (collocation solvers)
+    bool incrementalUpdate_;
+    /// Whether the PCM matrix can be updated for a new permittivity (IEFPCM retains its spectral representation)
+    bool permittivityUpdate_;
     /// Solvent probe radius
     double probeRadius_;
     /// Type of integrator for the diagonal of the boundary integral operators
     int integratorType_;
+    /// Relative tolerance of the adaptive numerical integration of the diagonal, fixed rule when zero
+    double integratorTolerance_;
     /// The Green's function type inside the cavity
     std::string greenInsideType_;
     /// The Green's function type outside the cavity
@@ -38,6 +38,7 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <Eigen/LU>
 
 #include "SplineFunction.hpp"
 #include "Symmetry.hpp"
@@ -107,6 +108,21 @@ inline bool numericalZero(double value)
     return (isZero(value, 1.0e-14));
 }
 
+/*! \fn inline bool isInvertible(const Eigen::PartialPivLU<Eigen::MatrixXd> & lu)
+ *  \param[in] lu LU decomposition with partial pivoting of a square matrix
+ *
+ *  Returns true if none of the pivots is negligible with respect to the largest one.
+ *  LU decomposition with partial pivoting is not rank-revealing, this is the same
+ *  heuristic used by Eigen::FullPivLU::isInvertible()
+ */
+inline bool isInvertible(const Eigen::PartialPivLU<Eigen::MatrixXd> & lu)
+{
+    Eigen::VectorXd pivots = lu.matrixLU().diagonal().cwiseAbs();
+    if (pivots.size() == 0) return true;
+    double threshold = pivots.size() * std::numeric_limits<double>::epsilon();
+    return (pivots.minCoeff() > threshold * pivots.maxCoeff());
+}
+
 /*! \fn inline void symmetryBlocking(Eigen::MatrixXd & matrix, int cavitySize, int ntsirr, int nr_irrep)
  *  \param[out] matrix the matrix to be block-diagonalized
  *  \param[in]  cavitySize the size of the cavity (size of the matrix)
@@ -183,6 +199,83 @@ inline void symmetryBlocking(Eigen::MatrixXd & matrix, size_t cavitySize, int nt
     }
 }
 
+/*! \fn inline void symmetryBlocksFromRows(std::vector<Eigen::MatrixXd> & blocks, const Eigen::MatrixXd & rows, int ntsirr, int nr_irrep)
+ *  \param[out] blocks     the diagonal blocks of the symmetry blocked matrix
+ *  \param[in]  rows       the rows of the matrix relative to the irreducible portion of the cavity
+ *  \param[in]  ntsirr     the size of the irreducible portion of the cavity (size of the blocks)
+ *  \param[in]  nr_irrep   the number of irreducible representations (number of blocks)
+ *
+ *  An operator invariant under the point group satisfies \f$ M_{jk} = M_{0,j\oplus k} \f$,
+ *  where \f$ M_{jk} \f$ is the block coupling the finite elements generated by the symmetry
+ *  operations j and k and \f$ \oplus \f$ is the bitwise XOR of the operation indices.
+ *  The irreducible rows are thus sufficient and the i-th diagonal block is:
+ *  \f[
+ *      \mathbf{M}_i = \sum_k \chi_i(k) \mathbf{M}_{0k}
+ *  \f]
+ *  with \f$ \chi_i(k) \f$ the character of the i-th irreducible representation.
+ *  The blocks are the same as those obtained by symmetryBlocking followed by symmetryPacking.
+ */
+inline void symmetryBlocksFromRows(std::vector<Eigen::MatrixXd> & blocks, const Eigen::MatrixXd & rows,
+                                   int ntsirr, int nr_irrep)
+{
+    blocks.assign(nr_irrep, Eigen::MatrixXd::Zero(ntsirr, ntsirr));
+    for (int i = 0; i < nr_irrep; ++i) {
+        for (int k = 0; k < nr_irrep; ++k) {
+            blocks[i] += parity(i&k) * rows.block(0, k * ntsirr, ntsirr, ntsirr);
+        }
+        // Traverse the block and discard numerical zeros
+        for (int a = 0; a < ntsirr; ++a) {
+            for (int b = 0; b < ntsirr; ++b) {
+                if (numericalZero(blocks[i](a, b))) {
+                    blocks[i](a, b) = 0.0;
+                }
+            }
+        }
+    }
+}
+
+/*! \fn inline Eigen::MatrixXd symmetryBlockingFromRows(const Eigen::MatrixXd & rows, int ntsirr, int nr_irrep)
+ *  \param[in]  rows       the rows of the matrix relative to the irreducible portion of the cavity
+ *  \param[in]  ntsirr     the size of the irreducible portion of the cavity (size of the blocks)
+ *  \param[in]  nr_irrep   the number of irreducible representations (number of blocks)
+ *  \return the block diagonal matrix, as obtained by symmetryBlocking on the full matrix
+ *
+ *  The diagonal blocks are computed by symmetryBlocksFromRows.
+ */
+inline Eigen::MatrixXd symmetryBlockingFromRows(const Eigen::MatrixXd & rows, int ntsirr, int nr_irrep)
+{
+    size_t cavitySize = rows.cols();
+    Eigen::MatrixXd matrix = Eigen::MatrixXd::Zero(cavitySize, cavitySize);
+    std::vector<Eigen::MatrixXd> blocks;
+    symmetryBlocksFromRows(blocks, rows, ntsirr, nr_irrep);
+    for (int i = 0; i < nr_irrep; ++i) {
+        matrix.block(i * ntsirr, i * ntsirr, ntsirr, ntsirr) = blocks[i];
+    }
+    return matrix;
+}
+
+/*! \fn inline Eigen::VectorXd symmetryAdapt(const Eigen::VectorXd & vector, int ntsirr, int nr_irrep, bool inverse)
+ *  \param[in] vector     the vector to be transformed
+ *  \param[in] ntsirr     the size of the irreducible portion of the cavity (size of the blocks)
+ *  \param[in] nr_irrep   the number of irreducible representations (number of blocks)
+ *  \param[in] inverse    whether the inverse transformation has to be applied
+ *
+ *  Applies to a vector the same transformation used in symmetryBlocking for matrices.
+ *  Given the blocking matrix U, a vector on the full cavity is symmetry adapted by U * vector,
+ *  while the inverse transformation is given by Ut * vector, where U * Ut = Ut * U = id
+ */
+inline Eigen::VectorXd symmetryAdapt(const Eigen::VectorXd & vector, int ntsirr, int nr_irrep, bool inverse = false)
+{
+    double scaling = inverse ? 1.0 / nr_irrep : 1.0;
+    Eigen::VectorXd adapted = Eigen::VectorXd::Zero(vector.size());
+    for (int i = 0; i < nr_irrep; ++i) {
+        for (int j = 0; j < nr_irrep; ++j) {
+            adapted.segment(i * ntsirr, ntsirr) += scaling * parity(i&j) * vector.segment(j * ntsirr, ntsirr);
+        }
+    }
+    return adapted;
+}
+
 /*! \fn inline void symmetryPacking(std::vector<Eigen::MatrixXd> & blockedMatrix, const Eigen::MatrixXd & fullMatrix, int nrBlocks, int dimBlock)
  *  \param[out] blockedMatrix the result of packing fullMatrix
  *  \param[in]  fullMatrix the matrix to be packed
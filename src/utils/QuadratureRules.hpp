@@ -40,6 +40,32 @@ struct QuadratureRule {
     double weight(int i) { return PointsPolicy::gaussWeight(i); }
 };
 
+struct gauss8 {
+    int nPoints() { return 8; }
+    /*! Abscissae for 8-point Gaussian quadrature rule */
+    static double gaussAbscissa(int i) {
+        static std::vector<double> x8(4);
+
+        x8[0] = 0.9602898564975362316835609;
+        x8[1] = 0.7966664774136267395915539;
+        x8[2] = 0.5255324099163289858177390;
+        x8[3] = 0.1834346424956498049394761;
+
+        return x8[i];
+    }
+    /*! Weights for 8-point Gaussian quadrature rule */
+    static double gaussWeight(int i) {
+        static std::vector<double> w8(4);
+
+        w8[0] = 0.1012285362903762591525314;
+        w8[1] = 0.2223810344533744705443560;
+        w8[2] = 0.3137066458778872873379622;
+        w8[3] = 0.3626837833783619829651504;
+
+        return w8[i];
+    }
+};
+
 struct gauss16 {
     int nPoints() { return 16; }
     /*! Abscissae for 16-point Gaussian quadrature rule */
@@ -211,7 +237,8 @@ struct gauss64 {
 
 namespace mpl = boost::mpl;
 
-typedef mpl::map< mpl::pair<mpl::int_<16>, gauss16>,
+typedef mpl::map< mpl::pair<mpl::int_<8>, gauss8>,
+        mpl::pair<mpl::int_<16>, gauss16>,
         mpl::pair<mpl::int_<32>, gauss32>,
         mpl::pair<mpl::int_<64>, gauss64> > rules_map;
 
@@ -38,6 +38,7 @@
 #include <boost/numeric/odeint.hpp>
 
 #include "InterfacesImpl.hpp"
+#include "SplineTable.hpp"
 
 using interfaces::ProfileEvaluator;
 using interfaces::IntegratorParameters;
@@ -114,6 +115,10 @@ class Zeta __final
         double r_infinity_;
         /// The actual data: grid, function value and first derivative values
         RadialSolution function_;
+        /// Interpolation table for the function values
+        SplineTable functionTable_;
+        /// Interpolation table for the first derivative values
+        SplineTable derivativeTable_;
         /*! Reports progress of differential equation integrator */
         void push_back(const StateVariable & x, double r) {
             function_[0].push_back(r);
@@ -136,6 +141,9 @@ class Zeta __final
             odeint::integrate_adaptive(stepper, system, init_zeta,
                     r_0_, r_infinity_, parms.observer_step_,
                     pcm::bind(&Zeta<StateVariable, ODESystem>::push_back, this, pcm::_1, pcm::_2));
+            // Tabulate the interpolation coefficients, once and for all
+            functionTable_ = SplineTable(function_[0], function_[1]);
+            derivativeTable_ = SplineTable(function_[0], function_[2]);
         }
         /*! \brief Returns value of function at given point
          *  \param[in] point evaluation point
@@ -148,7 +156,7 @@ class Zeta __final
             if (point <= r_0_) {
                 zeta = L_ * std::log(point);
             } else {
-                zeta = splineInterpolation(point, function_[0], function_[1]);
+                zeta = functionTable_(point);
             }
             return zeta;
         }
@@ -163,7 +171,7 @@ class Zeta __final
             if (point <= r_0_) {
                 zeta = L_ / point;
             } else {
-                zeta = splineInterpolation(point, function_[0], function_[2]);
+                zeta = derivativeTable_(point);
             }
             return zeta;
         }
@@ -207,6 +215,10 @@ class Omega __final
         double r_infinity_;
         /// The actual data: grid, function value and first derivative values
         RadialSolution function_;
+        /// Interpolation table for the function values
+        SplineTable functionTable_;
+        /// Interpolation table for the first derivative values
+        SplineTable derivativeTable_;
         /*! Reports progress of differential equation integrator */
         void push_back(const StateVariable & x, double r) {
             function_[0].push_back(r);
@@ -235,6 +247,9 @@ class Omega __final
             BOOST_FOREACH(StateVariable & comp, function_) {
                 std::reverse(comp.begin(), comp.end());
             }
+            // Tabulate the interpolation coefficients, once and for all
+            functionTable_ = SplineTable(function_[0], function_[1]);
+            derivativeTable_ = SplineTable(function_[0], function_[2]);
         }
         /*! \brief Returns value of function at given point
          *  \param[in] point evaluation point
@@ -247,7 +262,7 @@ class Omega __final
             if (point >= r_infinity_) {
                 omega = -(L_ + 1) * std::log(point);
             } else {
-                omega = splineInterpolation(point, function_[0], function_[1]);
+                omega = functionTable_(point);
             }
             return omega;
         }
@@ -262,7 +277,7 @@ class Omega __final
             if (point >= r_infinity_) {
                 omega = -(L_ + 1) / point;
             } else {
-                omega = splineInterpolation(point, function_[0], function_[2]);
+                omega = derivativeTable_(point);
             }
             return omega;
         }
@@ -26,6 +26,8 @@
 #ifndef SOLVERDATA_HPP
 #define SOLVERDATA_HPP
 
+#include <string>
+
 #include "Config.hpp"
 
 /*! @struct solverData
@@ -40,12 +42,28 @@ struct solverData
     int integralEquation;
     /*! Triggers hermitivitization of the PCM matrix obtained by collocation */
     bool hermitivitize;
+    /*! Convergence threshold on the relative residual for the iterative solvers */
+    double threshold;
+    /*! Maximum number of iterations for the iterative solvers */
+    int maxIterations;
+    /*! Opening angle for the treecode in the iterative solvers, direct summation when zero */
+    double openingAngle;
+    /*! Tolerance of the hierarchical matrix compression in the iterative solvers, no compression when zero */
+    double compression;
+    /*! Directory of the on-disk PCM matrix cache, no caching when empty */
+    std::string matrixCache;
+    /*! Triggers the retention of the spectral representation of the IEFPCM matrix, for permittivity updates */
+    bool permittivityUpdate;
     /*! Whether the structure was initialized with user input or not */
     bool empty;
 
     solverData() { empty = true; }
-    solverData(double corr,  int int_eq = 1, bool symm = true) :
-       correction(corr), integralEquation(int_eq), hermitivitize(symm) { empty = false; }
+    solverData(double corr,  int int_eq = 1, bool symm = true, double thresh = 1.0e-10, int maxIt = 200,
+               double theta = 0.0, const std::string & cache = "", double hTol = 0.0,
+               bool update = false) :
+       correction(corr), integralEquation(int_eq), hermitivitize(symm),
+       threshold(thresh), maxIterations(maxIt), openingAngle(theta), compression(hTol), matrixCache(cache),
+       permittivityUpdate(update) { empty = false; }
 };
 
 #endif // SOLVERDATA_HPP
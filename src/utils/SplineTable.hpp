@@ -0,0 +1,120 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *     
+ *     This file is part of PCMSolver.
+ *     
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *     
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *     
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *     
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#ifndef SPLINETABLE_HPP
+#define SPLINETABLE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+/*! \file SplineTable.hpp
+ *  \class SplineTable
+ *  \brief Piecewise quadratic interpolation of a function tabulated on a grid
+ *  \author Roberto Di Remigio
+ *  \date 2016
+ *
+ *  On the interval \f$ (x_k, x_{k+1}] \f$ the function is interpolated by the
+ *  parabola through the grid points \f$ x_{k-1}, x_k, x_{k+1} \f$, as done by splineInterpolation.
+ *  The coefficients of the parabolas are calculated once, upon construction.
+ *  The interval containing a point is found in constant time using a uniform
+ *  bucketing of the grid, no search nor allocation is performed upon evaluation.
+ *  Points outside the grid are extrapolated using the first or last parabola.
+ *  \warning The grid has to be sorted in ascending order!
+ */
+
+class SplineTable __final
+{
+public:
+    SplineTable() : origin_(0.0), bucketWidth_(0.0) {}
+    /*! \brief Constructor from grid and function values
+     *  \param[in] grid     holds points on grid where function is known
+     *  \param[in] function holds known function values
+     */
+    SplineTable(const std::vector<double> & grid, const std::vector<double> & function)
+        : grid_(grid)
+    {
+        int nPoints = grid_.size();
+        if (nPoints < 3) PCMSOLVER_ERROR("At least 3 grid points are needed for the spline table!");
+        if (function.size() != grid_.size()) PCMSOLVER_ERROR("Grid and function values have different sizes!");
+        int nIntervals = nPoints - 1;
+        // Parabola through x_{c-1}, x_c, x_{c+1} in Newton form, centered in x_c:
+        // p(x) = y_c + t * (b + a * t), t = x - x_c
+        coefficients_.resize(4, nIntervals);
+        for (int k = 0; k < nIntervals; ++k) {
+            int c = std::max(1, std::min(k, nPoints - 2));
+            double h1 = grid_[c] - grid_[c-1], h2 = grid_[c+1] - grid_[c];
+            double d1 = (function[c] - function[c-1]) / h1;
+            double d2 = (function[c+1] - function[c]) / h2;
+            double a = (d2 - d1) / (h1 + h2);
+            coefficients_.col(k) << grid_[c], function[c], d1 + a * h1, a;
+        }
+        // Uniform buckets spanning the grid, each one stores the index of the
+        // interval containing its left end
+        origin_ = grid_.front();
+        bucketWidth_ = (grid_.back() - grid_.front()) / nIntervals;
+        buckets_.resize(nIntervals);
+        int k = 0;
+        for (int b = 0; b < nIntervals; ++b) {
+            double left = origin_ + b * bucketWidth_;
+            while (k < nIntervals - 1 && grid_[k + 1] < left) ++k;
+            buckets_[b] = k;
+        }
+    }
+    /*! \brief Evaluate interpolant at given point
+     *  \param[in] point evaluation point
+     */
+    double operator()(double point) const {
+        const Eigen::Vector4d & c = coefficients_.col(interval(point));
+        double t = point - c(0);
+        return c(1) + t * (c(2) + c(3) * t);
+    }
+private:
+    /*! Grid points */
+    std::vector<double> grid_;
+    /*! Center point, value, first and second order coefficients of the parabola on each interval */
+    Eigen::Matrix4Xd coefficients_;
+    /*! First grid point */
+    double origin_;
+    /*! Width of the buckets */
+    double bucketWidth_;
+    /*! Index of the interval containing the left end of each bucket */
+    std::vector<int> buckets_;
+    /*! \brief Returns the index k of the interval such that x_k < point <= x_{k+1}
+     *  \param[in] point evaluation point
+     */
+    int interval(double point) const {
+        int nIntervals = buckets_.size();
+        int b = std::max(0, std::min(static_cast<int>((point - origin_) / bucketWidth_), nIntervals - 1));
+        int k = buckets_[b];
+        while (k < nIntervals - 1 && grid_[k + 1] < point) ++k;
+        return k;
+    }
+};
+
+#endif // SPLINETABLE_HPP
@@ -30,23 +30,32 @@
 #include <string>
 #include <utility>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif /* _WIN32 */
+
 #include "Cxx11Workarounds.hpp"
 
 #include <boost/container/flat_map.hpp>
 #include <boost/foreach.hpp>
 
 namespace timer {
-  typedef pcm::tuple<double, double> timing;
+  typedef pcm::tuple<double, double, double> timing;
   typedef boost::container::flat_map<std::string, timing> TimingsMap;
   typedef std::pair<std::string, timing> TimingsPair;
 
   timing get_timing();
   double get_wall_time();
   double get_cpu_time();
+  double get_peak_memory();
 
   /*! \file Timer.hpp
    *  \class Timer
    *  \brief A wrapper around the basic C standard library timing facilities
+   *
+   *  Together with the wall and CPU times, the peak resident memory of the
+   *  process at the end of each checkpoint is recorded. This is a high-water
+   *  mark: it includes the memory used by all the checkpoints before.
    *  \author Roberto Di Remigio
    *  \date 2015
    */
@@ -64,6 +73,7 @@ namespace timer {
           os << "Function:  " <<t_pair.first << std::endl;
           os << "   Wall time: " << pcm::get<0>(t_pair.second) << " ms" << std::endl;
           os << "   CPU time:  " << pcm::get<1>(t_pair.second) << " ms" << std::endl;
+          os << "   Peak memory: " << pcm::get<2>(t_pair.second) << " MB" << std::endl;
         }
         os << "----------------------------------------------------" << std::endl;
         return os;
@@ -91,7 +101,7 @@ namespace timer {
       void registerElapsed(const std::string & chkpt_name, timing t_stop) {
         double wall_elapsed = pcm::get<0>(t_stop) - pcm::get<0>(timings_[chkpt_name]);
         double cpu_elapsed = pcm::get<1>(t_stop) - pcm::get<1>(timings_[chkpt_name]);
-        timings_[chkpt_name] = pcm::make_tuple(wall_elapsed, cpu_elapsed);
+        timings_[chkpt_name] = pcm::make_tuple(wall_elapsed, cpu_elapsed, pcm::get<2>(t_stop));
       }
   };
 
@@ -130,10 +140,10 @@ namespace timer {
     timing_report.close();
   }
 
-  /*! Returns wall and CPU times in milliseconds */
+  /*! Returns wall and CPU times in milliseconds and peak memory in megabytes */
   inline timing get_timing()
   {
-    return pcm::make_tuple(get_wall_time() / 1000.0, get_cpu_time() / 1000.0);
+    return pcm::make_tuple(get_wall_time() / 1000.0, get_cpu_time() / 1000.0, get_peak_memory());
   }
 
 // This code was taken from:
@@ -168,6 +178,11 @@ namespace timer {
       return 0;
     }
   }
+  inline double get_peak_memory()
+  {
+    // Not available without linking to psapi
+    return 0;
+  }
 #else /* _WIN32 */
 #include <time.h>
 #include <sys/time.h>
@@ -186,6 +201,22 @@ namespace timer {
   {
     return (double)clock() / CLOCKS_PER_SEC;
   }
+
+  inline double get_peak_memory()
+  {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)) {
+      //  Handle error
+      return 0;
+    }
+#ifdef __APPLE__
+    // Bytes on OS X
+    return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    // Kilobytes on Linux
+    return (double)usage.ru_maxrss / 1024.0;
+#endif
+  }
 #endif /* _WIN32 */
 } // namespace timer
 
@@ -10,6 +10,10 @@
 #include <cstdlib>
 #include <cstring>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
 char cnpy::BigEndianTest()
 {
     unsigned char x[] = {1, 0};
@@ -72,6 +76,11 @@ void cnpy::parse_npy_header(FILE * fp, unsigned int & word_size, unsigned int *&
     std::string header = fgets(buffer, 256, fp);
     assert(header[header.size()-1] == '\n');
 
+    parse_npy_dict(header, word_size, shape, ndims, fortran_order);
+}
+
+void cnpy::parse_npy_dict(const std::string & header, unsigned int & word_size, unsigned int *& shape, unsigned int & ndims, bool & fortran_order)
+{
     int loc1, loc2;
 
     //fortran order
@@ -106,6 +115,122 @@ void cnpy::parse_npy_header(FILE * fp, unsigned int & word_size, unsigned int *&
     word_size = atoi(str_ws.substr(0,loc2).c_str());
 }
 
+cnpy::NpyArray cnpy::parse_npy_buffer(mapped_file_t & file, const char * npy, size_t nbytes)
+{
+    //magic string, version and length of the header dictionary (format version 1.0)
+    if (nbytes < 10 || std::memcmp(npy + 1, "NUMPY", 5) != 0)
+        throw std::runtime_error("parse_npy_buffer: not a .npy array");
+    unsigned short dict_len = *(const unsigned short*) &npy[8];
+    if (nbytes < 10u + dict_len)
+        throw std::runtime_error("parse_npy_buffer: truncated header");
+    std::string header(npy + 10, dict_len);
+
+    unsigned int* shape;
+    unsigned int ndims, word_size;
+    bool fortran_order;
+    parse_npy_dict(header, word_size, shape, ndims, fortran_order);
+    unsigned long long size = 1;
+    for(unsigned int i = 0; i < ndims; ++i) size *= shape[i];
+
+    NpyArray arr;
+    arr.word_size = word_size;
+    arr.shape = std::vector<unsigned int>(shape, shape+ndims);
+    arr.fortran_order = fortran_order;
+    delete[] shape;
+    if (nbytes < 10u + dict_len + size*word_size)
+        throw std::runtime_error("parse_npy_buffer: truncated data");
+    arr.data = file.aligned(npy + 10 + dict_len, size*word_size, word_size);
+    return arr;
+}
+
+cnpy::mapped_file_t::mapped_file_t(std::string fname)
+    : begin_(NULL), length_(0), mapped_(false)
+{
+    FILE * fp = fopen(fname.c_str(), "rb");
+    if (!fp) {
+        printf("mapped_file_t: Error! Unable to open file %s!\n", fname.c_str());
+        abort();
+    }
+    fseek(fp, 0, SEEK_END);
+    length_ = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+#if defined(__unix__) || defined(__APPLE__)
+    if (length_ > 0) {
+        void * mapping = mmap(NULL, length_, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (mapping != MAP_FAILED) {
+            begin_ = static_cast<char *>(mapping);
+            mapped_ = true;
+        }
+    }
+#endif
+    if (!mapped_) {
+        begin_ = new char[length_];
+        size_t nread = fread(begin_, sizeof(char), length_, fp);
+        if (nread != length_) {
+            delete[] begin_;
+            fclose(fp);
+            throw std::runtime_error("mapped_file_t: failed fread");
+        }
+    }
+    fclose(fp);
+}
+
+cnpy::mapped_file_t::~mapped_file_t()
+{
+    for (size_t i = 0; i < copies_.size(); ++i) delete[] copies_[i];
+#if defined(__unix__) || defined(__APPLE__)
+    if (mapped_) munmap(begin_, length_);
+#endif
+    if (!mapped_) delete[] begin_;
+}
+
+char * cnpy::mapped_file_t::aligned(const char * data, size_t nbytes, unsigned int word_size)
+{
+    if (word_size == 0 || reinterpret_cast<size_t>(data) % word_size == 0) return const_cast<char *>(data);
+    char * copy = new char[nbytes];
+    std::memcpy(copy, data, nbytes);
+    copies_.push_back(copy);
+    return copy;
+}
+
+cnpy::npz_mmap_t::npz_mmap_t(std::string fname)
+    : file_(fname)
+{
+    const char * begin = file_.begin();
+    size_t length = file_.length();
+    size_t offset = 0;
+    while (offset + 30 <= length) {
+        const char * local_header = begin + offset;
+        //if we've reached the global header, stop reading
+        if (local_header[2] != 0x03 || local_header[3] != 0x04) break;
+        unsigned short compression = *(const unsigned short*) &local_header[8];
+        if (compression != 0)
+            throw std::runtime_error("npz_mmap_t: compressed archives are not supported");
+        unsigned int nbytes = *(const unsigned int*) &local_header[18];
+        unsigned short name_len = *(const unsigned short*) &local_header[26];
+        unsigned short extra_field_len = *(const unsigned short*) &local_header[28];
+        //erase the lagging .npy
+        std::string varname(local_header + 30, name_len);
+        varname.erase(varname.end()-4, varname.end());
+
+        size_t data_offset = offset + 30 + name_len + extra_field_len;
+        if (data_offset + nbytes > length)
+            throw std::runtime_error("npz_mmap_t: truncated archive");
+        (*this)[varname] = parse_npy_buffer(file_, begin + data_offset, nbytes);
+        offset = data_offset + nbytes;
+    }
+}
+
+cnpy::npy_mmap_t::npy_mmap_t(std::string fname)
+    : file_(fname)
+{
+    NpyArray arr = parse_npy_buffer(file_, file_.begin(), file_.length());
+    data = arr.data;
+    shape = arr.shape;
+    word_size = arr.word_size;
+    fortran_order = arr.fortran_order;
+}
+
 void cnpy::parse_zip_footer(FILE * fp, unsigned short & nrecs,
                             unsigned int & global_header_size, unsigned int & global_header_offset)
 {
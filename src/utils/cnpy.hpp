@@ -37,12 +37,55 @@ namespace cnpy
         }
     };
 
+    /*! Read-only memory mapping of a file. Falls back to reading the file
+     *  into a heap buffer where memory mapping is not available. */
+    class mapped_file_t
+    {
+    public:
+        mapped_file_t(std::string fname);
+        ~mapped_file_t();
+        const char * begin() const { return begin_; }
+        size_t length() const { return length_; }
+        /*! Returns a pointer to the data of an array, copied to the heap
+         *  only if it is not aligned to its word size in the mapping */
+        char * aligned(const char * data, size_t nbytes, unsigned int word_size);
+    private:
+        char * begin_;
+        size_t length_;
+        bool mapped_;
+        std::vector<char *> copies_;
+        mapped_file_t(const mapped_file_t &);
+        mapped_file_t & operator=(const mapped_file_t &);
+    };
+
+    /*! Memory-mapped .npz file. The data of the arrays points into the mapping,
+     *  it is valid for the lifetime of the object and must not be destructed.
+     *  Only uncompressed (stored) archives, as written by npz_save, are supported. */
+    struct npz_mmap_t : public std::map<std::string, NpyArray>
+    {
+        npz_mmap_t(std::string fname);
+    private:
+        mapped_file_t file_;
+    };
+
+    /*! Memory-mapped .npy file. The data of the array points into the mapping,
+     *  it is valid for the lifetime of the object and must not be destructed. */
+    struct npy_mmap_t : public NpyArray
+    {
+        npy_mmap_t(std::string fname);
+    private:
+        mapped_file_t file_;
+    };
+
     char BigEndianTest();
     char map_type(const std::type_info& t);
     template <typename T>
     std::vector<char> create_npy_header(const T* data, const unsigned int* shape, const unsigned int ndims, bool fortran_order = false);
     void parse_npy_header(FILE* fp,unsigned int& word_size, unsigned int*& shape,
                           unsigned int& ndims, bool& fortran_order);
+    void parse_npy_dict(const std::string& header, unsigned int& word_size, unsigned int*& shape,
+                        unsigned int& ndims, bool& fortran_order);
+    NpyArray parse_npy_buffer(mapped_file_t& file, const char* npy, size_t nbytes);
     void parse_zip_footer(FILE* fp, unsigned short& nrecs,
                           unsigned int& global_header_size, unsigned int& global_header_offset);
     npz_t npz_load(std::string fname);
@@ -201,6 +244,16 @@ namespace cnpy
                          global_header_offset; //relative offset of local file header, since it begins where the global header used to begin
         global_header += fname;
 
+        //pad the local header with an extra field, so that the array data is 16-byte aligned
+        //in the file and can be used in place when memory-mapped. The central directory has no extra field
+        size_t data_offset = global_header_offset + local_header.size() + 4 + npy_header.size();
+        unsigned short padding = (16 - data_offset % 16) % 16;
+        local_header[28] = (char) (4 + padding);
+        local_header[29] = 0;
+        local_header += (unsigned short) 0x706e; //extra field header id
+        local_header += (unsigned short) padding; //extra field data size
+        local_header.insert(local_header.end(), padding, 0);
+
         //build footer
         std::vector<char> footer;
         footer += "PK"; //first part of sig
@@ -81,6 +81,30 @@ int main()
   pcmsolver_compute_asc(pcm_context, mep_lbl, asc_B3g_lbl, irrep);
   pcmsolver_get_surface_function(pcm_context, grid_size, asc_B3g, asc_B3g_lbl);
 
+  // Batched ASCs in Ag symmetry, for the MEP and twice the MEP.
+  // The ASCs should be the same as asc_Ag and twice asc_Ag
+  double * meps = (double *) calloc(2*grid_size, sizeof(double));
+  double * ascs = (double *) calloc(2*grid_size, sizeof(double));
+  for (size_t i = 0; i < grid_size; ++i) {
+    meps[i] = mep[i];
+    meps[grid_size + i] = 2.0 * mep[i];
+  }
+  irrep = 0;
+  pcmsolver_compute_ascs(pcm_context, 2, meps, ascs, irrep);
+
+  // ASC in Ag symmetry using registered buffers.
+  // Should be the same as asc_Ag
+  double * asc_buffer = (double *) calloc(grid_size, sizeof(double));
+  if (grid_size == 0 || !asc_buffer) {
+    fprintf(stderr, "%s\n", "Unable to allocate the buffer for the ASC");
+    exit(EXIT_FAILURE);
+  }
+  int mep_handle = pcmsolver_register_buffer(pcm_context, grid_size, mep);
+  int asc_handle = pcmsolver_register_buffer(pcm_context, grid_size, asc_buffer);
+  irrep = 0;
+  pcmsolver_compute_asc_buffers(pcm_context, mep_handle, asc_handle, irrep);
+  double energy_buffers = pcmsolver_compute_polarization_energy_buffers(pcm_context, mep_handle, asc_handle);
+
   // Check that everything calculated is OK
   // Cavity size
   const size_t ref_size = 576;
@@ -106,9 +130,47 @@ int main()
   } else {
     fprintf(output, "%s\n", "Test on polarization energy: PASSED");
   }
+  // Batched ASCs
+  for (size_t i = 0; i < grid_size; ++i) {
+    if (!check_unsigned_error(ascs[i], asc_Ag[i], 1.0e-10) ||
+        !check_unsigned_error(ascs[grid_size + i], 2.0 * asc_Ag[i], 1.0e-10)) {
+      fprintf(stderr, "%s\n", "Error in the batched ASCs, please file an issue on: https://github.com/PCMSolver/pcmsolver");
+      exit(EXIT_FAILURE);
+    }
+  }
+  fprintf(output, "%s\n", "Test on batched ASCs: PASSED");
+  // Registered buffers
+  for (size_t i = 0; i < grid_size; ++i) {
+    if (!check_unsigned_error(asc_buffer[i], asc_Ag[i], 1.0e-10)) {
+      fprintf(stderr, "%s\n", "Error in the ASC computed using registered buffers, please file an issue on: https://github.com/PCMSolver/pcmsolver");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (!check_unsigned_error(energy_buffers, energy, 1.0e-10)) {
+    fprintf(stderr, "%s\n", "Error in the polarization energy computed using registered buffers, please file an issue on: https://github.com/PCMSolver/pcmsolver");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(output, "%s\n", "Test on registered buffers: PASSED");
   // Surface functions
   test_surface_functions(output, grid_size, mep, asc_Ag, asc_B3g, asc_neq_B3g);
 
+  // Update to the same geometry.
+  // The cavity and the polarization energy should be the same
+  pcmsolver_update_geometry(pcm_context, NR_NUCLEI, charges, coordinates);
+  if (pcmsolver_get_cavity_size(pcm_context) != grid_size) {
+    fprintf(stderr, "%s\n", "Error in the cavity size after the geometry update, please file an issue on: https://github.com/PCMSolver/pcmsolver");
+    exit(EXIT_FAILURE);
+  }
+  pcmsolver_set_surface_function(pcm_context, grid_size, mep, mep_lbl);
+  irrep = 0;
+  pcmsolver_compute_asc(pcm_context, mep_lbl, asc_lbl, irrep);
+  double energy_update = pcmsolver_compute_polarization_energy(pcm_context, mep_lbl, asc_lbl);
+  if (!check_unsigned_error(energy_update, energy, 1.0e-10)) {
+    fprintf(stderr, "%s\n", "Error in the polarization energy after the geometry update, please file an issue on: https://github.com/PCMSolver/pcmsolver");
+    exit(EXIT_FAILURE);
+  }
+  fprintf(output, "%s\n", "Test on geometry update: PASSED");
+
   pcmsolver_write_timings(pcm_context);
 
   pcmsolver_delete(pcm_context);
@@ -118,6 +180,9 @@ int main()
   free(asc_Ag);
   free(asc_B3g);
   free(asc_neq_B3g);
+  free(meps);
+  free(asc_buffer);
+  free(ascs);
 
   fclose(output);
 
@@ -0,0 +1,102 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <iostream>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "HMatrix.hpp"
+#include "Molecule.hpp"
+#include "TestingMolecules.hpp"
+#include "Vacuum.hpp"
+
+namespace
+{
+    /*! Matrix elements read from a dense matrix */
+    struct DenseEntry
+    {
+        explicit DenseEntry(const Eigen::MatrixXd & matrix) : matrix_(matrix) {}
+        double operator()(int i, int j) const { return matrix_(i, j); }
+        const Eigen::MatrixXd & matrix_;
+    };
+}
+
+SCENARIO("Hierarchical matrix compression of the collocation S and D operators", "[bi_operators][bi_operators_hmatrix]")
+{
+    GIVEN("A GePol cavity for a single sphere in the origin and a random vector")
+    {
+        Molecule point = dummy<0>(2.929075493);
+        double area = 0.2;
+        GePolCavity cavity = GePolCavity(point, area, 0.0, 100.0);
+        Eigen::VectorXd x = Eigen::VectorXd::Random(cavity.size());
+
+        Vacuum<AD_directional, CollocationIntegrator> vacuum = Vacuum<AD_directional, CollocationIntegrator>();
+        Eigen::MatrixXd S = vacuum.singleLayer(cavity.elements());
+        Eigen::MatrixXd D = vacuum.doubleLayer(cavity.elements());
+        Eigen::VectorXd Sx = S * x;
+        Eigen::VectorXd Dx = D * x;
+
+        /*! \class HMatrix
+         *  \test \b HMatrixTest_vacuum tests the hierarchical matrices against the collocation S and D matrices in vacuum
+         */
+        WHEN("the tolerance of the cross approximation is decreased")
+        {
+            double tolerances[] = {1.0e-03, 1.0e-06};
+            double errorS[2], errorD[2];
+            size_t storage[2];
+            for (int i = 0; i < 2; ++i) {
+                HMatrix hS(cavity.elementCenter(), DenseEntry(S), tolerances[i]);
+                HMatrix hD(cavity.elementCenter(), DenseEntry(D), tolerances[i]);
+                errorS[i] = (hS.apply(x) - Sx).norm() / Sx.norm();
+                errorD[i] = (hD.apply(x) - Dx).norm() / Dx.norm();
+                storage[i] = hS.storage();
+                REQUIRE(hS.lowRankBlocks() > 0);
+                REQUIRE(hS.storage() < hS.denseStorage());
+                REQUIRE(hD.storage() < hD.denseStorage());
+            }
+            THEN("the action of the operators converges to the one of the matrices")
+            {
+                CAPTURE(errorS[0]);
+                CAPTURE(errorS[1]);
+                CAPTURE(errorD[0]);
+                CAPTURE(errorD[1]);
+                REQUIRE(errorS[1] < errorS[0]);
+                REQUIRE(errorD[1] < errorD[0]);
+                REQUIRE(errorS[0] < 1.0e-03);
+                REQUIRE(errorD[0] < 1.0e-03);
+                REQUIRE(errorS[1] < 1.0e-06);
+                REQUIRE(errorD[1] < 1.0e-06);
+                REQUIRE(storage[1] > storage[0]);
+            }
+        }
+    }
+}
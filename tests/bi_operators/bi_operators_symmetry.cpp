@@ -0,0 +1,106 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "MathUtils.hpp"
+#include "Molecule.hpp"
+#include "PurisimaIntegrator.hpp"
+#include "TestingMolecules.hpp"
+#include "UniformDielectric.hpp"
+#include "Vacuum.hpp"
+
+SCENARIO("Symmetry blocked S and D operators from the irreducible rows", "[bi_operators][bi_operators_symmetry]")
+{
+    GIVEN("A GePol cavity for C2H4 in D2h symmetry")
+    {
+        Molecule molec = C2H4();
+        double area = 0.2 / convertBohr2ToAngstrom2;
+        double probeRadius = 1.385 / convertBohrToAngstrom;
+        double minRadius = 100.0 / convertBohrToAngstrom;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius, "symmetry_rows");
+        size_t size = cavity.size();
+        int ntsirr = cavity.irreducible_size();
+        int nrBlocks = cavity.pointGroup().nrIrrep();
+
+        /*! \class CollocationIntegrator
+         *  \test \b SymmetryRowsTest_collocation tests the symmetry blocking of S and D built from the irreducible rows
+         */
+        WHEN("the operators are computed by collocation in vacuum")
+        {
+            Vacuum<AD_directional, CollocationIntegrator> gf = Vacuum<AD_directional, CollocationIntegrator>();
+            Eigen::MatrixXd S = gf.singleLayer(cavity.elements());
+            Eigen::MatrixXd D = gf.doubleLayer(cavity.elements());
+            Eigen::MatrixXd S_rows = gf.singleLayer(cavity.elements(), ntsirr);
+            Eigen::MatrixXd D_rows = gf.doubleLayer(cavity.elements(), ntsirr);
+            THEN("the irreducible rows coincide with those of the full operators")
+            {
+                REQUIRE(S_rows.rows() == ntsirr);
+                REQUIRE(S_rows.cols() == static_cast<int>(size));
+                REQUIRE(S_rows.isApprox(S.topRows(ntsirr), 1.0e-12));
+                REQUIRE(D_rows.isApprox(D.topRows(ntsirr), 1.0e-12));
+            }
+            AND_THEN("the symmetry blocked operators coincide with those from the full operators")
+            {
+                symmetryBlocking(S, size, ntsirr, nrBlocks);
+                symmetryBlocking(D, size, ntsirr, nrBlocks);
+                Eigen::MatrixXd S_blocked = symmetryBlockingFromRows(S_rows, ntsirr, nrBlocks);
+                Eigen::MatrixXd D_blocked = symmetryBlockingFromRows(D_rows, ntsirr, nrBlocks);
+                REQUIRE(S_blocked.isApprox(S, 1.0e-10));
+                REQUIRE(D_blocked.isApprox(D, 1.0e-10));
+            }
+        }
+
+        /*! \class PurisimaIntegrator
+         *  \test \b SymmetryRowsTest_purisima tests the symmetry blocking of S and D built from the irreducible rows
+         */
+        WHEN("the operators are computed by Purisima's method in a uniform dielectric")
+        {
+            double permittivity = 78.39;
+            UniformDielectric<AD_directional, PurisimaIntegrator> gf =
+                UniformDielectric<AD_directional, PurisimaIntegrator>(permittivity);
+            Eigen::MatrixXd S = gf.singleLayer(cavity.elements());
+            Eigen::MatrixXd D = gf.doubleLayer(cavity.elements());
+            Eigen::MatrixXd S_rows = gf.singleLayer(cavity.elements(), ntsirr);
+            Eigen::MatrixXd D_rows = gf.doubleLayer(cavity.elements(), ntsirr);
+            THEN("the symmetry blocked operators coincide with those from the full operators")
+            {
+                REQUIRE(S_rows.isApprox(S.topRows(ntsirr), 1.0e-12));
+                REQUIRE(D_rows.isApprox(D.topRows(ntsirr), 1.0e-12));
+                symmetryBlocking(S, size, ntsirr, nrBlocks);
+                symmetryBlocking(D, size, ntsirr, nrBlocks);
+                REQUIRE(symmetryBlockingFromRows(S_rows, ntsirr, nrBlocks).isApprox(S, 1.0e-10));
+                REQUIRE(symmetryBlockingFromRows(D_rows, ntsirr, nrBlocks).isApprox(D, 1.0e-10));
+            }
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "DerivativeTypes.hpp"
+#include "Element.hpp"
+#include "GePolCavity.hpp"
+#include "IntegratorHelperFunctions.hpp"
+#include "Molecule.hpp"
+#include "TestingMolecules.hpp"
+
+namespace
+{
+    double coulomb(const Eigen::Vector3d & source, const Eigen::Vector3d & probe)
+    {
+        return 1.0 / (source - probe).norm();
+    }
+
+    /*! Not symmetric: reveals which triangle was evaluated */
+    double asymmetric(const Eigen::Vector3d & source, const Eigen::Vector3d & probe)
+    {
+        return source(0) - 2.0 * probe(0);
+    }
+
+    double diagonal(const Element & e)
+    {
+        return e.area();
+    }
+
+    double failingDiagonal(const Element & /* e */)
+    {
+        throw std::runtime_error("Failing diagonal");
+    }
+
+    /*! Stand-ins for the types of Green's functions with and without a symmetric kernel */
+    struct SymmetricGreensFunction {};
+    struct GeneralGreensFunction {};
+}
+
+template <>
+struct SymmetricKernel<SymmetricGreensFunction>
+{
+    static const bool value = true;
+};
+
+SCENARIO("Tiled assembly of the collocation S matrix", "[bi_operators][bi_operators_tiled-assembly]")
+{
+    GIVEN("A GePol cavity spanning several tiles")
+    {
+        Molecule molec = NH3();
+        GePolCavity cavity = GePolCavity(molec, 0.4, 1.385, 0.2);
+        std::vector<Element> elements = cavity.elements();
+        size_t size = elements.size();
+        REQUIRE(size > 2 * integrator::tileSize);
+        // A number of rows that is not a multiple of the tile size
+        size_t nRows = integrator::tileSize + 13;
+
+        WHEN("the general assembly is used")
+        {
+            Eigen::MatrixXd S = integrator::singleLayer(elements, diagonal, asymmetric, nRows);
+            THEN("every element is evaluated from the kernel")
+            {
+                REQUIRE(S.rows() == static_cast<int>(nRows));
+                REQUIRE(S.cols() == static_cast<int>(size));
+                for (size_t j = 0; j < size; ++j) {
+                    for (size_t i = 0; i < nRows; ++i) {
+                        double ref = (i == j) ? diagonal(elements[i]) : asymmetric(elements[i].center(), elements[j].center());
+                        REQUIRE(S(i, j) == ref);
+                    }
+                }
+            }
+        }
+
+        AND_WHEN("the assembly for a symmetric kernel is used")
+        {
+            Eigen::MatrixXd S = integrator::singleLayerSymmetric(elements, diagonal, asymmetric, nRows);
+            THEN("only the upper triangle is evaluated from the kernel")
+            {
+                for (size_t j = 0; j < size; ++j) {
+                    for (size_t i = 0; i < nRows; ++i) {
+                        double ref = 0.0;
+                        if (i == j) {
+                            ref = diagonal(elements[i]);
+                        } else if (i < j) {
+                            ref = asymmetric(elements[i].center(), elements[j].center());
+                        } else {
+                            ref = asymmetric(elements[j].center(), elements[i].center());
+                        }
+                        REQUIRE(S(i, j) == ref);
+                    }
+                }
+            }
+        }
+
+        AND_WHEN("the assembly is selected by the type of the Green's function")
+        {
+            Eigen::MatrixXd S_symmetric = integrator::singleLayer(SymmetricGreensFunction(), elements, diagonal, asymmetric, nRows);
+            Eigen::MatrixXd S_general = integrator::singleLayer(GeneralGreensFunction(), elements, diagonal, asymmetric, nRows);
+            THEN("only one triangle is evaluated for the symmetric kernel")
+            {
+                REQUIRE(S_symmetric == integrator::singleLayerSymmetric(elements, diagonal, asymmetric, nRows));
+                REQUIRE(S_general == integrator::singleLayer(elements, diagonal, asymmetric, nRows));
+            }
+        }
+
+        AND_WHEN("the Coulomb kernel is evaluated in batches")
+        {
+            Eigen::MatrixXd S_coulomb = integrator::singleLayerCoulomb(elements, diagonal, 1.0, size);
+            Eigen::MatrixXd S_symmetric = integrator::singleLayerSymmetric(elements, diagonal, coulomb, size);
+            Eigen::MatrixXd S_general = integrator::singleLayer(elements, diagonal, coulomb, size);
+            THEN("all the assemblies agree and the matrix is symmetric")
+            {
+                REQUIRE(S_coulomb == S_coulomb.transpose());
+                REQUIRE(S_symmetric == S_symmetric.transpose());
+                REQUIRE((S_coulomb - S_general).norm() <= 1.0e-14 * S_general.norm());
+                REQUIRE((S_symmetric - S_general).norm() <= 1.0e-14 * S_general.norm());
+            }
+        }
+
+        AND_WHEN("the evaluation of the diagonal fails in the parallel assembly")
+        {
+            THEN("the error is raised after the parallel region")
+            {
+                REQUIRE_THROWS(integrator::singleLayer(elements, failingDiagonal, coulomb, size));
+                REQUIRE_THROWS(integrator::singleLayerSymmetric(elements, failingDiagonal, coulomb, size));
+                REQUIRE_THROWS(integrator::singleLayerCoulomb(elements, failingDiagonal, 1.0, size));
+            }
+        }
+    }
+}
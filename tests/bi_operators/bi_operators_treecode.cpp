@@ -0,0 +1,110 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <iostream>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "Molecule.hpp"
+#include "TestingMolecules.hpp"
+#include "Treecode.hpp"
+#include "UniformDielectric.hpp"
+#include "Vacuum.hpp"
+
+SCENARIO("A treecode for the action of the collocation S and D operators", "[bi_operators][bi_operators_treecode]")
+{
+    GIVEN("A GePol cavity for a single sphere in the origin and a random vector")
+    {
+        Molecule point = dummy<0>(2.929075493);
+        double area = 0.2;
+        GePolCavity cavity = GePolCavity(point, area, 0.0, 100.0);
+        size_t size = cavity.size();
+        Eigen::Matrix3Xd normals = cavity.elementNormal();
+        normals.colwise().normalize();
+        Eigen::VectorXd x = Eigen::VectorXd::Random(size);
+
+        Vacuum<AD_directional, CollocationIntegrator> vacuum = Vacuum<AD_directional, CollocationIntegrator>();
+        Eigen::MatrixXd S = vacuum.singleLayer(cavity.elements());
+        Eigen::MatrixXd D = vacuum.doubleLayer(cavity.elements());
+        // Only the off-diagonal part is computed by the treecode
+        S.diagonal().setZero();
+        D.diagonal().setZero();
+        Eigen::VectorXd Sx = S * x;
+        Eigen::VectorXd Dx = D * x;
+
+        /*! \class Treecode
+         *  \test \b TreecodeTest_vacuum tests the treecode against the collocation S and D matrices in vacuum
+         */
+        WHEN("the opening angle is decreased")
+        {
+            double thetas[] = {0.7, 0.45};
+            double errorS[2], errorD[2];
+            for (int i = 0; i < 2; ++i) {
+                Treecode tree(cavity.elementCenter(), thetas[i], 4, 8);
+                Eigen::VectorXd treeSx = tree.potential(x, Eigen::Matrix3Xd::Zero(3, size));
+                Eigen::VectorXd treeDx = tree.potential(Eigen::VectorXd::Zero(size), normals * x.asDiagonal());
+                errorS[i] = (treeSx - Sx).norm() / Sx.norm();
+                errorD[i] = (treeDx - Dx).norm() / Dx.norm();
+            }
+            THEN("the action of the operators converges to the one of the matrices")
+            {
+                CAPTURE(errorS[0]);
+                CAPTURE(errorS[1]);
+                CAPTURE(errorD[0]);
+                CAPTURE(errorD[1]);
+                REQUIRE(errorS[1] < errorS[0]);
+                REQUIRE(errorD[1] < errorD[0]);
+                REQUIRE(errorS[1] < 5.0e-04);
+                REQUIRE(errorD[1] < 1.0e-02);
+            }
+        }
+
+        /*! \class Treecode
+         *  \test \b TreecodeTest_uniformdielectric tests the treecode against the collocation S matrix in a uniform dielectric
+         */
+        WHEN("the kernel is scaled by the permittivity")
+        {
+            double permittivity = 78.39;
+            UniformDielectric<AD_directional, CollocationIntegrator> uniform =
+                UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+            Eigen::MatrixXd S_uniform = uniform.singleLayer(cavity.elements());
+            S_uniform.diagonal().setZero();
+            Treecode tree(cavity.elementCenter(), 0.45, 4, 8);
+            Eigen::VectorXd treeSx = tree.potential(x, Eigen::Matrix3Xd::Zero(3, size)) / permittivity;
+            THEN("the action of the S operator is recovered")
+            {
+                Eigen::VectorXd ref = S_uniform * x;
+                REQUIRE((treeSx - ref).norm() / ref.norm() < 5.0e-04);
+            }
+        }
+    }
+}
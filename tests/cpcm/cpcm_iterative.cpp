@@ -0,0 +1,123 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <iostream>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "Molecule.hpp"
+#include "Vacuum.hpp"
+#include "UniformDielectric.hpp"
+#include "CPCMSolver.hpp"
+#include "IterativeSolver.hpp"
+#include "TestingMolecules.hpp"
+
+SCENARIO("Test the matrix-free solver for the C-PCM for a point charge and a GePol cavity", "[solver][cpcm][cpcm_iterative]")
+{
+    GIVEN("An isotropic environment and a point charge")
+    {
+        double permittivity = 78.39;
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+        double threshold = 1.0e-12;
+        int maxIterations = 200;
+        double correction = 0.5;
+
+        double charge = 8.0;
+        double totalASC = - charge * (permittivity - 1) / (permittivity + correction);
+
+        /*! \class IterativeSolver
+         *  \test \b pointChargeGePolC1 tests IterativeSolver using a point charge with a GePol cavity in C1 symmetry
+         */
+        WHEN("the point group is C1")
+        {
+            Molecule point = dummy<0>(2.929075493);
+            double area = 0.4;
+            double probeRadius = 0.0;
+            double minRadius = 100.0;
+            GePolCavity cavity(point, area, probeRadius, minRadius, "C1");
+
+            Eigen::VectorXd fake_mep = computeMEP(cavity.elements(), charge);
+
+            CPCMSolver reference(false, correction);
+            reference.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IterativeSolver solver(true, correction, threshold, maxIterations);
+            solver.buildSystemMatrix(cavity, gfInside, gfOutside);
+            THEN("the apparent surface charge matches the one from the PCM matrix")
+            {
+                Eigen::VectorXd ref_asc = reference.computeCharge(fake_mep);
+                Eigen::VectorXd fake_asc = solver.computeCharge(fake_mep);
+                double relativeError = (fake_asc - ref_asc).norm() / ref_asc.norm();
+                CAPTURE(relativeError);
+                REQUIRE(relativeError < 1.0e-08);
+                double totalFakeASC = fake_asc.sum();
+                CAPTURE(totalASC - totalFakeASC);
+                REQUIRE(totalASC == Approx(totalFakeASC).epsilon(1.0e-03));
+                // Second call is warm started from the previous solution
+                Eigen::VectorXd restarted_asc = solver.computeCharge(fake_mep);
+                REQUIRE((restarted_asc - fake_asc).norm() / fake_asc.norm() < 1.0e-08);
+            }
+        }
+
+        /*! \class IterativeSolver
+         *  \test \b pointChargeGePolD2h tests IterativeSolver using a point charge with a GePol cavity in D2h symmetry
+         */
+        WHEN("the point group is D2h")
+        {
+            Molecule point = dummy<7>(2.929075493);
+            double area = 0.4;
+            double probeRadius = 0.0;
+            double minRadius = 100.0;
+            GePolCavity cavity(point, area, probeRadius, minRadius, "D2h");
+
+            Eigen::VectorXd fake_mep = computeMEP(cavity.elements(), charge);
+
+            CPCMSolver reference(false, correction);
+            reference.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IterativeSolver solver(true, correction, threshold, maxIterations);
+            solver.buildSystemMatrix(cavity, gfInside, gfOutside);
+            THEN("the apparent surface charge matches the one from the PCM matrix")
+            {
+                Eigen::VectorXd ref_asc = reference.computeCharge(fake_mep);
+                Eigen::VectorXd fake_asc = solver.computeCharge(fake_mep);
+                double relativeError = (fake_asc - ref_asc).norm() / ref_asc.norm();
+                CAPTURE(relativeError);
+                REQUIRE(relativeError < 1.0e-08);
+                int nr_irrep = cavity.pointGroup().nrIrrep();
+                double totalFakeASC = fake_asc.sum() * nr_irrep;
+                CAPTURE(totalASC - totalFakeASC);
+                REQUIRE(totalASC == Approx(totalFakeASC).epsilon(1.0e-03));
+            }
+        }
+    }
+}
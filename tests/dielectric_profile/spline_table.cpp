@@ -0,0 +1,97 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "Config.hpp"
+
+#include "MathUtils.hpp"
+#include "SplineTable.hpp"
+
+SCENARIO("Piecewise quadratic interpolation tables", "[dielectric_profile][spline_table]")
+{
+    GIVEN("A function tabulated on a non-uniform grid")
+    {
+        // Grid spacing grows with the distance from the origin,
+        // as for the adaptive integration of the radial functions
+        std::vector<double> grid, function;
+        double r = 0.5, step = 1.0e-03;
+        while (r < 50.0) {
+            grid.push_back(r);
+            function.push_back(std::exp(-r / 5.0) * std::sin(r));
+            r += step;
+            step *= 1.05;
+        }
+        SplineTable table(grid, function);
+
+        /*! \class SplineTable
+         *  \test \b SplineTableTest_interpolation tests the interpolation table against splineInterpolation
+         */
+        WHEN("the function is interpolated between grid points")
+        {
+            THEN("the table reproduces the spline interpolation")
+            {
+                for (size_t k = 1; k < grid.size() - 1; ++k) {
+                    double points[] = {0.3 * grid[k] + 0.7 * grid[k+1], grid[k+1]};
+                    for (int i = 0; i < 2; ++i) {
+                        double reference = splineInterpolation(points[i], grid, function);
+                        CAPTURE(points[i]);
+                        REQUIRE(table(points[i]) == Approx(reference).epsilon(1.0e-10));
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("A parabola tabulated on a non-uniform grid")
+    {
+        std::vector<double> grid, function;
+        for (int i = 0; i < 20; ++i) {
+            double x = 1.0 + 0.1 * i * i;
+            grid.push_back(x);
+            function.push_back(2.0 * x * x - 3.0 * x + 1.0);
+        }
+        SplineTable table(grid, function);
+
+        /*! \class SplineTable
+         *  \test \b SplineTableTest_parabola tests that the interpolation table is exact for a parabola
+         */
+        WHEN("the parabola is evaluated inside and outside the grid")
+        {
+            THEN("the table is exact")
+            {
+                double points[] = {0.5, 1.0, 1.05, 2.7, 17.3, 39.1, 40.0};
+                for (int i = 0; i < 7; ++i) {
+                    double x = points[i];
+                    CAPTURE(x);
+                    REQUIRE(table(x) == Approx(2.0 * x * x - 3.0 * x + 1.0).epsilon(1.0e-12));
+                }
+            }
+        }
+    }
+}
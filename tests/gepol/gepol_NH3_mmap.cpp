@@ -0,0 +1,82 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *     
+ *     This file is part of PCMSolver.
+ *     
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *     
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *     
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *     
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include <catch.hpp>
+
+#include <string>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "GePolCavity.hpp"
+#include "Molecule.hpp"
+#include "PhysicalConstants.hpp"
+#include "TestingMolecules.hpp"
+#include "cnpy.hpp"
+
+TEST_CASE("Save and memory-map a GePol cavity for an ammonia molecule", "[gepol][gepol_NH3_mmap]")
+{
+    Molecule molec = NH3();
+    double area = 0.3 / convertBohr2ToAngstrom2;
+    double probeRadius = 1.385 / convertBohrToAngstrom;
+    double minRadius = 0.2 / convertBohrToAngstrom;
+    GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius, "mmap");
+    cavity.saveCavity("nh3_mmap.npz");
+
+    /*! \class GePolCavity
+     *  \test \b GePolCavityNH3MmapTest_alignment tests that the arrays saved in a .npz file can be used in place
+     */
+    SECTION("Test alignment of the arrays in the memory-mapped file")
+    {
+        cnpy::npz_mmap_t mapped("nh3_mmap.npz");
+        cnpy::npz_t loaded = cnpy::npz_load("nh3_mmap.npz");
+        REQUIRE(mapped.size() == loaded.size());
+        for (cnpy::npz_t::iterator it = loaded.begin(); it != loaded.end(); ++it) {
+            const cnpy::NpyArray & array = mapped[it->first];
+            REQUIRE(reinterpret_cast<size_t>(array.data) % 16 == 0);
+            REQUIRE(array.shape == it->second.shape);
+            size_t nbytes = it->second.word_size;
+            for (size_t i = 0; i < it->second.shape.size(); ++i) nbytes *= it->second.shape[i];
+            REQUIRE(std::string(array.data, nbytes) == std::string(it->second.data, nbytes));
+        }
+        loaded.destruct();
+    }
+
+    /*! \class GePolCavity
+     *  \test \b GePolCavityNH3MmapTest_restart tests that the cavity is restarted exactly from the memory-mapped file
+     */
+    SECTION("Test restart from the memory-mapped file")
+    {
+        GePolCavity restarted;
+        restarted.loadCavity("nh3_mmap.npz");
+        REQUIRE(restarted.size() == cavity.size());
+        REQUIRE(restarted.elementArea() == cavity.elementArea());
+        REQUIRE(restarted.elementRadius() == cavity.elementRadius());
+        REQUIRE(restarted.elementCenter() == cavity.elementCenter());
+        REQUIRE(restarted.elementNormal() == cavity.elementNormal());
+        REQUIRE(restarted.elementSphereCenter() == cavity.elementSphereCenter());
+    }
+}
@@ -295,5 +295,39 @@ SCENARIO("Evaluation of the anisotropic liquid Green's function and its derivati
                }
                */
         }
+
+        /*! \class AnisotropicLiquid
+         *  \test \b AnisotropicLiquidTest_analytic tests the evaluation with closed-form derivatives
+         *  of the AnisotropicLiquid Green's function against analytical result and automatic differentiation
+         */
+        WHEN("the derivatives are evaluated in closed form")
+        {
+            AnisotropicLiquid<Analytic, CollocationIntegrator> gf(epsilon, euler);
+            AnisotropicLiquid<AD_directional, CollocationIntegrator> gf_AD(epsilon, euler);
+            THEN("the value of the Green's function is")
+            {
+                double value = result(0);
+                double gf_value = gf.kernelS(source, probe);
+                REQUIRE(value == Approx(gf_value));
+            }
+            AND_THEN("the value of the Green's function directional derivative wrt the probe point is")
+            {
+                double derProbe = result(1);
+                double gf_derProbe = gf.derivativeProbe(probeNormal, source, probe);
+                REQUIRE(derProbe == Approx(gf_derProbe));
+                REQUIRE(gf_AD.derivativeProbe(probeNormal, source, probe) == Approx(gf_derProbe));
+            }
+            AND_THEN("the value of the Green's function directional derivative wrt the source point is")
+            {
+                double derSource = result(2);
+                double gf_derSource = gf.derivativeSource(sourceNormal, source, probe);
+                REQUIRE(derSource == Approx(gf_derSource));
+                REQUIRE(gf_AD.derivativeSource(sourceNormal, source, probe) == Approx(gf_derSource));
+            }
+            AND_THEN("the kernel of the D operator is the same as with automatic differentiation")
+            {
+                REQUIRE(gf_AD.kernelD(probeNormal, source, probe) == Approx(gf.kernelD(probeNormal, source, probe)));
+            }
+        }
     }
 }
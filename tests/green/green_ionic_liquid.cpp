@@ -132,4 +132,29 @@ TEST_CASE("Evaluation of the ionic liquid Green's function and its derivatives",
             REQUIRE(hessian == Approx(gf_hessian));
             */
     }
+
+    /*! \class IonicLiquid
+     *  \test \b IonicLiquidTest_analytic tests the evaluation with closed-form derivatives
+     *  of the IonicLiquid Green's function against analytical result and automatic differentiation
+     */
+    SECTION("Closed-form derivatives")
+    {
+        IonicLiquid<Analytic, CollocationIntegrator> gf(epsilon, kappa);
+        IonicLiquid<AD_directional, CollocationIntegrator> gf_AD(epsilon, kappa);
+        double value = result(0);
+        double gf_value = gf.kernelS(source, probe);
+        REQUIRE(value == Approx(gf_value));
+
+        double derProbe = result(1);
+        double gf_derProbe = gf.derivativeProbe(probeNormal, source, probe);
+        REQUIRE(derProbe == Approx(gf_derProbe));
+        REQUIRE(gf_AD.derivativeProbe(probeNormal, source, probe) == Approx(gf_derProbe));
+
+        double derSource = result(2);
+        double gf_derSource = gf.derivativeSource(sourceNormal, source, probe);
+        REQUIRE(derSource == Approx(gf_derSource));
+        REQUIRE(gf_AD.derivativeSource(sourceNormal, source, probe) == Approx(gf_derSource));
+
+        REQUIRE(gf_AD.kernelD(probeNormal, source, probe) == Approx(gf.kernelD(probeNormal, source, probe)));
+    }
 }
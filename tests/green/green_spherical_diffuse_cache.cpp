@@ -0,0 +1,102 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *     
+ *     This file is part of PCMSolver.
+ *     
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *     
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *     
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *     
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <iomanip>
+#include <limits>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "SphericalDiffuse.hpp"
+#include "OneLayerTanh.hpp"
+
+SCENARIO("Reuse of the radial solutions of the spherical diffuse Green's function", "[green][green_spherical_diffuse_cache]")
+{
+    GIVEN("A permittivity profile modelled by the hyperbolic tangent function")
+    {
+        int maxL = 3;
+        double eps1 = 80.0;
+        double eps2 = 2.0;
+        double sphereRadius = 100.0;
+        double width = 5.0;
+        Eigen::Vector3d source = (Eigen::Vector3d() << 1.0, 0.0, 0.0).finished();
+        Eigen::Vector3d probe = (Eigen::Vector3d() << 2.0, 0.0, 0.0).finished();
+        Eigen::Vector3d probeNormal = probe.normalized();
+        typedef SphericalDiffuse<CollocationIntegrator, OneLayerTanh> Diffuse;
+        interfaces::RadialCache<OneLayerTanh> & cache = interfaces::RadialCache<OneLayerTanh>::instance();
+        // The cache is process-wide: other Green's functions may have been constructed before
+        Diffuse::clearRadialCache();
+        Diffuse gf(eps1, eps2, width, sphereRadius, Eigen::Vector3d::Zero(), maxL);
+        int hits = cache.hits();
+        WHEN("a second Green's function with the same profile is constructed")
+        {
+            Diffuse other(eps1, eps2, width, sphereRadius, Eigen::Vector3d::Zero(), maxL);
+            THEN("the radial solutions are reused and the values coincide")
+            {
+                REQUIRE(cache.hits() == hits + 1);
+                REQUIRE(cache.size() == 1);
+                double value = gf.kernelS(source, probe);
+                double other_value = other.kernelS(source, probe);
+                INFO("value       = " << std::setprecision(std::numeric_limits<long double>::digits10) << value);
+                INFO("other_value = " << std::setprecision(std::numeric_limits<long double>::digits10) << other_value);
+                REQUIRE(value == Approx(other_value).epsilon(1.0e-14));
+                double derivative = gf.kernelD(probeNormal, source, probe);
+                double other_derivative = other.kernelD(probeNormal, source, probe);
+                REQUIRE(derivative == Approx(other_derivative).epsilon(1.0e-14));
+            }
+        }
+        AND_WHEN("a second Green's function with a different profile is constructed")
+        {
+            Diffuse other(eps1, 10.0, width, sphereRadius, Eigen::Vector3d::Zero(), maxL);
+            THEN("the radial solutions are not reused")
+            {
+                REQUIRE(cache.hits() == hits);
+                REQUIRE(cache.size() == 2);
+                // Evaluation outside the sphere, where the permittivity differs
+                Eigen::Vector3d outsideSource = (Eigen::Vector3d() << 150.0, 150.0, 150.0).finished();
+                Eigen::Vector3d outsideProbe = (Eigen::Vector3d() << 151.0, 150.0, 150.0).finished();
+                double value = gf.kernelS(outsideSource, outsideProbe);
+                double other_value = other.kernelS(outsideSource, outsideProbe);
+                INFO("value       = " << std::setprecision(std::numeric_limits<long double>::digits10) << value);
+                INFO("other_value = " << std::setprecision(std::numeric_limits<long double>::digits10) << other_value);
+                REQUIRE(value != Approx(other_value).epsilon(1.0e-06));
+            }
+        }
+        AND_WHEN("the cache is cleared")
+        {
+            Diffuse::clearRadialCache();
+            Diffuse other(eps1, eps2, width, sphereRadius, Eigen::Vector3d::Zero(), maxL);
+            THEN("the radial solutions are computed anew")
+            {
+                REQUIRE(cache.hits() == hits);
+                REQUIRE(cache.size() == 1);
+            }
+        }
+    }
+}
@@ -130,4 +130,29 @@ TEST_CASE("Evaluation of the uniform dielectric Green's function and its derivat
             REQUIRE(hessian == Approx(gf_hessian));
             */
     }
+
+    /*! \class UniformDielectric
+     *  \test \b UniformDielectricTest_analytic tests the evaluation with closed-form derivatives
+     *  of the UniformDielectric Green's function against analytical result and automatic differentiation
+     */
+    SECTION("Closed-form derivatives")
+    {
+        UniformDielectric<Analytic, CollocationIntegrator> gf(epsilon);
+        UniformDielectric<AD_directional, CollocationIntegrator> gf_AD(epsilon);
+        double value = result(0);
+        double gf_value = gf.kernelS(source, probe);
+        REQUIRE(value == Approx(gf_value));
+
+        double derProbe = result(1);
+        double gf_derProbe = gf.derivativeProbe(probeNormal, source, probe);
+        REQUIRE(derProbe == Approx(gf_derProbe));
+        REQUIRE(gf_AD.derivativeProbe(probeNormal, source, probe) == Approx(gf_derProbe));
+
+        double derSource = result(2);
+        double gf_derSource = gf.derivativeSource(sourceNormal, source, probe);
+        REQUIRE(derSource == Approx(gf_derSource));
+        REQUIRE(gf_AD.derivativeSource(sourceNormal, source, probe) == Approx(gf_derSource));
+
+        REQUIRE(gf_AD.kernelD(probeNormal, source, probe) == Approx(gf.kernelD(probeNormal, source, probe)));
+    }
 }
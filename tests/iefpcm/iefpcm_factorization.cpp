@@ -0,0 +1,213 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "MathUtils.hpp"
+#include "Molecule.hpp"
+#include "Vacuum.hpp"
+#include "TestingMolecules.hpp"
+#include "UniformDielectric.hpp"
+#include "SolverImpl.hpp"
+
+/*! \class IEFSolver
+ *  \test \b factorization tests the factorization-based build of the IEFPCM matrix
+ *  The PCM matrix obtained by LU/Cholesky solves against multiple right-hand sides
+ *  is compared to the one obtained by explicit inversion of T and SI.
+ */
+SCENARIO("Factorization-based build of the IEFPCM matrix for NH3 and a GePol cavity", "[solver][iefpcm][iefpcm_factorization]")
+{
+    GIVEN("The NH3 molecule in an isotropic environment")
+    {
+        Molecule molec = NH3();
+        double area = 0.4;
+        double probeRadius = 0.0;
+        double minRadius = 100.0;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius);
+
+        double permittivity = 78.39;
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+
+        Eigen::VectorXd fake_mep = computeMEP(molec, cavity.elements());
+        double totalASC = - 10.0 * (permittivity - 1) / permittivity;
+
+        WHEN("the isotropic IEFPCM matrix is built")
+        {
+            Eigen::MatrixXd K = isotropicIEFMatrix(cavity, gfInside, permittivity);
+            Eigen::MatrixXd T = isotropicTEpsilon(cavity, gfInside, permittivity);
+            Eigen::MatrixXd R = isotropicRinfinity(cavity, gfInside);
+            Eigen::MatrixXd K_ref = Eigen::FullPivLU<Eigen::MatrixXd>(T).inverse() * R;
+            THEN("it matches the one obtained by explicit inversion and gives the correct total apparent surface charge")
+            {
+                double relativeError = (K - K_ref).norm() / K_ref.norm();
+                CAPTURE(relativeError);
+                REQUIRE(relativeError < 1.0e-10);
+                double totalFakeASC = - (K * fake_mep).sum();
+                CAPTURE(totalASC - totalFakeASC);
+                REQUIRE(totalASC == Approx(totalFakeASC).epsilon(1.0e-03));
+            }
+        }
+
+        WHEN("the anisotropic IEFPCM matrix is built")
+        {
+            Eigen::MatrixXd K = anisotropicIEFMatrix(cavity, gfInside, gfOutside);
+            Eigen::MatrixXd T = anisotropicTEpsilon(cavity, gfInside, gfOutside);
+            Eigen::MatrixXd R = anisotropicRinfinity(cavity, gfInside, gfOutside);
+            Eigen::MatrixXd K_ref = Eigen::FullPivLU<Eigen::MatrixXd>(T).inverse() * R;
+            THEN("it matches the one obtained by explicit inversion and gives the correct total apparent surface charge")
+            {
+                double relativeError = (K - K_ref).norm() / K_ref.norm();
+                CAPTURE(relativeError);
+                REQUIRE(relativeError < 1.0e-10);
+                double totalFakeASC = - (K * fake_mep).sum();
+                CAPTURE(totalASC - totalFakeASC);
+                REQUIRE(totalASC == Approx(totalFakeASC).epsilon(1.0e-03));
+            }
+        }
+    }
+}
+
+/*! \class IEFSolver
+ *  \test \b blockFactorization tests the per-irrep build of the IEFPCM and CPCM matrices
+ *  The blocks obtained by factorizing each irreducible representation separately
+ *  are compared to the packed PCM matrix obtained by factorizing the symmetry blocked matrices.
+ */
+SCENARIO("Per-irrep build of the PCM matrices for C2H4 in D2h symmetry", "[solver][iefpcm][iefpcm_factorization]")
+{
+    GIVEN("The C2H4 molecule in an isotropic environment and a GePol cavity in D2h symmetry")
+    {
+        Molecule molec = C2H4();
+        double area = 0.2 / convertBohr2ToAngstrom2;
+        double probeRadius = 1.385 / convertBohrToAngstrom;
+        double minRadius = 100.0 / convertBohrToAngstrom;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius, "block_factorization");
+        int nrBlocks = cavity.pointGroup().nrIrrep();
+        int dimBlock = cavity.irreducible_size();
+
+        double permittivity = 78.39;
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+
+        WHEN("the isotropic IEFPCM matrix is built one irreducible representation at a time")
+        {
+            std::vector<Eigen::MatrixXd> K = isotropicIEFBlocks(cavity, gfInside, permittivity);
+            std::vector<Eigen::MatrixXd> K_ref;
+            symmetryPacking(K_ref, isotropicIEFMatrix(cavity, gfInside, permittivity), dimBlock, nrBlocks);
+            THEN("the blocks match those of the packed PCM matrix")
+            {
+                REQUIRE(K.size() == static_cast<size_t>(nrBlocks));
+                for (int i = 0; i < nrBlocks; ++i) {
+                    CAPTURE(i);
+                    REQUIRE(K[i].isApprox(K_ref[i], 1.0e-10));
+                }
+            }
+        }
+
+        WHEN("the anisotropic IEFPCM matrix is built one irreducible representation at a time")
+        {
+            std::vector<Eigen::MatrixXd> K = anisotropicIEFBlocks(cavity, gfInside, gfOutside);
+            std::vector<Eigen::MatrixXd> K_ref;
+            symmetryPacking(K_ref, anisotropicIEFMatrix(cavity, gfInside, gfOutside), dimBlock, nrBlocks);
+            THEN("the blocks match those of the packed PCM matrix")
+            {
+                REQUIRE(K.size() == static_cast<size_t>(nrBlocks));
+                for (int i = 0; i < nrBlocks; ++i) {
+                    CAPTURE(i);
+                    REQUIRE(K[i].isApprox(K_ref[i], 1.0e-10));
+                }
+            }
+        }
+
+        WHEN("the CPCM matrix is built one irreducible representation at a time")
+        {
+            double correction = 0.5;
+            std::vector<Eigen::MatrixXd> K = CPCMBlocks(cavity, gfInside, permittivity, correction);
+            std::vector<Eigen::MatrixXd> K_ref;
+            symmetryPacking(K_ref, CPCMMatrix(cavity, gfInside, permittivity, correction), dimBlock, nrBlocks);
+            THEN("the blocks match those of the packed PCM matrix")
+            {
+                REQUIRE(K.size() == static_cast<size_t>(nrBlocks));
+                for (int i = 0; i < nrBlocks; ++i) {
+                    CAPTURE(i);
+                    REQUIRE(K[i].isApprox(K_ref[i], 1.0e-10));
+                }
+            }
+        }
+    }
+}
+
+/*! \class IEFSolver
+ *  \test \b inPlaceSolve tests the in place solution of the single layer systems
+ *  The solution overwriting the right-hand sides is compared to the one obtained
+ *  with a separate solution matrix, for symmetric and nonsymmetric operators.
+ */
+SCENARIO("In place solution of the single layer systems", "[solver][iefpcm][iefpcm_factorization]")
+{
+    GIVEN("A diagonally dominant operator and a set of right-hand sides")
+    {
+        int dim = 50;
+        Eigen::MatrixXd S = Eigen::MatrixXd::Random(dim, dim) + dim * Eigen::MatrixXd::Identity(dim, dim);
+        Eigen::MatrixXd B = Eigen::MatrixXd::Random(dim, dim);
+
+        WHEN("the operator is symmetric")
+        {
+            S = (S + S.transpose()).eval();
+            Eigen::MatrixXd X_ref = singleLayerSolve(S, B);
+            Eigen::MatrixXd X = B;
+            singleLayerSolveInPlace(S, X);
+            THEN("the solutions match and the operator is released")
+            {
+                REQUIRE(X.isApprox(X_ref, 1.0e-12));
+                REQUIRE(S.size() == 0);
+            }
+        }
+
+        WHEN("the operator is not symmetric")
+        {
+            Eigen::MatrixXd X_ref = S.fullPivLu().solve(B);
+            Eigen::MatrixXd X = B;
+            singleLayerSolveInPlace(S, X);
+            THEN("the solutions match and the operator is released")
+            {
+                REQUIRE(X.isApprox(X_ref, 1.0e-12));
+                REQUIRE(S.size() == 0);
+            }
+        }
+    }
+}
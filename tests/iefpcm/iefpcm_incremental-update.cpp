@@ -0,0 +1,125 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "PurisimaIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "Vacuum.hpp"
+#include "UniformDielectric.hpp"
+#include "IEFSolver.hpp"
+#include "OperatorCache.hpp"
+#include "SolverImpl.hpp"
+#include "Sphere.hpp"
+
+namespace
+{
+    /*! A chain of four spheres, the last one displaced along the chain */
+    GePolCavity chainCavity(double displacement)
+    {
+        std::vector<Sphere> spheres;
+        for (int i = 0; i < 4; ++i) {
+            double x = 2.5 * i + ((i == 3) ? displacement : 0.0);
+            spheres.push_back(Sphere(Eigen::Vector3d(x, 0.0, 0.0), 2.0));
+        }
+        return GePolCavity(spheres, 0.3, 0.0, 100.0);
+    }
+}
+
+SCENARIO("Test the incremental update of the operators along a geometry step", "[solver][iefpcm][iefpcm_incremental-update]")
+{
+    GIVEN("A chain of spheres and the same chain with the last sphere displaced")
+    {
+        GePolCavity before = chainCavity(0.0);
+        GePolCavity after = chainCavity(0.2);
+
+        WHEN("the operators for a collocation Green's function are updated")
+        {
+            Vacuum<AD_directional, CollocationIntegrator> gf = Vacuum<AD_directional, CollocationIntegrator>();
+            OperatorCache operators(true);
+            operators.singleLayerBlocks(before, gf);
+            operators.doubleLayerBlocks(before, gf);
+            Eigen::MatrixXd S = operators.singleLayerBlocks(after, gf)[0];
+            Eigen::MatrixXd D = operators.doubleLayerBlocks(after, gf)[0];
+            Eigen::MatrixXd S_ref = singleLayerBlocks(after, gf)[0];
+            Eigen::MatrixXd D_ref = doubleLayerBlocks(after, gf)[0];
+            THEN("only the rows and columns of the changed tesserae are computed")
+            {
+                REQUIRE(operators.misses() == 2);
+                REQUIRE(operators.updates() == 2);
+                REQUIRE(S.rows() == S_ref.rows());
+                REQUIRE(D.rows() == D_ref.rows());
+                REQUIRE((S - S_ref).norm() <= 1.0e-12 * S_ref.norm());
+                REQUIRE((D - D_ref).norm() <= 1.0e-12 * D_ref.norm());
+            }
+        }
+
+        AND_WHEN("an IEFPCM solver is built with the updated operators")
+        {
+            Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+            UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+                UniformDielectric<AD_directional, CollocationIntegrator>(78.39);
+            OperatorCache operators(true);
+            IEFSolver first(false);
+            first.buildSystemMatrix(before, gfInside, gfOutside, operators);
+            IEFSolver solver(false);
+            solver.buildSystemMatrix(after, gfInside, gfOutside, operators);
+            IEFSolver reference(false);
+            reference.buildSystemMatrix(after, gfInside, gfOutside);
+            THEN("the charges are those of a solver built from scratch")
+            {
+                REQUIRE(operators.updates() == 2);
+                Eigen::VectorXd mep = Eigen::VectorXd::Ones(after.size());
+                Eigen::VectorXd asc = solver.computeCharge(mep);
+                Eigen::VectorXd refASC = reference.computeCharge(mep);
+                REQUIRE((asc - refASC).norm() <= 1.0e-10 * refASC.norm());
+            }
+        }
+
+        AND_WHEN("the diagonal of the double layer operator depends on all the tesserae")
+        {
+            Vacuum<AD_directional, PurisimaIntegrator> gf = Vacuum<AD_directional, PurisimaIntegrator>();
+            OperatorCache operators(true);
+            operators.singleLayerBlocks(before, gf);
+            operators.doubleLayerBlocks(before, gf);
+            Eigen::MatrixXd D = operators.doubleLayerBlocks(after, gf)[0];
+            Eigen::MatrixXd D_ref = doubleLayerBlocks(after, gf)[0];
+            THEN("the double layer operator is computed anew")
+            {
+                REQUIRE(operators.misses() == 3);
+                REQUIRE(operators.updates() == 0);
+                REQUIRE((D - D_ref).norm() == 0.0);
+            }
+        }
+    }
+}
@@ -0,0 +1,178 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "Vacuum.hpp"
+#include "UniformDielectric.hpp"
+#include "IEFSolver.hpp"
+#include "MatrixCache.hpp"
+#include "TestingMolecules.hpp"
+
+/*! \brief Temporary cache directory, removed together with its files on scope exit */
+struct TemporaryDirectory
+{
+    TemporaryDirectory() {
+        char name[] = "PCMMatrixCache_XXXXXX";
+        REQUIRE(mkdtemp(name) != NULL);
+        path = name;
+    }
+    ~TemporaryDirectory() {
+        DIR * dir = opendir(path.c_str());
+        if (dir) {
+            for (struct dirent * entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+                std::string file(entry->d_name);
+                if (file != "." && file != "..") std::remove((path + "/" + file).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    }
+    std::string path;
+};
+
+SCENARIO("Test the on-disk cache of the PCM matrix", "[solver][iefpcm][iefpcm_matrix-cache]")
+{
+    GIVEN("An isotropic environment, a GePol cavity and a cache directory")
+    {
+        double permittivity = 78.39;
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+        bool symm = true;
+        TemporaryDirectory directory;
+        std::string cache(directory.path);
+
+        Molecule molec = NH3();
+        double area = 0.4;
+        double probeRadius = 1.385;
+        double minRadius = 0.2;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius);
+        Eigen::VectorXd fake_mep = computeMEP(molec, cavity.elements());
+
+        IEFSolver reference(symm);
+        reference.buildSystemMatrix(cavity, gfInside, gfOutside);
+        Eigen::VectorXd ref_asc = reference.computeCharge(fake_mep);
+
+        WHEN("the PCM matrix is built twice with the same cavity and medium")
+        {
+            IEFSolver first(symm, cache);
+            first.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IEFSolver second(symm, cache);
+            second.buildSystemMatrix(cavity, gfInside, gfOutside);
+            THEN("the cache file is written and the second PCM matrix is loaded from it")
+            {
+                REQUIRE(!first.loadedFromCache());
+                REQUIRE(second.loadedFromCache());
+                REQUIRE(second.cacheFile() == first.cacheFile());
+                std::ifstream file(first.cacheFile().c_str());
+                REQUIRE(file.good());
+                Eigen::VectorXd first_asc = first.computeCharge(fake_mep);
+                Eigen::VectorXd second_asc = second.computeCharge(fake_mep);
+                for (int i = 0; i < fake_mep.size(); ++i) {
+                    REQUIRE(first_asc(i) == Approx(ref_asc(i)));
+                    REQUIRE(second_asc(i) == first_asc(i));
+                }
+            }
+        }
+        AND_WHEN("the PCM matrix is built twice retaining the spectral representation")
+        {
+            IEFSolver plain(symm, cache);
+            plain.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IEFSolver first(symm, cache, true);
+            first.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IEFSolver second(symm, cache, true);
+            second.buildSystemMatrix(cavity, gfInside, gfOutside);
+            double other = 2.0;
+            UniformDielectric<AD_directional, CollocationIntegrator> gfOther =
+                UniformDielectric<AD_directional, CollocationIntegrator>(other);
+            IEFSolver updateReference(symm);
+            updateReference.buildSystemMatrix(cavity, gfInside, gfOther);
+            THEN("the spectral representation is saved and loaded with the PCM matrix")
+            {
+                // The cache file saved without the spectral representation is a miss
+                REQUIRE(!first.loadedFromCache());
+                REQUIRE(second.loadedFromCache());
+                second.updatePermittivity(other);
+                Eigen::VectorXd updated_asc = second.computeCharge(fake_mep);
+                Eigen::VectorXd other_asc = updateReference.computeCharge(fake_mep);
+                REQUIRE(updated_asc.isApprox(other_asc, 1.0e-10));
+            }
+        }
+        AND_WHEN("the medium or the solver options are changed")
+        {
+            UniformDielectric<AD_directional, CollocationIntegrator> gfOther =
+                UniformDielectric<AD_directional, CollocationIntegrator>(2.0);
+            IEFSolver first(symm, cache);
+            first.buildSystemMatrix(cavity, gfInside, gfOutside);
+            IEFSolver otherMedium(symm, cache);
+            otherMedium.buildSystemMatrix(cavity, gfInside, gfOther);
+            IEFSolver otherOptions(!symm, cache);
+            otherOptions.buildSystemMatrix(cavity, gfInside, gfOutside);
+            THEN("the fingerprint changes and the cached PCM matrix is not reused")
+            {
+                REQUIRE(!otherMedium.loadedFromCache());
+                REQUIRE(otherMedium.cacheFile() != first.cacheFile());
+                REQUIRE(!otherOptions.loadedFromCache());
+                REQUIRE(otherOptions.cacheFile() != first.cacheFile());
+            }
+        }
+        AND_WHEN("the cache file does not match the PCM matrix")
+        {
+            std::string fingerprint = PCMMatrixFingerprint(cavity, gfInside, gfOutside, "options");
+            std::string mismatch = cache + "/mismatch.npz";
+            THEN("the cached PCM matrix is not loaded")
+            {
+                std::vector<Eigen::MatrixXd> blocks;
+                savePCMMatrix(mismatch, fingerprint, std::vector<Eigen::MatrixXd>(1,
+                            Eigen::MatrixXd::Identity(cavity.size(), cavity.size())));
+                REQUIRE(loadPCMMatrix(mismatch, fingerprint, 1, cavity.size(), blocks));
+                REQUIRE(blocks.size() == 1);
+                REQUIRE(!loadPCMMatrix(mismatch, "0123456789abcdef", 1, cavity.size(), blocks));
+                REQUIRE(!loadPCMMatrix(mismatch, fingerprint, 1, cavity.size() - 1, blocks));
+                REQUIRE(!loadPCMMatrix(cache + "/missing.npz", fingerprint, 1, cavity.size(), blocks));
+                std::vector<Eigen::MatrixXcd> left, right;
+                std::vector<Eigen::VectorXcd> eigenvalues;
+                REQUIRE(!loadPCMSpectra(mismatch, fingerprint, 1, cavity.size(), left, right, eigenvalues));
+            }
+        }
+    }
+}
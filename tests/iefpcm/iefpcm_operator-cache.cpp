@@ -0,0 +1,122 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "MatrixCache.hpp"
+#include "NumericalIntegrator.hpp"
+#include "Vacuum.hpp"
+#include "UniformDielectric.hpp"
+#include "CPCMSolver.hpp"
+#include "IEFSolver.hpp"
+#include "OperatorCache.hpp"
+#include "TestingMolecules.hpp"
+
+SCENARIO("Test the operators shared by the static and dynamic solvers", "[solver][iefpcm][iefpcm_operator-cache]")
+{
+    GIVEN("The static and dynamic isotropic environments and a GePol cavity")
+    {
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfStatic =
+            UniformDielectric<AD_directional, CollocationIntegrator>(78.39);
+        UniformDielectric<AD_directional, CollocationIntegrator> gfDynamic =
+            UniformDielectric<AD_directional, CollocationIntegrator>(1.776);
+        bool symm = true;
+
+        Molecule molec = NH3();
+        double area = 0.4;
+        double probeRadius = 1.385;
+        double minRadius = 0.2;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius);
+        Eigen::VectorXd fake_mep = computeMEP(molec, cavity.elements());
+
+        WHEN("the static and dynamic IEFPCM solvers are built with the same cache")
+        {
+            OperatorCache operators;
+            IEFSolver staticSolver(symm), dynamicSolver(symm);
+            staticSolver.buildSystemMatrix(cavity, gfInside, gfStatic, operators);
+            dynamicSolver.buildSystemMatrix(cavity, gfInside, gfDynamic, operators);
+            IEFSolver staticRef(symm), dynamicRef(symm);
+            staticRef.buildSystemMatrix(cavity, gfInside, gfStatic);
+            dynamicRef.buildSystemMatrix(cavity, gfInside, gfDynamic);
+            THEN("the inside operators are computed once and the charges are unchanged")
+            {
+                REQUIRE(operators.misses() == 2);
+                REQUIRE(operators.hits() == 2);
+                Eigen::VectorXd staticASC = staticSolver.computeCharge(fake_mep);
+                Eigen::VectorXd staticRefASC = staticRef.computeCharge(fake_mep);
+                Eigen::VectorXd dynamicASC = dynamicSolver.computeCharge(fake_mep);
+                Eigen::VectorXd dynamicRefASC = dynamicRef.computeCharge(fake_mep);
+                for (int i = 0; i < fake_mep.size(); ++i) {
+                    REQUIRE(staticASC(i) == staticRefASC(i));
+                    REQUIRE(dynamicASC(i) == dynamicRefASC(i));
+                }
+            }
+        }
+
+        AND_WHEN("an IEFPCM and a C-PCM solver are built with the same cache")
+        {
+            OperatorCache operators;
+            IEFSolver iefpcm(symm);
+            iefpcm.buildSystemMatrix(cavity, gfInside, gfStatic, operators);
+            CPCMSolver conductor(symm, 0.0);
+            conductor.buildSystemMatrix(cavity, gfInside, gfStatic, operators);
+            IEFSolver reference(symm);
+            reference.buildSystemMatrix(cavity, gfInside, gfStatic);
+            THEN("the single layer operator is shared and the charges are unchanged")
+            {
+                REQUIRE(operators.misses() == 2);
+                REQUIRE(operators.hits() == 1);
+                Eigen::VectorXd asc = iefpcm.computeCharge(fake_mep);
+                Eigen::VectorXd refASC = reference.computeCharge(fake_mep);
+                for (int i = 0; i < fake_mep.size(); ++i) {
+                    REQUIRE(asc(i) == refASC(i));
+                }
+            }
+        }
+
+        AND_WHEN("the inside operators are integrated numerically to different tolerances")
+        {
+            Vacuum<AD_directional, NumericalIntegrator> gfLoose(NumericalIntegrator(1.0e-4));
+            Vacuum<AD_directional, NumericalIntegrator> gfTight(NumericalIntegrator(1.0e-8));
+            OperatorCache operators;
+            operators.singleLayerBlocks(cavity, gfLoose);
+            operators.singleLayerBlocks(cavity, gfTight);
+            THEN("the Green's functions have different fingerprints and the operators are not shared")
+            {
+                REQUIRE(GreensFunctionFingerprint(gfLoose) != GreensFunctionFingerprint(gfTight));
+                REQUIRE(operators.misses() == 2);
+                REQUIRE(operators.hits() == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "PhysicalConstants.hpp"
+#include "Vacuum.hpp"
+#include "UniformDielectric.hpp"
+#include "CPCMSolver.hpp"
+#include "IEFSolver.hpp"
+#include "IterativeSolver.hpp"
+#include "TestingMolecules.hpp"
+
+/*! \class IEFSolver
+ *  \test \b permittivityUpdate tests the update of the isotropic solvers for a new permittivity
+ *  The charges obtained after the update are compared to those of a solver built from scratch.
+ */
+SCENARIO("Test the update of the isotropic solvers for a new permittivity", "[solver][iefpcm][iefpcm_permittivity-update]")
+{
+    GIVEN("Two isotropic environments and the C2H4 molecule with a GePol cavity in D2h symmetry")
+    {
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfWater =
+            UniformDielectric<AD_directional, CollocationIntegrator>(78.39);
+        double permittivity = 4.7113;
+        UniformDielectric<AD_directional, CollocationIntegrator> gfChloroform =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+
+        Molecule molec = C2H4();
+        double area = 0.2 / convertBohr2ToAngstrom2;
+        double probeRadius = 1.385 / convertBohrToAngstrom;
+        double minRadius = 100.0 / convertBohrToAngstrom;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius, "permittivity_update");
+        int nrBlocks = cavity.pointGroup().nrIrrep();
+        Eigen::MatrixXd potentials = Eigen::MatrixXd::Random(cavity.size(), 2);
+
+        WHEN("the IEFPCM solvers retaining the spectral representation are updated")
+        {
+            IEFSolver symmetric(true, "", true), nonsymmetric(false, "", true);
+            symmetric.buildSystemMatrix(cavity, gfInside, gfWater);
+            nonsymmetric.buildSystemMatrix(cavity, gfInside, gfWater);
+            symmetric.updatePermittivity(permittivity);
+            nonsymmetric.updatePermittivity(permittivity);
+            IEFSolver symmetricRef(true), nonsymmetricRef(false);
+            symmetricRef.buildSystemMatrix(cavity, gfInside, gfChloroform);
+            nonsymmetricRef.buildSystemMatrix(cavity, gfInside, gfChloroform);
+            THEN("the charges match those of the solvers built for the new permittivity")
+            {
+                for (int irrep = 0; irrep < nrBlocks; ++irrep) {
+                    CAPTURE(irrep);
+                    Eigen::MatrixXd charges = symmetric.computeCharges(potentials, irrep);
+                    Eigen::MatrixXd refCharges = symmetricRef.computeCharges(potentials, irrep);
+                    REQUIRE(charges.isApprox(refCharges, 1.0e-10));
+                    REQUIRE(symmetric.computeCharge(potentials.col(0), irrep).isApprox(refCharges.col(0), 1.0e-10));
+                    REQUIRE(nonsymmetric.computeCharges(potentials, irrep).isApprox(
+                                nonsymmetricRef.computeCharges(potentials, irrep), 1.0e-10));
+                }
+            }
+        }
+
+        AND_WHEN("the C-PCM solver is updated")
+        {
+            double correction = 0.5;
+            CPCMSolver solver(true, correction);
+            solver.buildSystemMatrix(cavity, gfInside, gfWater);
+            solver.updatePermittivity(permittivity);
+            CPCMSolver reference(true, correction);
+            reference.buildSystemMatrix(cavity, gfInside, gfChloroform);
+            THEN("the charges match those of a solver built for the new permittivity")
+            {
+                for (int irrep = 0; irrep < nrBlocks; ++irrep) {
+                    CAPTURE(irrep);
+                    REQUIRE(solver.computeCharges(potentials, irrep).isApprox(reference.computeCharges(potentials, irrep), 1.0e-12));
+                }
+            }
+        }
+
+        AND_WHEN("the matrix-free solver is updated")
+        {
+            IterativeSolver solver(false, 0.0, 1.0e-12, 200);
+            solver.buildSystemMatrix(cavity, gfInside, gfWater);
+            solver.updatePermittivity(permittivity);
+            IEFSolver reference(false);
+            reference.buildSystemMatrix(cavity, gfInside, gfChloroform);
+            THEN("the charges match those of the IEFPCM solver built for the new permittivity")
+            {
+                Eigen::VectorXd charge = solver.computeCharge(potentials.col(0));
+                Eigen::VectorXd refCharge = reference.computeCharge(potentials.col(0));
+                REQUIRE(charge.isApprox(refCharge, 1.0e-8));
+            }
+        }
+    }
+}
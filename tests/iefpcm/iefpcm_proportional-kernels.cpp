@@ -0,0 +1,129 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013-2015 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.readthedocs.org/>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+#include "CollocationIntegrator.hpp"
+#include "DerivativeTypes.hpp"
+#include "GePolCavity.hpp"
+#include "Molecule.hpp"
+#include "NumericalIntegrator.hpp"
+#include "ProfileTypes.hpp"
+#include "Vacuum.hpp"
+#include "TestingMolecules.hpp"
+#include "UniformDielectric.hpp"
+#include "SolverImpl.hpp"
+
+/*! \class IEFSolver
+ *  \test \b proportionalKernels tests the detection of proportional kernels for pairs of dielectric profiles
+ */
+SCENARIO("Ratio of the kernels of the S operator for pairs of dielectric profiles", "[solver][iefpcm][iefpcm_proportional-kernels]")
+{
+    GIVEN("Uniform, Yukawa and anisotropic profiles")
+    {
+        double permittivity = 78.39;
+        Eigen::Vector3d angles(10.0, 20.0, 30.0);
+        Uniform vacuum(1.0), water(permittivity);
+        Yukawa screened(permittivity, 0.1), unscreened(permittivity, 0.0);
+        Anisotropic isotropic(Eigen::Vector3d::Constant(permittivity), angles);
+        Anisotropic crystal(Eigen::Vector3d(2.0, 3.0, 4.0), angles);
+        Anisotropic scaledCrystal(Eigen::Vector3d(4.0, 6.0, 8.0), angles);
+        THEN("the ratio is the inverse of the scaling of the permittivity for proportional kernels")
+        {
+            REQUIRE(profiles::kernelRatio(vacuum, water) == Approx(1.0 / permittivity));
+            REQUIRE(profiles::kernelRatio(vacuum, unscreened) == Approx(1.0 / permittivity));
+            REQUIRE(profiles::kernelRatio(Yukawa(2.0, 0.1), screened) == Approx(2.0 / permittivity));
+            REQUIRE(profiles::kernelRatio(vacuum, isotropic) == Approx(1.0 / permittivity));
+            REQUIRE(profiles::kernelRatio(crystal, scaledCrystal) == Approx(0.5));
+        }
+        AND_THEN("the ratio is zero otherwise")
+        {
+            REQUIRE(profiles::kernelRatio(vacuum, screened) == 0.0);
+            REQUIRE(profiles::kernelRatio(unscreened, Yukawa(1.0, 0.2)) == 0.0);
+            REQUIRE(profiles::kernelRatio(vacuum, crystal) == 0.0);
+            REQUIRE(profiles::kernelRatio(screened, isotropic) == 0.0);
+        }
+    }
+}
+
+/*! \class IEFSolver
+ *  \test \b proportionalKernels tests the derivation of the operators outside the cavity from those inside
+ *  The anisotropic T and R matrices are compared to those obtained from the explicitly assembled operators.
+ */
+SCENARIO("Operators outside the cavity derived from those inside for NH3 and a GePol cavity", "[solver][iefpcm][iefpcm_proportional-kernels]")
+{
+    GIVEN("The NH3 molecule in a uniform dielectric")
+    {
+        Molecule molec = NH3();
+        double area = 0.4;
+        double probeRadius = 0.0;
+        double minRadius = 100.0;
+        GePolCavity cavity = GePolCavity(molec, area, probeRadius, minRadius);
+
+        double permittivity = 78.39;
+        Vacuum<AD_directional, CollocationIntegrator> gfInside = Vacuum<AD_directional, CollocationIntegrator>();
+        UniformDielectric<AD_directional, CollocationIntegrator> gfOutside =
+            UniformDielectric<AD_directional, CollocationIntegrator>(permittivity);
+
+        WHEN("the Green's functions share the integrator")
+        {
+            THEN("the operators are proportional")
+            {
+                REQUIRE(outsideOperatorsRatio(cavity, gfInside, gfOutside) == Approx(1.0 / permittivity));
+            }
+            AND_THEN("the T and R matrices match those from the assembled operators")
+            {
+                Eigen::MatrixXd SI = singleLayerBlocked(cavity, gfInside);
+                Eigen::MatrixXd DI = doubleLayerBlocked(cavity, gfInside) * cavity.elementArea().asDiagonal();
+                Eigen::MatrixXd SE = singleLayerBlocked(cavity, gfOutside);
+                Eigen::MatrixXd DE = doubleLayerBlocked(cavity, gfOutside) * cavity.elementArea().asDiagonal();
+                Eigen::MatrixXd Id = Eigen::MatrixXd::Identity(SI.rows(), SI.cols());
+                Eigen::MatrixXd T_ref = (2 * M_PI * Id - DE) * SI + SE * (2 * M_PI * Id + DI.adjoint());
+                Eigen::MatrixXd R_ref = (2 * M_PI * Id - DE) - SE * SI.inverse() * (2 * M_PI * Id - DI);
+                Eigen::MatrixXd T = anisotropicTEpsilon(cavity, gfInside, gfOutside);
+                Eigen::MatrixXd R = anisotropicRinfinity(cavity, gfInside, gfOutside);
+                REQUIRE(T.isApprox(T_ref, 1.0e-12));
+                REQUIRE(R.isApprox(R_ref, 1.0e-10));
+            }
+        }
+
+        WHEN("the Green's functions use different integrators")
+        {
+            UniformDielectric<AD_directional, NumericalIntegrator> gfNumerical =
+                UniformDielectric<AD_directional, NumericalIntegrator>(permittivity);
+            THEN("the operators are not proportional")
+            {
+                REQUIRE(outsideOperatorsRatio(cavity, gfInside, gfNumerical) == 0.0);
+            }
+        }
+    }
+}
@@ -0,0 +1,146 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.github.io/pcmsolver-doc>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "DerivativeTypes.hpp"
+#include "Element.hpp"
+#include "GePolCavity.hpp"
+#include "IntegratorHelperFunctions.hpp"
+#include "NumericalIntegrator.hpp"
+#include "TestingMolecules.hpp"
+#include "Vacuum.hpp"
+
+namespace {
+long kernelCalls = 0;
+
+double countingKernelS(const Eigen::Vector3d & s, const Eigen::Vector3d & p)
+{
+    ++kernelCalls;
+    return 1.0 / (s - p).norm();
+}
+
+double countingKernelD(const Eigen::Vector3d & n, const Eigen::Vector3d & s, const Eigen::Vector3d & p)
+{
+    ++kernelCalls;
+    Eigen::Vector3d d = s - p;
+    return n.dot(d) / std::pow(d.norm(), 3);
+}
+} // namespace
+
+/*! \class NumericalQuadrature
+ *  \test \b NumericalQuadrature_adaptive tests the adaptive integration of the diagonal elements
+ */
+SCENARIO("Adaptive integration of the diagonal elements", "[numerical_quadrature][numerical_quadrature_adaptive]")
+{
+    GIVEN("A GePol cavity for H2")
+    {
+        Molecule molec = H2();
+        GePolCavity cavity(molec, 0.4, 1.385, 0.2, "");
+        double tolerance = 1.0e-08;
+        integrator::KernelS kernelS = countingKernelS;
+        integrator::KernelD kernelD = countingKernelD;
+
+        WHEN("the diagonal of S is integrated adaptively")
+        {
+            long referenceCalls = 0, adaptiveCalls = 0;
+            double adaptiveError = 0.0, fixedError = 0.0;
+            for (size_t i = 0; i < cavity.size(); ++i) {
+                const Element & e = cavity.elements(i);
+                kernelCalls = 0;
+                double reference = integrator::integrateS<64, 32>(kernelS, e);
+                referenceCalls += kernelCalls;
+                kernelCalls = 0;
+                double adaptive = integrator::integrateSAdaptive(kernelS, e, tolerance);
+                adaptiveCalls += kernelCalls;
+                double fixed = integrator::integrateS<32, 16>(kernelS, e);
+                adaptiveError = std::max(adaptiveError, std::abs(adaptive - reference) / reference);
+                fixedError = std::max(fixedError, std::abs(fixed - reference) / reference);
+            }
+            THEN("the highest order rule is matched with fewer kernel evaluations")
+            {
+                REQUIRE(adaptiveError < 1.0e-10);
+                REQUIRE(adaptiveCalls < referenceCalls);
+            }
+            AND_THEN("the tesserae where the fixed rule fails are refined")
+            {
+                REQUIRE(fixedError > 1.0e-03);
+            }
+        }
+
+        WHEN("the diagonal of D is integrated adaptively")
+        {
+            long referenceCalls = 0, adaptiveCalls = 0;
+            double adaptiveError = 0.0;
+            for (size_t i = 0; i < cavity.size(); ++i) {
+                const Element & e = cavity.elements(i);
+                kernelCalls = 0;
+                double reference = integrator::integrateD<64, 32>(kernelD, e);
+                referenceCalls += kernelCalls;
+                kernelCalls = 0;
+                double adaptive = integrator::integrateDAdaptive(kernelD, e, tolerance);
+                adaptiveCalls += kernelCalls;
+                adaptiveError = std::max(adaptiveError, std::abs(adaptive - reference) / std::abs(reference));
+            }
+            THEN("the highest order rule is matched with fewer kernel evaluations")
+            {
+                REQUIRE(adaptiveError < 1.0e-08);
+                REQUIRE(adaptiveCalls < referenceCalls);
+            }
+        }
+
+        WHEN("the tolerance is passed to the numerical integrator of a Green's function")
+        {
+            typedef Vacuum<AD_directional, NumericalIntegrator> VacuumNumerical;
+            VacuumNumerical gf((NumericalIntegrator(tolerance)));
+            integrator::KernelS gfKernelS = pcm::bind(&VacuumNumerical::kernelS, gf, pcm::_1, pcm::_2);
+            integrator::KernelD gfKernelD = pcm::bind(&VacuumNumerical::kernelD, gf, pcm::_1, pcm::_2, pcm::_3);
+            std::vector<Element> elements = cavity.elements();
+            Eigen::MatrixXd S = gf.singleLayer(elements);
+            Eigen::MatrixXd D = gf.doubleLayer(elements);
+            THEN("the diagonal elements are integrated adaptively")
+            {
+                for (size_t i = 0; i < elements.size(); ++i) {
+                    REQUIRE(S(i, i) == Approx(integrator::integrateSAdaptive(gfKernelS, elements[i], tolerance) / elements[i].area()).epsilon(1.0e-12));
+                    REQUIRE(D(i, i) == Approx(integrator::integrateDAdaptive(gfKernelD, elements[i], tolerance) / elements[i].area()).epsilon(1.0e-12));
+                }
+            }
+            AND_THEN("the diagonal of D is minus the diagonal of S over twice the sphere radius")
+            {
+                for (size_t i = 0; i < elements.size(); ++i) {
+                    REQUIRE(D(i, i) == Approx(-S(i, i) / (2.0 * elements[i].sphere().radius())).epsilon(1.0e-10));
+                }
+            }
+        }
+    }
+}
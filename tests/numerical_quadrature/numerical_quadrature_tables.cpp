@@ -0,0 +1,122 @@
+/* pcmsolver_copyright_start */
+/*
+ *     PCMSolver, an API for the Polarizable Continuum Model
+ *     Copyright (C) 2013 Roberto Di Remigio, Luca Frediani and contributors
+ *
+ *     This file is part of PCMSolver.
+ *
+ *     PCMSolver is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License as published by
+ *     the Free Software Foundation, either version 3 of the License, or
+ *     (at your option) any later version.
+ *
+ *     PCMSolver is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU Lesser General Public License for more details.
+ *
+ *     You should have received a copy of the GNU Lesser General Public License
+ *     along with PCMSolver.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *     For information on the complete list of contributors to the
+ *     PCMSolver API, see: <http://pcmsolver.github.io/pcmsolver-doc>
+ */
+/* pcmsolver_copyright_end */
+
+#include "catch.hpp"
+
+#include <cmath>
+
+#include "Config.hpp"
+
+#include <Eigen/Core>
+
+#include "Element.hpp"
+#include "GePolCavity.hpp"
+#include "IntegratorHelperFunctions.hpp"
+#include "TestingMolecules.hpp"
+
+namespace {
+int tablesBuilt = 0;
+
+integrator::QuadratureTable countingTable(const Element & e)
+{
+    ++tablesBuilt;
+    return integrator::quadratureTable<16, 16>(e);
+}
+
+double inverseDistance(const Eigen::Vector3d & s, const Eigen::Vector3d & p)
+{
+    return 1.0 / (s - p + Eigen::Vector3d::Constant(2.0)).norm();
+}
+} // namespace
+
+/*! \class NumericalQuadrature
+ *  \test \b NumericalQuadrature_tables tests the cache of the quadrature tables of the finite elements
+ */
+SCENARIO("Quadrature tables of the finite elements", "[numerical_quadrature][numerical_quadrature_tables]")
+{
+    GIVEN("A GePol cavity for a single sphere")
+    {
+        Molecule point = dummy<0>(1.55);
+        GePolCavity cavity(point, 0.4, 0.0, 100.0, "");
+
+        WHEN("the quadrature tables are built")
+        {
+            integrator::QuadratureCache cache;
+            THEN("the weights add up to the finite element areas")
+            {
+                for (size_t i = 0; i < cavity.size(); ++i) {
+                    pcm::shared_ptr<const integrator::QuadratureTable> table = integrator::quadrature<32, 16>(cavity.elements(i), &cache);
+                    REQUIRE(table->points.cols() == table->weights.size());
+                    REQUIRE(table->weights.sum() == Approx(cavity.elementArea(i)));
+                }
+            }
+            AND_THEN("the integrals are the dot products of the weights with the integrand at the points")
+            {
+                for (size_t i = 0; i < cavity.size(); ++i) {
+                    const Element & e = cavity.elements(i);
+                    pcm::shared_ptr<const integrator::QuadratureTable> table = integrator::quadrature<32, 16>(e, &cache);
+                    double reference = 0.0;
+                    for (int k = 0; k < table->weights.size(); ++k) {
+                        reference += table->weights(k) * inverseDistance(table->points.col(k), Eigen::Vector3d::Zero());
+                    }
+                    double result = integrator::integrateS<32, 16>(pcm::bind(inverseDistance, pcm::_1, pcm::_2), e, &cache);
+                    REQUIRE(result == Approx(reference).epsilon(1.0e-14));
+                    double uncached = integrator::integrateS<32, 16>(pcm::bind(inverseDistance, pcm::_1, pcm::_2), e);
+                    REQUIRE(uncached == result);
+                }
+            }
+        }
+
+        WHEN("the table of a finite element and of its copy are requested")
+        {
+            integrator::QuadratureCache cache;
+            Element copy = cavity.elements(0);
+            tablesBuilt = 0;
+            pcm::shared_ptr<const integrator::QuadratureTable> copyTable = cache.table(16, 16, copy, countingTable);
+            pcm::shared_ptr<const integrator::QuadratureTable> table = cache.table(16, 16, cavity.elements(0), countingTable);
+            THEN("the table is built only once and released by clear")
+            {
+                REQUIRE(tablesBuilt == 1);
+                REQUIRE(copyTable == table);
+                REQUIRE(cache.size() == size_t(table->weights.size()));
+                cache.clear();
+                REQUIRE(cache.size() == 0);
+            }
+        }
+
+        WHEN("the cache is full")
+        {
+            integrator::QuadratureCache cache(0);
+            tablesBuilt = 0;
+            cache.table(16, 16, cavity.elements(0), countingTable);
+            cache.table(16, 16, cavity.elements(0), countingTable);
+            THEN("the tables are built on each use and not held")
+            {
+                REQUIRE(tablesBuilt == 2);
+                REQUIRE(cache.size() == 0);
+            }
+        }
+    }
+}